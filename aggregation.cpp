@@ -0,0 +1,197 @@
+#include "aggregation.h"
+
+using namespace aggregation;
+
+namespace {
+
+/**
+ * @brief window_start
+ * floor to the multiple of the width (also for negative ticks)
+ */
+inline long long window_start(long long tick, long long width)
+{
+	long long r = tick % width;
+	return r < 0? tick - r - width : tick - r;
+}
+
+}
+
+////////////////////////////////////////////////
+
+void aggregation::values(const sc::StructTelemetry &telemetry, float out[])
+{
+	out[Tangaj] = telemetry.tangaj;
+	out[Bank] = telemetry.bank;
+	out[Course] = telemetry.course;
+	out[Height] = telemetry.height;
+	FOREACH(i, sc::cnt_engines, out[Power + i] = telemetry.power[i]);
+	FOREACH(i, 3, out[GyroX + i] = static_cast< float >(telemetry.gyroscope.gyro.data[i]));
+	FOREACH(i, 3, out[AccelX + i] = static_cast< float >(telemetry.gyroscope.accel.data[i]));
+}
+
+////////////////////////////////////////////////
+
+Aggregate::Aggregate()
+{
+	start = width = count = 0;
+	FOREACH(i, fields, min[i] = max[i] = mean[i] = last[i] = 0);
+}
+
+////////////////////////////////////////////////
+
+Aggregator::Aggregator(const std::vector<long long> &widths)
+{
+	long long prev = 1;
+	for(size_t i = 0; i < widths.size(); i++){
+		long long w = widths[i] > prev? widths[i] : prev;
+		w = (w + prev - 1) / prev * prev;
+		m_widths.push_back(w);
+		prev = w;
+	}
+	if(m_widths.empty())
+		m_widths.push_back(1);
+	m_windows.resize(m_widths.size());
+	reset();
+}
+
+std::vector<long long> Aggregator::default_widths()
+{
+	/// 10 ms, 100 ms, 1 s for the tick of 1 ms
+	std::vector< long long > res;
+	res.push_back(10);
+	res.push_back(100);
+	res.push_back(1000);
+	return res;
+}
+
+void Aggregator::set_sink(const Aggregator::Sink &sink)
+{
+	m_sink = sink;
+}
+
+int Aggregator::levels() const
+{
+	return static_cast< int >(m_widths.size());
+}
+
+long long Aggregator::width(int level) const
+{
+	return m_widths[level];
+}
+
+void Aggregator::reset()
+{
+	for(size_t i = 0; i < m_windows.size(); i++){
+		m_windows[i].start = 0;
+		m_windows[i].count = 0;
+	}
+}
+
+void Aggregator::push(const sc::StructTelemetry &telemetry)
+{
+	float v[fields];
+	values(telemetry, v);
+
+	long long tick = telemetry.gyroscope.tick;
+	Window& w = m_windows[0];
+	if(w.count && tick >= w.start + m_widths[0])
+		close(0);
+	if(!w.count){
+		w.start = window_start(tick, m_widths[0]);
+		w.count = 1;
+		FOREACH(i, fields, w.min[i] = w.max[i] = w.last[i] = v[i]; w.sum[i] = v[i]);
+		return;
+	}
+	w.count++;
+	for(int i = 0; i < fields; i++){
+		if(v[i] < w.min[i])
+			w.min[i] = v[i];
+		if(v[i] > w.max[i])
+			w.max[i] = v[i];
+		w.last[i] = v[i];
+		w.sum[i] += v[i];
+	}
+}
+
+void Aggregator::push(const sc::StructTelemetry *telemetry, size_t count)
+{
+	for(size_t i = 0; i < count; i++)
+		push(telemetry[i]);
+}
+
+void Aggregator::flush()
+{
+	for(int level = 0; level < levels(); level++){
+		if(m_windows[level].count)
+			close(level);
+	}
+}
+
+bool Aggregator::current(int level, Aggregate &aggregate) const
+{
+	const Window& w = m_windows[level];
+	if(!w.count)
+		return false;
+	to_aggregate(level, w, aggregate);
+	return true;
+}
+
+std::vector<std::vector<Aggregate> > Aggregator::aggregate(const sc::StructTelemetry *telemetry, size_t count,
+														   const std::vector<long long> &widths)
+{
+	Aggregator aggregator(widths);
+	std::vector< std::vector< Aggregate > > res(aggregator.levels());
+	aggregator.set_sink([&res](int level, const Aggregate& aggregate){
+		res[level].push_back(aggregate);
+	});
+	aggregator.push(telemetry, count);
+	aggregator.flush();
+	return res;
+}
+
+void Aggregator::close(int level)
+{
+	Window& w = m_windows[level];
+	if(m_sink){
+		Aggregate a;
+		to_aggregate(level, w, a);
+		m_sink(level, a);
+	}
+	if(level + 1 < levels())
+		merge(level + 1, w);
+	w.count = 0;
+}
+
+void Aggregator::merge(int level, const Window &window)
+{
+	Window& w = m_windows[level];
+	if(w.count && window.start >= w.start + m_widths[level])
+		close(level);
+	if(!w.count){
+		w = window;
+		w.start = window_start(window.start, m_widths[level]);
+		return;
+	}
+	w.count += window.count;
+	for(int i = 0; i < fields; i++){
+		if(window.min[i] < w.min[i])
+			w.min[i] = window.min[i];
+		if(window.max[i] > w.max[i])
+			w.max[i] = window.max[i];
+		w.last[i] = window.last[i];
+		w.sum[i] += window.sum[i];
+	}
+}
+
+void Aggregator::to_aggregate(int level, const Aggregator::Window &window, Aggregate &aggregate) const
+{
+	aggregate.start = window.start;
+	aggregate.width = m_widths[level];
+	aggregate.count = window.count;
+	FOREACH(i, fields, {
+		aggregate.min[i] = window.min[i];
+		aggregate.max[i] = window.max[i];
+		aggregate.mean[i] = static_cast< float >(window.sum[i] / window.count);
+		aggregate.last[i] = window.last[i];
+	});
+}
@@ -0,0 +1,130 @@
+#ifndef AGGREGATION_H
+#define AGGREGATION_H
+
+#include <vector>
+#include <functional>
+#include <stddef.h>
+
+#include "struct_controls.h"
+
+namespace aggregation{
+
+/**
+ * @brief The Field enum
+ * aggregated values of StructTelemetry
+ */
+enum Field{
+	Tangaj,
+	Bank,
+	Course,
+	Height,
+	Power,								/// power[0]; power[i] is Power + i
+	GyroX = Power + sc::cnt_engines,	/// raw gyroscope
+	GyroY,
+	GyroZ,
+	AccelX,								/// raw accelerometer
+	AccelY,
+	AccelZ,
+	fields
+};
+
+/**
+ * @brief values
+ * fields of the telemetry in the order of Field
+ * @param telemetry
+ * @param out
+ */
+void values(const sc::StructTelemetry& telemetry, float out[fields]);
+
+/**
+ * @brief The Aggregate struct
+ * values of the window [start; start + width) of ticks
+ */
+struct Aggregate{
+	Aggregate();
+
+	long long start;
+	long long width;
+	long long count;					/// samples in the window
+	float min[fields];
+	float max[fields];
+	float mean[fields];
+	float last[fields];
+};
+
+//////////////////////////////////////////////////
+/// \brief The Aggregator class
+/// reduces the telemetry to the windows of the fixed width in ticks of the
+/// gyroscope for several resolutions at once. the windows are aligned to the
+/// multiples of their width. a sample updates only the finest window; the closed
+/// window is merged into the next level, so the work is O(1) per sample.
+/// windows without samples are not emitted; a sample older than the open
+/// window is counted in the open window
+class Aggregator{
+public:
+	/// called for every closed window
+	typedef std::function< void (int level, const Aggregate& aggregate) > Sink;
+
+	/**
+	 * @brief Aggregator
+	 * @param widths - widths of the levels in ticks from the finest. every width is
+	 * rounded up to the multiple of the previous one
+	 */
+	Aggregator(const std::vector< long long >& widths = default_widths());
+
+	static std::vector< long long > default_widths();
+
+	void set_sink(const Sink& sink);
+	int levels() const;
+	long long width(int level) const;
+
+	void reset();
+	void push(const sc::StructTelemetry& telemetry);
+	void push(const sc::StructTelemetry* telemetry, size_t count);
+	/**
+	 * @brief flush
+	 * close the open windows of all levels, e.g. at the end of the log
+	 */
+	void flush();
+	/**
+	 * @brief current
+	 * the open (not finished) window of the level
+	 * @param level
+	 * @param aggregate
+	 * @return false if the window has no samples
+	 */
+	bool current(int level, Aggregate& aggregate) const;
+
+	/**
+	 * @brief aggregate
+	 * pyramid of the recorded log
+	 * @param telemetry
+	 * @param count
+	 * @param widths
+	 * @return windows for every level
+	 */
+	static std::vector< std::vector< Aggregate > > aggregate(const sc::StructTelemetry* telemetry, size_t count,
+															  const std::vector< long long >& widths = default_widths());
+
+private:
+	struct Window{
+		long long start;
+		long long count;
+		float min[fields];
+		float max[fields];
+		float last[fields];
+		double sum[fields];
+	};
+
+	std::vector< long long > m_widths;
+	std::vector< Window > m_windows;
+	Sink m_sink;
+
+	void close(int level);
+	void merge(int level, const Window& window);
+	void to_aggregate(int level, const Window& window, Aggregate& aggregate) const;
+};
+
+}
+
+#endif // AGGREGATION_H
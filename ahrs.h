@@ -0,0 +1,382 @@
+#ifndef AHRS_H
+#define AHRS_H
+
+#include <stddef.h>
+
+#include "common_.h"
+#include "vector3_.h"
+#include "quaternions.h"
+#include "precision.h"
+#include "struct_controls.h"
+
+namespace ahrs{
+
+/**
+ * @brief The AhrsMethod enum
+ * algorithm used to correct the gyroscope integration
+ */
+enum AhrsMethod{
+	Madgwick,			/// gradient descent correction (gain beta)
+	Mahony				/// complementary PI correction (gains kp, ki)
+};
+
+const float default_beta = 0.1f;
+const float default_kp = 1.0f;
+const float default_ki = 0.0f;
+
+//////////////////////////////////////////////////
+/// \brief The Ahrs_ class
+/// fixed step attitude estimator for the gyroscope, accelerometer and compass.
+/// T - float or double, the state is kept in T and all work is done without allocations
+/// P - precision policy used for the normalizations (precision::Exact or precision::Fast)
+template< typename T, AhrsMethod method, typename P = precision::Exact >
+class Ahrs_{
+public:
+	typedef vector3_::Vector3_< T > Vector;
+
+	/**
+	 * @brief Ahrs_
+	 * @param freq - frequency of the updates in Hz
+	 */
+	Ahrs_(T freq = sc::default_freq){
+		m_beta = default_beta;
+		m_two_kp = 2 * default_kp;
+		m_two_ki = 2 * default_ki;
+		set_freq(freq);
+		reset();
+	}
+	/**
+	 * @brief set_freq
+	 * set frequency of the updates. the step of the filter is 1/freq
+	 * @param freq
+	 */
+	void set_freq(T freq){
+		if(freq <= 0)
+			freq = sc::default_freq;
+		m_freq = freq;
+		m_dt = 1 / freq;
+	}
+	T freq() const{
+		return m_freq;
+	}
+	/**
+	 * @brief set_beta
+	 * gain for Madgwick method
+	 * @param beta
+	 */
+	void set_beta(T beta){
+		m_beta = beta;
+	}
+	/**
+	 * @brief set_gains
+	 * proportional and integral gains for Mahony method
+	 * @param kp
+	 * @param ki
+	 */
+	void set_gains(T kp, T ki){
+		m_two_kp = 2 * kp;
+		m_two_ki = 2 * ki;
+	}
+	/**
+	 * @brief reset
+	 * reset orientation to identity
+	 */
+	void reset(){
+		m_q[0] = 1;
+		m_q[1] = m_q[2] = m_q[3] = 0;
+		m_integral[0] = m_integral[1] = m_integral[2] = 0;
+	}
+	/**
+	 * @brief reset
+	 * reset orientation to the given value
+	 * @param q
+	 */
+	void reset(const quaternions::Quaternion& q){
+		reset();
+		quaternions::Quaternion n = q.normalized();
+		m_q[0] = static_cast< T >(n.w);
+		m_q[1] = static_cast< T >(n.x());
+		m_q[2] = static_cast< T >(n.y());
+		m_q[3] = static_cast< T >(n.z());
+	}
+
+	/**
+	 * @brief update
+	 * one step of the filter
+	 * @param gyro - angular speed in rad/s
+	 * @param accel - accelerometer in any units (only direction is used)
+	 * @param mag - compass in any units (only direction is used); zero vector means no compass
+	 */
+	inline void update(const Vector& gyro, const Vector& accel, const Vector& mag){
+		if(method == Madgwick)
+			update_madgwick(gyro.x(), gyro.y(), gyro.z(), accel.x(), accel.y(), accel.z(), mag.x(), mag.y(), mag.z());
+		else
+			update_mahony(gyro.x(), gyro.y(), gyro.z(), accel.x(), accel.y(), accel.z(), mag.x(), mag.y(), mag.z());
+	}
+	/**
+	 * @brief update
+	 * one step of the filter without compass
+	 * @param gyro - angular speed in rad/s
+	 * @param accel
+	 */
+	inline void update(const Vector& gyro, const Vector& accel){
+		if(method == Madgwick)
+			update_madgwick(gyro.x(), gyro.y(), gyro.z(), accel.x(), accel.y(), accel.z(), 0, 0, 0);
+		else
+			update_mahony(gyro.x(), gyro.y(), gyro.z(), accel.x(), accel.y(), accel.z(), 0, 0, 0);
+	}
+	/**
+	 * @brief update
+	 * batch of the steps. mag may be null
+	 * @param gyro
+	 * @param accel
+	 * @param mag
+	 * @param count
+	 */
+	void update(const Vector* gyro, const Vector* accel, const Vector* mag, size_t count){
+		if(mag){
+			for(size_t i = 0; i < count; i++)
+				update(gyro[i], accel[i], mag[i]);
+		}else{
+			for(size_t i = 0; i < count; i++)
+				update(gyro[i], accel[i]);
+		}
+	}
+	/**
+	 * @brief update
+	 * one step from the sensor structures
+	 * @param gyroscope
+	 * @param compass
+	 * @param offset - bias of the gyroscope in raw units
+	 */
+	void update(sc::StructGyroscope& gyroscope, const sc::StructCompass& compass,
+				const vector3_::Vector3d& offset = vector3_::Vector3d()){
+		vector3_::Vector3d speed = gyroscope.angular_speed(offset);
+		speed *= common_::angle2rad(1.0);
+		update(Vector(speed), Vector(gyroscope.accel), Vector(compass.data));
+	}
+	/**
+	 * @brief update
+	 * one step from the gyroscope structure without compass
+	 * @param gyroscope
+	 * @param offset - bias of the gyroscope in raw units
+	 */
+	void update(sc::StructGyroscope& gyroscope, const vector3_::Vector3d& offset = vector3_::Vector3d()){
+		vector3_::Vector3d speed = gyroscope.angular_speed(offset);
+		speed *= common_::angle2rad(1.0);
+		update(Vector(speed), Vector(gyroscope.accel));
+	}
+
+	/**
+	 * @brief quaternion
+	 * current orientation
+	 * @return
+	 */
+	quaternions::Quaternion quaternion() const{
+		return quaternions::Quaternion(m_q[1], m_q[2], m_q[3], m_q[0]);
+	}
+	/**
+	 * @brief bank
+	 * roll in degrees
+	 * @return
+	 */
+	T bank() const{
+		return static_cast< T >(common_::rad2angle(atan2(m_q[0] * m_q[1] + m_q[2] * m_q[3],
+				T(0.5) - m_q[1] * m_q[1] - m_q[2] * m_q[2])));
+	}
+	/**
+	 * @brief tangaj
+	 * pitch in degrees
+	 * @return
+	 */
+	T tangaj() const{
+		T s = -2 * (m_q[1] * m_q[3] - m_q[0] * m_q[2]);
+		if(s > 1) s = 1;
+		if(s < -1) s = -1;
+		return static_cast< T >(common_::rad2angle(asin(s)));
+	}
+	/**
+	 * @brief course
+	 * yaw in degrees
+	 * @return
+	 */
+	T course() const{
+		return static_cast< T >(common_::rad2angle(atan2(m_q[1] * m_q[2] + m_q[0] * m_q[3],
+				T(0.5) - m_q[2] * m_q[2] - m_q[3] * m_q[3])));
+	}
+	/**
+	 * @brief to_telemetry
+	 * fill tangaj, bank and course
+	 * @param telemetry
+	 */
+	void to_telemetry(sc::StructTelemetry& telemetry) const{
+		telemetry.tangaj = static_cast< float >(tangaj());
+		telemetry.bank = static_cast< float >(bank());
+		telemetry.course = static_cast< float >(course());
+	}
+
+private:
+	T m_q[4];
+	T m_integral[3];
+	T m_freq;
+	T m_dt;
+	T m_beta;
+	T m_two_kp;
+	T m_two_ki;
+
+	static inline T inv_sqrt(T value){
+		return static_cast< T >(P::rsqrt(value));
+	}
+
+	inline void normalize_state(){
+		T norm = inv_sqrt(m_q[0] * m_q[0] + m_q[1] * m_q[1] + m_q[2] * m_q[2] + m_q[3] * m_q[3]);
+		FOREACH(i, 4, m_q[i] *= norm);
+	}
+
+	void update_madgwick(T gx, T gy, T gz, T ax, T ay, T az, T mx, T my, T mz){
+		T q0 = m_q[0], q1 = m_q[1], q2 = m_q[2], q3 = m_q[3];
+
+		T qdot0 = T(0.5) * (-q1 * gx - q2 * gy - q3 * gz);
+		T qdot1 = T(0.5) * (q0 * gx + q2 * gz - q3 * gy);
+		T qdot2 = T(0.5) * (q0 * gy - q1 * gz + q3 * gx);
+		T qdot3 = T(0.5) * (q0 * gz + q1 * gy - q2 * gx);
+
+		if(!(ax == 0 && ay == 0 && az == 0)){
+			T norm = inv_sqrt(ax * ax + ay * ay + az * az);
+			ax *= norm; ay *= norm; az *= norm;
+
+			T s0, s1, s2, s3;
+			T q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+
+			if(mx == 0 && my == 0 && mz == 0){
+				T _2q0 = 2 * q0, _2q1 = 2 * q1, _2q2 = 2 * q2, _2q3 = 2 * q3;
+				T _4q0 = 4 * q0, _4q1 = 4 * q1, _4q2 = 4 * q2;
+				T _8q1 = 8 * q1, _8q2 = 8 * q2;
+
+				s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+				s1 = _4q1 * q3q3 - _2q3 * ax + 4 * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+				s2 = 4 * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+				s3 = 4 * q1q1 * q3 - _2q1 * ax + 4 * q2q2 * q3 - _2q2 * ay;
+			}else{
+				norm = inv_sqrt(mx * mx + my * my + mz * mz);
+				mx *= norm; my *= norm; mz *= norm;
+
+				T _2q0mx = 2 * q0 * mx, _2q0my = 2 * q0 * my, _2q0mz = 2 * q0 * mz, _2q1mx = 2 * q1 * mx;
+				T _2q0 = 2 * q0, _2q1 = 2 * q1, _2q2 = 2 * q2, _2q3 = 2 * q3;
+				T _2q0q2 = 2 * q0 * q2, _2q2q3 = 2 * q2 * q3;
+				T q0q1 = q0 * q1, q0q2 = q0 * q2, q0q3 = q0 * q3;
+				T q1q2 = q1 * q2, q1q3 = q1 * q3, q2q3 = q2 * q3;
+
+				/// reference direction of the earth magnetic field
+				T hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 + _2q1 * mz * q3 - mx * q2q2 - mx * q3q3;
+				T hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 + _2q2 * mz * q3 - my * q3q3;
+				T _2bx = sqrt(hx * hx + hy * hy);
+				T _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 + _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
+				T _4bx = 2 * _2bx, _4bz = 2 * _2bz;
+
+				T fa0 = 2 * q1q3 - _2q0q2 - ax;
+				T fa1 = 2 * q0q1 + _2q2q3 - ay;
+				T fa2 = 1 - 2 * q1q1 - 2 * q2q2 - az;
+				T fm0 = _2bx * (T(0.5) - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx;
+				T fm1 = _2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my;
+				T fm2 = _2bx * (q0q2 + q1q3) + _2bz * (T(0.5) - q1q1 - q2q2) - mz;
+
+				s0 = -_2q2 * fa0 + _2q1 * fa1 - _2bz * q2 * fm0 + (-_2bx * q3 + _2bz * q1) * fm1 + _2bx * q2 * fm2;
+				s1 = _2q3 * fa0 + _2q0 * fa1 - 4 * q1 * fa2 + _2bz * q3 * fm0 + (_2bx * q2 + _2bz * q0) * fm1 + (_2bx * q3 - _4bz * q1) * fm2;
+				s2 = -_2q0 * fa0 + _2q3 * fa1 - 4 * q2 * fa2 + (-_4bx * q2 - _2bz * q0) * fm0 + (_2bx * q1 + _2bz * q3) * fm1 + (_2bx * q0 - _4bz * q2) * fm2;
+				s3 = _2q1 * fa0 + _2q2 * fa1 + (-_4bx * q3 + _2bz * q1) * fm0 + (-_2bx * q0 + _2bz * q2) * fm1 + _2bx * q1 * fm2;
+			}
+
+			T snorm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+			if(snorm > 0){
+				snorm = inv_sqrt(snorm);
+				qdot0 -= m_beta * s0 * snorm;
+				qdot1 -= m_beta * s1 * snorm;
+				qdot2 -= m_beta * s2 * snorm;
+				qdot3 -= m_beta * s3 * snorm;
+			}
+		}
+
+		m_q[0] = q0 + qdot0 * m_dt;
+		m_q[1] = q1 + qdot1 * m_dt;
+		m_q[2] = q2 + qdot2 * m_dt;
+		m_q[3] = q3 + qdot3 * m_dt;
+		normalize_state();
+	}
+
+	void update_mahony(T gx, T gy, T gz, T ax, T ay, T az, T mx, T my, T mz){
+		T q0 = m_q[0], q1 = m_q[1], q2 = m_q[2], q3 = m_q[3];
+
+		if(!(ax == 0 && ay == 0 && az == 0)){
+			T norm = inv_sqrt(ax * ax + ay * ay + az * az);
+			ax *= norm; ay *= norm; az *= norm;
+
+			T q0q0 = q0 * q0, q0q1 = q0 * q1, q0q2 = q0 * q2, q0q3 = q0 * q3;
+			T q1q1 = q1 * q1, q1q2 = q1 * q2, q1q3 = q1 * q3;
+			T q2q2 = q2 * q2, q2q3 = q2 * q3, q3q3 = q3 * q3;
+
+			/// estimated direction of gravity
+			T halfvx = q1q3 - q0q2;
+			T halfvy = q0q1 + q2q3;
+			T halfvz = q0q0 - T(0.5) + q3q3;
+
+			T halfex = ay * halfvz - az * halfvy;
+			T halfey = az * halfvx - ax * halfvz;
+			T halfez = ax * halfvy - ay * halfvx;
+
+			if(!(mx == 0 && my == 0 && mz == 0)){
+				norm = inv_sqrt(mx * mx + my * my + mz * mz);
+				mx *= norm; my *= norm; mz *= norm;
+
+				/// reference direction of the earth magnetic field
+				T hx = 2 * (mx * (T(0.5) - q2q2 - q3q3) + my * (q1q2 - q0q3) + mz * (q1q3 + q0q2));
+				T hy = 2 * (mx * (q1q2 + q0q3) + my * (T(0.5) - q1q1 - q3q3) + mz * (q2q3 - q0q1));
+				T bx = sqrt(hx * hx + hy * hy);
+				T bz = 2 * (mx * (q1q3 - q0q2) + my * (q2q3 + q0q1) + mz * (T(0.5) - q1q1 - q2q2));
+
+				T halfwx = bx * (T(0.5) - q2q2 - q3q3) + bz * (q1q3 - q0q2);
+				T halfwy = bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3);
+				T halfwz = bx * (q0q2 + q1q3) + bz * (T(0.5) - q1q1 - q2q2);
+
+				halfex += my * halfwz - mz * halfwy;
+				halfey += mz * halfwx - mx * halfwz;
+				halfez += mx * halfwy - my * halfwx;
+			}
+
+			if(m_two_ki > 0){
+				m_integral[0] += m_two_ki * halfex * m_dt;
+				m_integral[1] += m_two_ki * halfey * m_dt;
+				m_integral[2] += m_two_ki * halfez * m_dt;
+				gx += m_integral[0];
+				gy += m_integral[1];
+				gz += m_integral[2];
+			}else{
+				m_integral[0] = m_integral[1] = m_integral[2] = 0;
+			}
+
+			gx += m_two_kp * halfex;
+			gy += m_two_kp * halfey;
+			gz += m_two_kp * halfez;
+		}
+
+		T half_dt = T(0.5) * m_dt;
+		gx *= half_dt;
+		gy *= half_dt;
+		gz *= half_dt;
+
+		m_q[0] = q0 + (-q1 * gx - q2 * gy - q3 * gz);
+		m_q[1] = q1 + (q0 * gx + q2 * gz - q3 * gy);
+		m_q[2] = q2 + (q0 * gy - q1 * gz + q3 * gx);
+		m_q[3] = q3 + (q0 * gz + q1 * gy - q2 * gx);
+		normalize_state();
+	}
+};
+
+typedef Ahrs_< double, Madgwick > MadgwickAhrs;
+typedef Ahrs_< float, Madgwick > MadgwickAhrsf;
+typedef Ahrs_< double, Mahony > MahonyAhrs;
+typedef Ahrs_< float, Mahony > MahonyAhrsf;
+
+}
+
+#endif // AHRS_H
@@ -0,0 +1,6 @@
+TARGET = bench_ahrs
+
+include(../benchmarks.pri)
+
+SOURCES += \
+    bench_ahrs.cpp
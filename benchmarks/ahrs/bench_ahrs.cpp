@@ -0,0 +1,60 @@
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+#include "ahrs.h"
+#include "test_common.h"
+
+namespace{
+
+const int count = 4096;
+const int rounds = 100;
+const double budget_ns = 1e6;		/// one step of the 1 kHz loop
+
+volatile double sink;
+
+/**
+ * @brief measure
+ * ns per update of the filter over the recorded sensors
+ * @param name
+ * @param with_mag - false: update without the compass
+ */
+template< typename Ahrs >
+void measure(const char* name, bool with_mag){
+	typedef typename Ahrs::Vector Vector;
+	std::vector< Vector > gyro(count), accel(count), mag(count);
+	for(int i = 0; i < count; i++){
+		double t = i * 1e-3;
+		gyro[i] = Vector(0.3 * sin(t), -0.2 * cos(2 * t), 0.1);
+		accel[i] = Vector(100 * sin(3 * t), -80 * cos(t), 16384);
+		mag[i] = Vector(250 + 10 * sin(t), -40, -430);
+	}
+
+	Ahrs ahrs(1000);
+	long long start = test_common::now_ns();
+	for(int r = 0; r < rounds; r++)
+		ahrs.update(gyro.data(), accel.data(), with_mag? mag.data() : nullptr, count);
+	long long end = test_common::now_ns();
+	sink = ahrs.course();
+
+	double ns = static_cast< double >(end - start) / (static_cast< double >(rounds) * count);
+	printf("%-22s %-8s %6.1f ns  %.4f%% of 1 kHz step\n", name, with_mag? "mag" : "no mag", ns, 100 * ns / budget_ns);
+}
+
+template< typename Ahrs >
+void measure(const char* name){
+	measure< Ahrs >(name, true);
+	measure< Ahrs >(name, false);
+}
+
+}
+
+int main(int, char**){
+	measure< ahrs::MadgwickAhrs >("madgwick double");
+	measure< ahrs::MadgwickAhrsf >("madgwick float");
+	measure< ahrs::Ahrs_< float, ahrs::Madgwick, precision::Fast > >("madgwick float fast");
+	measure< ahrs::MahonyAhrs >("mahony double");
+	measure< ahrs::MahonyAhrsf >("mahony float");
+	measure< ahrs::Ahrs_< float, ahrs::Mahony, precision::Fast > >("mahony float fast");
+	return 0;
+}
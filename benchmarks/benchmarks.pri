@@ -0,0 +1,9 @@
+TEMPLATE = app
+QT = core
+CONFIG += console release
+CONFIG -= app_bundle debug
+
+include($$PWD/../struct_controls.pri)
+
+INCLUDEPATH += $$PWD/../tests
+HEADERS += $$PWD/../tests/test_common.h
@@ -0,0 +1,17 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    ahrs \
+    coro_io \
+    height_estimator \
+    ingest \
+    load_generator \
+    mixer \
+    precision \
+    shm_ring \
+    slim_telemetry \
+    trace \
+    trace_off \
+    vibration \
+    wire \
+    zone_map
@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "coro_io.h"
+#include "test_common.h"
+
+using namespace coro;
+
+namespace{
+
+const int frames = 20000;
+
+Task writer(Executor& executor, int fd){
+	FrameStream stream(executor, fd);
+	sc::StructTelemetry telemetry;
+	for(int i = 0; i < frames; i++){
+		telemetry.gyroscope.tick = i;
+		if(!co_await stream.write_frame(telemetry))
+			break;
+	}
+	executor.forget(fd);
+	shutdown(fd, SHUT_WR);
+}
+
+Task reader(Executor& executor, int fd, long long& received){
+	FrameStream stream(executor, fd);
+	sc::StructTelemetry telemetry;
+	while(co_await stream.read_frame(telemetry))
+		received++;
+	executor.forget(fd);
+}
+
+bool write_all(int fd, const char* data, size_t size){
+	while(size){
+		ssize_t res = ::write(fd, data, size);
+		if(res <= 0)
+			return false;
+		data += res;
+		size -= static_cast< size_t >(res);
+	}
+	return true;
+}
+
+bool read_all(int fd, char* data, size_t size){
+	while(size){
+		ssize_t res = ::read(fd, data, size);
+		if(res <= 0)
+			return false;
+		data += res;
+		size -= static_cast< size_t >(res);
+	}
+	return true;
+}
+
+/// the same framing with the blocking descriptors
+void thread_writer(int fd){
+	sc::StructTelemetry telemetry;
+	std::vector< char > frame;
+	for(int i = 0; i < frames; i++){
+		telemetry.gyroscope.tick = i;
+		wire::encode(telemetry, frame);
+		unsigned size = static_cast< unsigned >(frame.size());
+		char header[4] = {char(size >> 24), char(size >> 16), char(size >> 8), char(size)};
+		if(!write_all(fd, header, 4) || !write_all(fd, frame.data(), frame.size()))
+			break;
+	}
+	shutdown(fd, SHUT_WR);
+}
+
+void thread_reader(int fd, std::atomic< long long >& received){
+	sc::StructTelemetry telemetry;
+	std::vector< char > frame;
+	unsigned char header[4];
+	while(read_all(fd, reinterpret_cast< char* >(header), 4)){
+		size_t size = (static_cast< size_t >(header[0]) << 24) | (header[1] << 16) | (header[2] << 8) | header[3];
+		frame.resize(size);
+		if(!read_all(fd, frame.data(), size))
+			break;
+		wire::decode(frame.data(), size, telemetry);
+		received++;
+	}
+}
+
+void pairs(int count, int type, std::vector< int >& a, std::vector< int >& b){
+	a.resize(count);
+	b.resize(count);
+	for(int i = 0; i < count; i++){
+		int sv[2] = {-1, -1};
+		socketpair(AF_UNIX, type, 0, sv);
+		a[i] = sv[0];
+		b[i] = sv[1];
+	}
+}
+
+void close_pairs(const std::vector< int >& a, const std::vector< int >& b){
+	for(size_t i = 0; i < a.size(); i++){
+		close(a[i]);
+		close(b[i]);
+	}
+}
+
+}
+
+int main(int, char**){
+	const int counts[] = {1, 16, 256};
+	for(int count: counts){
+		std::vector< int > a, b;
+
+		/// all streams on one thread
+		pairs(count, SOCK_STREAM | SOCK_NONBLOCK, a, b);
+		Executor executor;
+		long long received = 0;
+		long long start = test_common::now_ns();
+		for(int i = 0; i < count; i++){
+			executor.spawn(writer(executor, a[i]));
+			executor.spawn(reader(executor, b[i], received));
+		}
+		executor.run();
+		double coro_s = (test_common::now_ns() - start) * 1e-9;
+		close_pairs(a, b);
+
+		/// baseline: two blocking threads per stream
+		pairs(count, SOCK_STREAM, a, b);
+		std::atomic< long long > received_threads(0);
+		std::vector< std::thread > threads;
+		start = test_common::now_ns();
+		for(int i = 0; i < count; i++){
+			threads.push_back(std::thread(thread_writer, a[i]));
+			threads.push_back(std::thread(thread_reader, b[i], std::ref(received_threads)));
+		}
+		for(size_t i = 0; i < threads.size(); i++)
+			threads[i].join();
+		double thread_s = (test_common::now_ns() - start) * 1e-9;
+		close_pairs(a, b);
+
+		printf("streams %4d: coroutines %10.0f frames/s (%lld), threads %10.0f frames/s (%lld)\n",
+			   count, received / coro_s, received, received_threads.load() / thread_s, received_threads.load());
+	}
+	return 0;
+}
@@ -0,0 +1,7 @@
+TARGET = bench_coro_io
+
+include(../benchmarks.pri)
+include(../../coro_io.pri)
+
+SOURCES += \
+    bench_coro_io.cpp
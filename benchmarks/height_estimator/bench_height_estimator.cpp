@@ -0,0 +1,85 @@
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+#include "height_estimator.h"
+#include "test_common.h"
+
+using namespace height;
+
+namespace{
+
+const int count = 4096;
+const int rounds = 200;
+
+volatile double sink;
+
+double per_call(long long start, long long end, int calls){
+	return static_cast< double >(end - start) / (static_cast< double >(rounds) * calls);
+}
+
+}
+
+int main(int, char**){
+	std::vector< sc::StructGyroscope > gyroscope(count);
+	std::vector< sc::StructBarometer > barometer(count);
+	std::vector< quaternions::Quaternion > attitude(count);
+	std::vector< sc::StructTelemetry > telemetry(count);
+	for(int i = 0; i < count; i++){
+		gyroscope[i].freq = 1000;
+		gyroscope[i].accel = vector3_::Vector3i(100 * (i % 7), -50 * (i % 5), 16384 + (i % 13));
+		barometer[i].tick = i;
+		barometer[i].data = 101325 - (i % 50);
+		attitude[i] = HeightEstimator::attitude(5 * sin(i * 1e-2), 3 * cos(i * 1e-2));
+		telemetry[i].gyroscope = gyroscope[i];
+		telemetry[i].tangaj = 5 * sin(i * 1e-2);
+		telemetry[i].bank = 3 * cos(i * 1e-2);
+		telemetry[i].barometer = barometer[i];
+		telemetry[i].barometer.tick = i / 20;		/// 50 Hz barometer in the 1 kHz frames
+	}
+
+	HeightEstimator estimator(sea_level_pressure);
+	estimator.update(barometer[0]);
+
+	long long start = test_common::now_ns();
+	for(int r = 0; r < rounds; r++){
+		for(int i = 0; i < count; i++)
+			estimator.update(gyroscope[i], attitude[i]);
+	}
+	long long end = test_common::now_ns();
+	printf("predict (accelerometer)  %6.1f ns\n", per_call(start, end, count));
+
+	start = test_common::now_ns();
+	for(int r = 0; r < rounds; r++){
+		for(int i = 0; i < count; i++)
+			estimator.update(barometer[i]);
+	}
+	end = test_common::now_ns();
+	printf("correct (barometer)      %6.1f ns\n", per_call(start, end, count));
+
+	start = test_common::now_ns();
+	for(int r = 0; r < rounds; r++)
+		estimator.process(telemetry.data(), count);
+	end = test_common::now_ns();
+	printf("process per frame        %6.1f ns\n", per_call(start, end, count));
+	sink = estimator.height();
+
+	AltitudeTable table;
+	double sum = 0;
+	start = test_common::now_ns();
+	for(int r = 0; r < rounds; r++){
+		for(int i = 0; i < count; i++)
+			sum += table.altitude(barometer[i].data);
+	}
+	end = test_common::now_ns();
+	double fast = per_call(start, end, count);
+	start = test_common::now_ns();
+	for(int r = 0; r < rounds; r++){
+		for(int i = 0; i < count; i++)
+			sum += AltitudeTable::altitude_exact(barometer[i].data);
+	}
+	end = test_common::now_ns();
+	printf("altitude table %.1f ns  pow %.1f ns\n", fast, per_call(start, end, count));
+	sink = sum;
+	return 0;
+}
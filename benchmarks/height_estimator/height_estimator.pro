@@ -0,0 +1,6 @@
+TARGET = bench_height_estimator
+
+include(../benchmarks.pri)
+
+SOURCES += \
+    bench_height_estimator.cpp
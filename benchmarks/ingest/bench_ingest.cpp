@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "ingest.h"
+#include "load_generator.h"
+#include "test_common.h"
+
+/// scaling of IngestServer with the count of the vehicles over the loopback:
+/// LoadGenerator encodes the frames of every vehicle beforehand, the senders
+/// write them to one connection per vehicle, the time is until the server
+/// has decoded all frames
+
+namespace{
+
+const long long total_frames = 400000;
+const size_t slice = 16 * 1024;			/// bytes written to one connection at once
+const int timeout_s = 120;
+
+int connect_to(unsigned short port){
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+	if(fd >= 0 && connect(fd, reinterpret_cast< sockaddr* >(&addr), sizeof(addr)) < 0){
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+bool write_all(int fd, const char* data, size_t size){
+	while(size){
+		ssize_t res = send(fd, data, size, MSG_NOSIGNAL);
+		if(res <= 0)
+			return false;
+		data += res;
+		size -= static_cast< size_t >(res);
+	}
+	return true;
+}
+
+/// the descriptors of the vehicles, the server and the spare ones
+bool enough_files(int vehicles){
+	rlimit limit;
+	if(getrlimit(RLIMIT_NOFILE, &limit))
+		return false;
+	rlim_t need = static_cast< rlim_t >(2 * vehicles + 64);
+	if(limit.rlim_cur < need && limit.rlim_max >= need){
+		limit.rlim_cur = need;
+		setrlimit(RLIMIT_NOFILE, &limit);
+		getrlimit(RLIMIT_NOFILE, &limit);
+	}
+	return limit.rlim_cur >= need;
+}
+
+/**
+ * @brief measure
+ * one run with the count of the vehicles
+ * @param vehicles
+ * @param senders - threads writing to the connections
+ */
+void measure(int vehicles, int senders){
+	if(!enough_files(vehicles)){
+		printf("%6d vehicles: not enough file descriptors\n", vehicles);
+		return;
+	}
+	long long frames = total_frames / vehicles * vehicles;
+
+	/// one worker per vehicle: worker w is the vehicle w
+	std::vector< std::vector< char > > buffers;
+	loadgen::LoadGenerator generator(vehicles);
+	generator.set_chunk(64);
+	generator.run(frames, buffers);
+
+	std::atomic< long long > consumed(0);
+	ingest::IngestServer server(0);
+	server.set_consumer([&consumed](int, const ingest::IngestRecord*, size_t count){
+		consumed += static_cast< long long >(count);
+	});
+	if(!server.start(0, "127.0.0.1")){
+		printf("%6d vehicles: the server is not started\n", vehicles);
+		return;
+	}
+
+	std::vector< int > fds(vehicles, -1);
+	bool connected = true;
+	for(int v = 0; v < vehicles && connected; v++){
+		fds[v] = connect_to(server.port());
+		connected = fds[v] >= 0 && loadgen::LoadGenerator::send_hello(fds[v], v);
+	}
+	for(int i = 0; i < timeout_s * 100 && connected && server.stats().connections < vehicles; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	long long start = test_common::now_ns();
+	std::vector< std::thread > threads;
+	senders = std::max(1, std::min(senders, vehicles));
+	for(int t = 0; t < senders && connected; t++){
+		threads.push_back(std::thread([&, t](){
+			std::vector< size_t > offset(vehicles, 0);
+			bool left = true;
+			while(left){
+				left = false;
+				for(int v = t; v < vehicles; v += senders){
+					const std::vector< char >& data = buffers[v];
+					size_t size = std::min(slice, data.size() - offset[v]);
+					if(!size)
+						continue;
+					if(!write_all(fds[v], &data[offset[v]], size))
+						return;
+					offset[v] += size;
+					left = true;
+				}
+			}
+		}));
+	}
+	for(std::thread& thread: threads)
+		thread.join();
+	for(int i = 0; i < timeout_s * 1000 && server.stats().frames < frames; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	long long elapsed = test_common::now_ns() - start;
+
+	ingest::IngestStats stats = server.stats();
+	ingest::VehicleState state;
+	int known = 0;
+	for(int v = 0; v < vehicles; v++)
+		known += server.latest(v, state) && state.frames == frames / vehicles;
+
+	printf("%6d vehicles %2d shards: %8.0f frames/s  %6.1f MB/s  frames %lld of %lld  consumed %lld  latest %d  errors %lld\n",
+		   vehicles, server.shards(), stats.frames / (elapsed / 1e9), stats.bytes / (elapsed / 1e9) / 1e6,
+		   stats.frames, frames, consumed.load(), known, stats.errors);
+
+	for(int fd: fds){
+		if(fd >= 0)
+			close(fd);
+	}
+	server.stop();
+}
+
+}
+
+int main(int, char**){
+	int senders = std::max(1, static_cast< int >(std::thread::hardware_concurrency()) / 2);
+	const int counts[] = {16, 256, 1024, 4096};
+	for(int vehicles: counts)
+		measure(vehicles, senders);
+	return 0;
+}
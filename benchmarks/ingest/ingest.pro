@@ -0,0 +1,6 @@
+TARGET = bench_ingest
+
+include(../benchmarks.pri)
+
+SOURCES += \
+    bench_ingest.cpp
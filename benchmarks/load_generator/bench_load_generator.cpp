@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "wire.h"
+#include "load_generator.h"
+#include "test_common.h"
+
+/// throughput of LoadGenerator itself: the cost of one frame split into the
+/// sensors and the encoding, and the scaling with the count of the workers
+/// into the sinks that cost nothing (discard), copy (memory) and write (/dev/null).
+/// bench_load_generator [frames = 2000000] [max workers = 2 * cores]
+
+namespace{
+
+volatile long long sink;
+
+void print(const char* name, int workers, const loadgen::GeneratorStats& stats, double single){
+	printf("%-8s %3d workers  %10.0f frames/s  %7.1f MB/s  x%.2f\n", name, workers, stats.frames_per_s,
+		   stats.bytes / stats.seconds / (1 << 20), single > 0? stats.frames_per_s / single : 1.0);
+}
+
+}
+
+int main(int argc, char** argv){
+	long long frames = argc > 1? atoll(argv[1]) : 2000000;
+	int cores = static_cast< int >(std::thread::hardware_concurrency());
+	if(cores < 1)
+		cores = 1;
+	int max_workers = argc > 2? atoi(argv[2]) : 2 * cores;
+	if(frames < 1)
+		frames = 1;
+	if(max_workers < 1)
+		max_workers = 1;
+	printf("%d cores, %lld frames\n", cores, frames);
+
+	/// the parts of one frame on one thread
+	{
+		loadgen::SensorGenerator generator;
+		sc::StructTelemetry telemetry;
+		std::vector< char > data;
+		long long sum = 0;
+		long long start = test_common::now_ns();
+		FOREACH(i, static_cast< int >(frames), sum += generator.next(telemetry));
+		long long middle = test_common::now_ns();
+		FOREACH(i, static_cast< int >(frames), wire::encode(telemetry, data); sum += data[i % data.size()]);
+		long long end = test_common::now_ns();
+		sink = sum;
+		printf("sensors %6.1f ns/frame  encode %6.1f ns/frame\n",
+			   static_cast< double >(middle - start) / frames, static_cast< double >(end - middle) / frames);
+	}
+
+	int fd = open("/dev/null", O_WRONLY);
+	std::vector< int > fds(1, fd);
+	double single[3] = { 0, 0, 0 };
+	for(int workers = 1; workers <= max_workers; workers *= 2){
+		loadgen::LoadGenerator generator(workers);
+		generator.set_controls(true);
+
+		std::atomic< long long > bytes(0);
+		loadgen::GeneratorStats stats = generator.run(frames, [&bytes](int, const char*, size_t size){
+			bytes.fetch_add(static_cast< long long >(size), std::memory_order_relaxed);
+			return true;
+		});
+		if(workers == 1)
+			single[0] = stats.frames_per_s;
+		print("discard", workers, stats, single[0]);
+
+		std::vector< std::vector< char > > buffers;
+		stats = generator.run(frames, buffers);
+		if(workers == 1)
+			single[1] = stats.frames_per_s;
+		print("memory", workers, stats, single[1]);
+
+		if(fd >= 0){
+			stats = generator.run(frames, loadgen::LoadGenerator::fd_sink(fds));
+			if(workers == 1)
+				single[2] = stats.frames_per_s;
+			print("devnull", workers, stats, single[2]);
+		}
+	}
+	if(fd >= 0)
+		close(fd);
+	return 0;
+}
@@ -0,0 +1,6 @@
+TARGET = bench_load_generator
+
+include(../benchmarks.pri)
+
+SOURCES += \
+    bench_load_generator.cpp
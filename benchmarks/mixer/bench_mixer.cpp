@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <vector>
+
+#include "mixer.h"
+#include "test_common.h"
+
+using namespace mixer;
+
+namespace{
+
+const int count = 4096;
+const int rounds = 500;
+
+volatile float sink;
+
+/**
+ * @brief measure
+ * ns per command of the scalar mix() and of the batch mix() (sse for 4 and 8 engines);
+ * the share of the limited commands is printed
+ * @param name
+ */
+template< typename Mixer >
+void measure(const char* name){
+	enum{ engines = Mixer::count };
+	std::vector< sc::StructControls > controls(count);
+	for(int i = 0; i < count; i++){
+		sc::StructControls& c = controls[i];
+		c.power_on = true;
+		c.throttle = 0.3f + 0.4f * (i % 97) / 97;
+		c.tangaj = -0.3f + 0.6f * (i % 89) / 89;
+		c.bank = -0.3f + 0.6f * (i % 83) / 83;
+		c.yaw = -0.2f + 0.4f * (i % 79) / 79;
+	}
+	std::vector< float > power(count * engines);
+	Mixer mixer;
+
+	size_t saturated = 0;
+	long long start = test_common::now_ns();
+	for(int r = 0; r < rounds; r++){
+		for(int i = 0; i < count; i++)
+			saturated += mixer.mix(controls[i], &power[i * engines]);
+	}
+	long long end = test_common::now_ns();
+	double scalar = static_cast< double >(end - start) / (static_cast< double >(rounds) * count);
+	sink = power[0];
+
+	start = test_common::now_ns();
+	for(int r = 0; r < rounds; r++)
+		saturated += mixer.mix(controls.data(), power.data(), count);
+	end = test_common::now_ns();
+	double batch = static_cast< double >(end - start) / (static_cast< double >(rounds) * count);
+	sink = power[0];
+
+	printf("%-10s mix %5.1f ns  batch %5.1f ns  saturated %.0f%%\n", name, scalar, batch,
+		   100.0 * saturated / (2.0 * rounds * count));
+}
+
+}
+
+int main(int, char**){
+	measure< MixerQuadX >("quad x");
+	measure< MixerQuadPlus >("quad +");
+	measure< MixerHexa >("hexa");
+	measure< MixerOcto >("octo");
+	return 0;
+}
@@ -0,0 +1,6 @@
+TARGET = bench_mixer
+
+include(../benchmarks.pri)
+
+SOURCES += \
+    bench_mixer.cpp
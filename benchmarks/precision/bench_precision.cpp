@@ -0,0 +1,75 @@
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+#include "precision.h"
+#include "quaternions.h"
+#include "test_common.h"
+
+using namespace precision;
+
+namespace{
+
+const int count = 1 << 16;
+const int rounds = 200;
+
+volatile double sink;
+
+/**
+ * @brief measure
+ * ns per call of func over the array of arguments
+ * @param args
+ * @param func
+ * @return
+ */
+template< typename F >
+double measure(const std::vector< double >& args, F func){
+	double sum = 0;
+	long long start = test_common::now_ns();
+	for(int r = 0; r < rounds; r++){
+		for(int i = 0; i < count; i++)
+			sum += func(args[i]);
+	}
+	long long end = test_common::now_ns();
+	sink = sum;
+	return static_cast< double >(end - start) / (static_cast< double >(rounds) * count);
+}
+
+template< typename FE, typename FF >
+void compare(const char* name, const std::vector< double >& args, FE exact, FF fast){
+	double e = measure(args, exact);
+	double f = measure(args, fast);
+	printf("%-12s exact %6.2f ns  fast %6.2f ns  x%.2f\n", name, e, f, e / f);
+}
+
+}
+
+int main(int, char**){
+	std::vector< double > positive(count), angle(count), unit(count);
+	for(int i = 0; i < count; i++){
+		positive[i] = 1e-3 + i * 0.37;
+		angle[i] = -20 + i * (40.0 / count);
+		unit[i] = -1 + i * (2.0 / count);
+	}
+
+	compare("rsqrt", positive, [](double v){ return Exact::rsqrt(v); }, [](double v){ return Fast::rsqrt(v); });
+	compare("sqrt", positive, [](double v){ return Exact::sqrt(v); }, [](double v){ return Fast::sqrt(v); });
+	compare("sin", angle, [](double v){ return Exact::sin(v); }, [](double v){ return Fast::sin(v); });
+	compare("cos", angle, [](double v){ return Exact::cos(v); }, [](double v){ return Fast::cos(v); });
+	compare("acos", unit, [](double v){ return Exact::acos(v); }, [](double v){ return Fast::acos(v); });
+	compare("atan2", unit, [](double v){ return Exact::atan2(v, 0.5); }, [](double v){ return Fast::atan2(v, 0.5); });
+
+	using quaternions::Quaternion;
+	const Quaternion p0 = Quaternion::fromAxisAndAngle(0, 0, 1, 10);
+	const Quaternion p1 = Quaternion::fromAxisAndAngle(1, 1, 0, 120);
+	compare("normalize", unit,
+			[](double v){ return Quaternion(v, 1, 2, 3).normalized().w; },
+			[](double v){ return Quaternion(v, 1, 2, 3).normalized< Fast >().w; });
+	compare("slerp", unit,
+			[&](double v){ return Quaternion::slerp(p0, p1, 0.5 + 0.49 * v).w; },
+			[&](double v){ return Quaternion::slerp< Fast >(p0, p1, 0.5 + 0.49 * v).w; });
+	compare("fromAxis", angle,
+			[](double v){ return Quaternion::fromAxisAndAngle(1, 2, 3, v).w; },
+			[](double v){ return Quaternion::fromAxisAndAngle< Fast >(1, 2, 3, v).w; });
+	return 0;
+}
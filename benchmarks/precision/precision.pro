@@ -0,0 +1,6 @@
+TARGET = bench_precision
+
+include(../benchmarks.pri)
+
+SOURCES += \
+    bench_precision.cpp
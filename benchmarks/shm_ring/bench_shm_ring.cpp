@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "shm_ring.h"
+#include "wire.h"
+#include "load_generator.h"
+#include "test_common.h"
+
+/// round trip of StructTelemetry to the child process and back:
+/// two shared memory rings against the unix socket with the wire framing
+
+namespace{
+
+const int count = 100000;
+
+bool read_all(int fd, char* data, size_t size){
+	while(size){
+		ssize_t res = ::read(fd, data, size);
+		if(res <= 0)
+			return false;
+		data += res;
+		size -= static_cast< size_t >(res);
+	}
+	return true;
+}
+
+bool write_all(int fd, const char* data, size_t size){
+	while(size){
+		ssize_t res = ::write(fd, data, size);
+		if(res <= 0)
+			return false;
+		data += res;
+		size -= static_cast< size_t >(res);
+	}
+	return true;
+}
+
+bool send_frame(int fd, const sc::StructTelemetry& telemetry, std::vector< char >& data, std::vector< char >& frame){
+	wire::encode(telemetry, data);
+	size_t size = data.size();
+	frame.resize(4);
+	frame[0] = static_cast< char >(size >> 24);
+	frame[1] = static_cast< char >(size >> 16);
+	frame[2] = static_cast< char >(size >> 8);
+	frame[3] = static_cast< char >(size);
+	frame.insert(frame.end(), data.begin(), data.end());
+	return write_all(fd, frame.data(), frame.size());
+}
+
+bool receive_frame(int fd, sc::StructTelemetry& telemetry, std::vector< char >& data){
+	unsigned char header[4];
+	if(!read_all(fd, reinterpret_cast< char* >(header), 4))
+		return false;
+	size_t size = (static_cast< size_t >(header[0]) << 24) | (header[1] << 16) | (header[2] << 8) | header[3];
+	data.resize(size);
+	return read_all(fd, data.data(), size) && wire::decode(data.data(), size, telemetry);
+}
+
+void print(const char* name, std::vector< long long >& rtt){
+	std::sort(rtt.begin(), rtt.end());
+	printf("%-12s rtt p50 %7lld ns  p99 %7lld ns  max %9lld ns\n", name,
+		   rtt[rtt.size() / 2], rtt[rtt.size() * 99 / 100], rtt.back());
+}
+
+}
+
+int main(int, char**){
+	sc::StructTelemetry telemetry, echo;
+	loadgen::SensorGenerator generator;
+	generator.next(telemetry);
+	std::vector< long long > rtt;
+	rtt.reserve(count);
+
+	/// shared memory: the parent writes to "ping", the child copies every frame to "pong"
+	{
+		shm::ShmRing ping;
+		if(!ping.create("/bench_ping", 1024)){
+			printf("shm is not available\n");
+			return 1;
+		}
+		pid_t pid = fork();
+		if(!pid){
+			shm::ShmRing pong, in;
+			pong.create("/bench_pong", 1024);
+			in.open("/bench_ping");
+			shm::ShmCursor cursor(in, true);
+			for(int i = 0; i < count; i++){
+				while(!cursor.read(echo))
+					cursor.wait();
+				pong.write(echo);
+			}
+			_exit(0);
+		}
+		shm::ShmRing pong;
+		while(!pong.open("/bench_pong"))
+			usleep(1000);
+		shm::ShmCursor cursor(pong, true);
+		for(int i = 0; i < count; i++){
+			long long start = test_common::now_ns();
+			telemetry.gyroscope.tick = i;
+			ping.write(telemetry);
+			while(!cursor.read(echo))
+				cursor.wait();
+			rtt.push_back(test_common::now_ns() - start);
+		}
+		waitpid(pid, 0, 0);
+		print("shm ring", rtt);
+		shm::ShmRing::remove("/bench_ping");
+		shm::ShmRing::remove("/bench_pong");
+	}
+
+	/// unix socket: the frames are encoded, sent, received and decoded on both sides
+	{
+		int sv[2];
+		if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+			return 1;
+		std::vector< char > data, frame;
+		pid_t pid = fork();
+		if(!pid){
+			for(int i = 0; i < count; i++){
+				if(!receive_frame(sv[1], echo, data) || !send_frame(sv[1], echo, data, frame))
+					break;
+			}
+			_exit(0);
+		}
+		rtt.clear();
+		for(int i = 0; i < count; i++){
+			long long start = test_common::now_ns();
+			telemetry.gyroscope.tick = i;
+			if(!send_frame(sv[0], telemetry, data, frame) || !receive_frame(sv[0], echo, data))
+				break;
+			rtt.push_back(test_common::now_ns() - start);
+		}
+		waitpid(pid, 0, 0);
+		print("unix socket", rtt);
+		close(sv[0]);
+		close(sv[1]);
+	}
+
+	/// the cost of the copy in and out of the ring in one process
+	{
+		shm::ShmRing ring, reader;
+		ring.create("/bench_copy", 4096);
+		reader.open("/bench_copy");
+		shm::ShmCursor cursor(reader);
+		const int frames = 1000000;
+		int received = 0;
+		long long start = test_common::now_ns();
+		for(int i = 0; i < frames; i++){
+			ring.write(telemetry);
+			if(cursor.read(echo))
+				received++;
+		}
+		printf("write+read   %.1f ns/frame (%d)\n", static_cast< double >(test_common::now_ns() - start) / frames, received);
+		shm::ShmRing::remove("/bench_copy");
+	}
+	return 0;
+}
@@ -0,0 +1,6 @@
+TARGET = bench_shm_ring
+
+include(../benchmarks.pri)
+
+SOURCES += \
+    bench_shm_ring.cpp
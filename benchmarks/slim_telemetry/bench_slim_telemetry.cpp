@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "slim_telemetry.h"
+#include "test_common.h"
+
+using namespace slim;
+
+/// memory and the scan of the history: std::vector< StructTelemetry > against
+/// SplitHistory and SlimHistory. the histories are built one after another,
+/// so the peak memory is of the largest one. usage: bench_slim_telemetry [samples]
+
+namespace{
+
+volatile double sink;
+
+sc::StructTelemetry sample(long long i){
+	sc::StructTelemetry res;
+	res.gyroscope.tick = i;
+	res.gyroscope.gyro = vector3_::Vector3i(static_cast< int >(i % 201) - 100, static_cast< int >(i % 37), -5);
+	res.gyroscope.accel = vector3_::Vector3i(static_cast< int >(i % 97), -static_cast< int >(i % 89), 16384 + static_cast< int >(i % 11));
+	res.height = static_cast< float >((i * 7) % 10007) * 0.01f;
+	res.tangaj = static_cast< float >(i % 90);
+	res.barometer.data = 101325 - static_cast< int >(i % 400);
+	res.barometer.tick = i / 20;
+	return res;
+}
+
+double ms(long long start, long long end){
+	return (end - start) / 1e6;
+}
+
+void report(const char* name, size_t memory, double build_ms, double scan_ms, double cold_ms, double result){
+	printf("%-16s %8.0f MB  build %7.0f ms  scan hot %6.1f ms", name, memory / 1048576.0, build_ms, scan_ms);
+	if(cold_ms >= 0)
+		printf("  scan cold %6.1f ms", cold_ms);
+	printf("  (%.0f)\n", result);
+}
+
+/// max(height) + sum(accel.z): the hot fields only
+template< typename Height, typename Accel >
+double scan(size_t count, Height height, Accel accel){
+	float max_height = 0;
+	long long sum = 0;
+	for(size_t i = 0; i < count; i++){
+		float h = height(i);
+		if(h > max_height)
+			max_height = h;
+		sum += accel(i);
+	}
+	return max_height + static_cast< double >(sum);
+}
+
+}
+
+int main(int argc, char** argv){
+	long long count = argc > 1? atoll(argv[1]) : 10000000;
+
+	{
+		long long start = test_common::now_ns();
+		std::vector< sc::StructTelemetry > full;
+		full.reserve(count);
+		for(long long i = 0; i < count; i++)
+			full.push_back(sample(i));
+		long long built = test_common::now_ns();
+		double result = scan(full.size(), [&](size_t i){ return full[i].height; },
+							 [&](size_t i){ return full[i].gyroscope.accel.data[2]; });
+		long long scanned = test_common::now_ns();
+		long long sum = 0;
+		for(const sc::StructTelemetry& t: full)
+			sum += t.barometer.data;
+		long long cold = test_common::now_ns();
+		sink = result + sum;
+		report("StructTelemetry", full.capacity() * sizeof(sc::StructTelemetry), ms(start, built),
+			   ms(built, scanned), ms(scanned, cold), result);
+	}
+	{
+		long long start = test_common::now_ns();
+		SplitHistory split;
+		split.reserve(count);
+		for(long long i = 0; i < count; i++)
+			split.push(sample(i));
+		long long built = test_common::now_ns();
+		const HotTelemetry* hot = split.hot_data();
+		double result = scan(split.size(), [&](size_t i){ return hot[i].height; },
+							 [&](size_t i){ return hot[i].accel[2]; });
+		long long scanned = test_common::now_ns();
+		long long sum = 0;
+		for(size_t i = 0; i < split.size(); i++)
+			sum += split.cold(i)->barometer;
+		long long cold = test_common::now_ns();
+		sink = result + sum;
+		report("SplitHistory", split.memory(), ms(start, built), ms(built, scanned), ms(scanned, cold), result);
+	}
+	{
+		long long start = test_common::now_ns();
+		SlimHistory slim;
+		slim.reserve(count);
+		for(long long i = 0; i < count; i++)
+			slim.push(sample(i));
+		long long built = test_common::now_ns();
+		const HotTelemetry* hot = slim.hot_data();
+		double result = scan(slim.size(), [&](size_t i){ return hot[i].height; },
+							 [&](size_t i){ return hot[i].accel[2]; });
+		long long scanned = test_common::now_ns();
+		sink = result;
+		report("SlimHistory", slim.memory(), ms(start, built), ms(built, scanned), -1, result);
+	}
+	return 0;
+}
@@ -0,0 +1,6 @@
+TARGET = bench_slim_telemetry
+
+include(../benchmarks.pri)
+
+SOURCES += \
+    bench_slim_telemetry.cpp
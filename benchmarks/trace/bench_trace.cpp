@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <vector>
+
+#include "wire.h"
+#include "trace.h"
+#include "replay.h"
+#include "load_generator.h"
+#include "test_common.h"
+
+/// the same source is built as bench_trace (WITH_TRACE) and bench_trace_off,
+/// the difference of the two runs is the cost of the stamps on the path
+
+namespace{
+
+const int count = 1024;
+const int rounds = 500;
+const int replay_loops = 200;
+
+volatile long long sink;
+
+/**
+ * @brief wire_path
+ * ns per frame of the sender and receiver side: encode with Encode,
+ * append the stamps, mark Receive, strip and decode with Decode
+ * @param frames
+ * @return
+ */
+double wire_path(const std::vector< sc::StructTelemetry >& frames){
+	std::vector< char > out;
+	sc::StructTelemetry value;
+	long long sum = 0;
+	long long start = test_common::now_ns();
+	for(int r = 0; r < rounds; r++){
+		for(const sc::StructTelemetry& frame: frames){
+			trace::TraceStamps sent;
+			sent.mark(trace::Sample);
+			wire::encode(frame, out, sent);
+			sent.mark(trace::Send);
+			trace::append(out, sent);
+
+			trace::TraceStamps received;
+			received.mark(trace::Receive);
+			sum += wire::decode(out.data(), out.size(), value, received);
+			sum += received.mask;
+		}
+	}
+	long long end = test_common::now_ns();
+	sink = sum;
+	return static_cast< double >(end - start) / (static_cast< double >(rounds) * frames.size());
+}
+
+/**
+ * @brief replay_path
+ * ns per frame of ReplayEngine at full speed to the callback decoding the frames
+ * @param frames
+ * @return
+ */
+double replay_path(const std::vector< sc::StructTelemetry >& frames){
+	replay::ReplayEngine engine;
+	FOREACH(i, static_cast< int >(frames.size()), engine.add(frames[i]));
+	engine.set_speed(0);
+
+	sc::StructTelemetry value;
+	long long sum = 0;
+	trace::LatencyCollector collector;
+	replay::ReplayStats stats = engine.run([&](const char* data, size_t size){
+		trace::TraceStamps stamps;
+		stamps.mark(trace::Receive);
+		bool res = wire::decode(data, size, value, stamps);
+		collector.add(stamps);
+		sum += value.gyroscope.tick;
+		return res;
+	}, replay_loops);
+	sink = sum;
+	return stats.frames? stats.elapsed_s * 1e9 / stats.frames : 0;
+}
+
+}
+
+int main(int, char**){
+	loadgen::SensorGenerator generator;
+	std::vector< sc::StructTelemetry > telemetry(count);
+	FOREACH(i, count, generator.next(telemetry[i]));
+
+	printf("trace %s\n", trace::enabled? "on (WITH_TRACE)" : "off");
+	printf("wire path    %7.1f ns/frame\n", wire_path(telemetry));
+	printf("replay path  %7.1f ns/frame\n", replay_path(telemetry));
+	return 0;
+}
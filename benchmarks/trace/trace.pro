@@ -0,0 +1,8 @@
+TARGET = bench_trace
+
+include(../benchmarks.pri)
+
+DEFINES += WITH_TRACE
+
+SOURCES += \
+    bench_trace.cpp
@@ -0,0 +1,6 @@
+TARGET = bench_trace_off
+
+include(../benchmarks.pri)
+
+SOURCES += \
+    ../trace/bench_trace.cpp
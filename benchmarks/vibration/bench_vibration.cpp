@@ -0,0 +1,65 @@
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+#include "vibration.h"
+#include "test_common.h"
+
+using namespace vibration;
+
+/// the cost on the vehicle: the fft alone and push() per sample of the gyroscope,
+/// which includes the six spectrums every hop samples
+
+namespace{
+
+const int samples = 1 << 16;
+const double budget_ns = 1e6;		/// one sample of the 1 kHz gyroscope
+
+volatile float sink;
+
+template< int N >
+void measure_fft(){
+	std::vector< float > x(N);
+	FOREACH(i, N, x[i] = static_cast< float >(sin(i * 0.37) + 0.3 * cos(i * 1.9)));
+	Fft_< N > fft;
+	float power[Fft_< N >::bins];
+	const int rounds = (1 << 22) / N;
+	long long start = test_common::now_ns();
+	for(int r = 0; r < rounds; r++){
+		x[r % N] += 1e-3f;
+		fft.power(x.data(), power);
+	}
+	long long end = test_common::now_ns();
+	sink = power[1];
+	printf("fft %5d          %8.0f ns\n", N, static_cast< double >(end - start) / rounds);
+}
+
+template< int N, int hop >
+void measure_push(){
+	std::vector< sc::StructGyroscope > data(samples);
+	for(int i = 0; i < samples; i++){
+		data[i].freq = 1000;
+		data[i].accel = vector3_::Vector3i(static_cast< int >(500 * sin(i * 0.55)), 20 * (i % 7), 16384);
+		data[i].gyro = vector3_::Vector3i(static_cast< int >(100 * sin(i * 1.3)), 0, 3 * (i % 5));
+	}
+	/// the analyzer is about 20 KB for 256: not on the stack
+	std::vector< VibrationAnalyzer_< N, hop > > analyzer(1);
+	long long start = test_common::now_ns();
+	size_t spectra = analyzer[0].push(data.data(), data.size());
+	long long end = test_common::now_ns();
+	sink = analyzer[0].peak(AccelX).frequency;
+	double ns = static_cast< double >(end - start) / samples;
+	printf("push %4d hop %4d %8.1f ns/sample  %.3f%% of 1 kHz  spectra %zu\n", N, hop, ns, 100 * ns / budget_ns, spectra);
+}
+
+}
+
+int main(int, char**){
+	measure_fft< 64 >();
+	measure_fft< 256 >();
+	measure_fft< 1024 >();
+	measure_push< 256, 128 >();
+	measure_push< 256, 256 >();
+	measure_push< 1024, 512 >();
+	return 0;
+}
@@ -0,0 +1,6 @@
+TARGET = bench_vibration
+
+include(../benchmarks.pri)
+
+SOURCES += \
+    bench_vibration.cpp
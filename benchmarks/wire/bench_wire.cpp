@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <vector>
+
+#include "wire.h"
+#include "load_generator.h"
+#include "test_common.h"
+
+namespace{
+
+const int count = 1024;
+const int rounds = 200;
+
+volatile long long sink;
+
+/**
+ * @brief measure
+ * ns per frame of func over the frames
+ * @param frames
+ * @param func
+ * @return
+ */
+template< typename T, typename F >
+double measure(const std::vector< T >& frames, F func){
+	long long sum = 0;
+	long long start = test_common::now_ns();
+	for(int r = 0; r < rounds; r++){
+		for(const T& frame: frames)
+			sum += func(frame);
+	}
+	long long end = test_common::now_ns();
+	sink = sum;
+	return static_cast< double >(end - start) / (static_cast< double >(rounds) * frames.size());
+}
+
+void print(const char* name, double stream, double native){
+	printf("%-18s stream %7.1f ns  native %6.1f ns  x%.1f\n", name, stream, native, stream / native);
+}
+
+/**
+ * @brief compare
+ * write_to/read_from against the native encoder and decoder
+ * @param name
+ * @param frames
+ */
+template< typename T >
+void compare(const char* name, const std::vector< T >& frames){
+	std::vector< char > out;
+	char label[64];
+
+	double stream = measure(frames, [&](const T& v){ wire::stream_encode(v, out); return out.size(); });
+	double native = measure(frames, [&](const T& v){ wire::encode(v, out); return out.size(); });
+	snprintf(label, sizeof(label), "%s encode", name);
+	print(label, stream, native);
+
+	std::vector< std::vector< char > > encoded(frames.size());
+	FOREACH(i, static_cast< int >(frames.size()), wire::encode(frames[i], encoded[i]));
+	std::vector< int > index(frames.size());
+	FOREACH(i, static_cast< int >(frames.size()), index[i] = i);
+	T value;
+	stream = measure(index, [&](int i){
+		return wire::stream_decode(encoded[i].data(), encoded[i].size(), value);
+	});
+	native = measure(index, [&](int i){
+		return wire::decode(encoded[i].data(), encoded[i].size(), value);
+	});
+	snprintf(label, sizeof(label), "%s decode", name);
+	print(label, stream, native);
+}
+
+}
+
+int main(int, char**){
+	loadgen::SensorGenerator generator;
+	std::vector< sc::StructTelemetry > telemetry(count);
+	std::vector< sc::StructControls > controls(count);
+	for(int i = 0; i < count; i++){
+		generator.next(telemetry[i]);
+		generator.controls(controls[i]);
+	}
+
+	compare("telemetry", telemetry);
+	compare("controls", controls);
+	return 0;
+}
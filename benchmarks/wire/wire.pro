@@ -0,0 +1,6 @@
+TARGET = bench_wire
+
+include(../benchmarks.pri)
+
+SOURCES += \
+    bench_wire.cpp
@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "zone_map.h"
+#include "wire.h"
+#include "load_generator.h"
+#include "test_common.h"
+
+/// the queries of ZoneMapReader against the full decode on the synthetic
+/// recording of the given size. the recording is written to the current
+/// directory and removed at the end; it is read from the page cache
+/// if it fits into the memory.
+/// bench_zone_map [megabytes = 2048] [path = bench_zone_map.rec]
+
+namespace{
+
+const int queries = 100;
+
+double ms(long long from, long long to){
+	return (to - from) / 1e6;
+}
+
+}
+
+int main(int argc, char** argv){
+	long long megabytes = argc > 1? atoll(argv[1]) : 2048;
+	std::string path = argc > 2? argv[2] : "bench_zone_map.rec";
+	if(megabytes < 1)
+		megabytes = 1;
+
+	/// the recording: telemetry of the generator and the controls at their rate
+	loadgen::SensorGenerator generator;
+	sc::StructTelemetry telemetry;
+	sc::StructControls controls;
+	zonemap::ZoneMapWriter writer;
+	if(!writer.open(path)){
+		printf("can not write %s\n", path.c_str());
+		return 0;
+	}
+	long long frames = 0, bytes = 0;
+	long long start = test_common::now_ns();
+	while(bytes < megabytes << 20){
+		int updated = generator.next(telemetry);
+		writer.write(telemetry);
+		frames++;
+		bytes += 16 + wire::telemetry_size;
+		if(updated & loadgen::SensorGenerator::ControlsDue){
+			generator.controls(controls);
+			writer.write(controls, telemetry.gyroscope.tick);
+			bytes += 16 + wire::controls_size;
+		}
+	}
+	bool written = writer.close();
+	long long end = test_common::now_ns();
+	printf("recording %lld MB, %lld telemetry, write with the index %.0f ms (%.0f MB/s)%s\n",
+		   bytes >> 20, frames, ms(start, end), (bytes >> 20) / (ms(start, end) / 1e3), written? "" : ", write error");
+
+	zonemap::ZoneMapReader reader;
+	if(!written || !reader.open(path)){
+		printf("can not open the index\n");
+		unlink(path.c_str());
+		unlink(zonemap::index_path(path).c_str());
+		return 0;
+	}
+	long long first = reader.block(0).min_tick, last = first;
+	float top = reader.block(0).max[aggregation::Height];
+	for(size_t i = 0; i < reader.blocks(); i++){
+		const zonemap::BlockSummary& b = reader.block(i);
+		if(!b.frames)
+			continue;
+		first = std::min(first, b.min_tick);
+		last = std::max(last, b.max_tick);
+		top = std::max(top, b.max[aggregation::Height]);
+	}
+
+	/// the full decode: every block is read, as without the index
+	std::vector< sc::StructTelemetry > block;
+	float v[aggregation::fields];
+	double sum = 0;
+	start = test_common::now_ns();
+	for(size_t i = 0; i < reader.blocks(); i++){
+		reader.read_block(i, block);
+		for(size_t j = 0; j < block.size(); j++){
+			aggregation::values(block[j], v);
+			sum += v[aggregation::Height];
+		}
+	}
+	end = test_common::now_ns();
+	double full = ms(start, end);
+	printf("full decode        %9.1f ms  %zu blocks (mean height %.2f)\n", full, reader.blocks(), sum / frames);
+
+	/// ranges of 1% of the recording
+	unsigned state = 1;
+	long long span = last - first + 1, width = span / 100 + 1;
+	long long decoded = reader.decoded_blocks();
+	start = test_common::now_ns();
+	for(int q = 0; q < queries; q++){
+		state = state * 1103515245u + 12345u;
+		long long from = first + static_cast< long long >((state >> 8) % static_cast< unsigned >(span - width + 1));
+		sum += reader.aggregate(aggregation::Height, from, from + width - 1).mean();
+	}
+	end = test_common::now_ns();
+	printf("aggregate 1%%       %9.3f ms  %.1f blocks decoded  x%.0f\n", ms(start, end) / queries,
+		   static_cast< double >(reader.decoded_blocks() - decoded) / queries, full / (ms(start, end) / queries));
+
+	/// the whole recording: only the summaries
+	decoded = reader.decoded_blocks();
+	start = test_common::now_ns();
+	zonemap::RangeResult all = reader.aggregate(aggregation::Height, first, last);
+	end = test_common::now_ns();
+	printf("aggregate all      %9.3f ms  %lld blocks decoded  (mean height %.2f)\n", ms(start, end),
+		   reader.decoded_blocks() - decoded, all.mean());
+
+	/// the rare values: the blocks are skipped by max
+	decoded = reader.decoded_blocks();
+	long long tick = 0;
+	bool found = false;
+	start = test_common::now_ns();
+	for(int q = 0; q < queries; q++)
+		found = reader.first_above(aggregation::Height, top - 0.01f, tick, first);
+	end = test_common::now_ns();
+	printf("first_above        %9.3f ms  %.1f blocks decoded  x%.0f%s\n", ms(start, end) / queries,
+		   static_cast< double >(reader.decoded_blocks() - decoded) / queries, full / (ms(start, end) / queries),
+		   found? "" : "  not found");
+
+	unlink(path.c_str());
+	unlink(zonemap::index_path(path).c_str());
+	return 0;
+}
@@ -0,0 +1,6 @@
+TARGET = bench_zone_map
+
+include(../benchmarks.pri)
+
+SOURCES += \
+    bench_zone_map.cpp
@@ -12,7 +12,7 @@
 
 namespace common_{
 
-const double epsilon = 1e-9;
+constexpr double epsilon = 1e-9;
 
 ///////////////////////////////////////////////
 /// \brief The ExceptionCustom class
@@ -46,9 +46,9 @@ public:
  * @param value
  * @return
  */
-static inline bool fIsNull(double value)
+static constexpr inline bool fIsNull(double value)
 {
-	return fabs(value) < epsilon;
+	return (value < 0 ? -value : value) < epsilon;
 }
 
 /**
@@ -57,7 +57,7 @@ static inline bool fIsNull(double value)
  * @param angle
  * @return
  */
-static inline double angle2rad(double angle)
+static constexpr inline double angle2rad(double angle)
 {
 	return angle * M_PI / 180.0;
 }
@@ -68,11 +68,102 @@ static inline double angle2rad(double angle)
  * @param rad
  * @return
  */
-static inline double rad2angle(double rad)
+static constexpr inline double rad2angle(double rad)
 {
 	return rad * 180.0 / M_PI;
 }
 
+/**
+ * @brief is_constant_evaluated
+ * true when called while the compiler evaluates a constant expression.
+ * if the compiler has no way to detect it returns false: the library functions
+ * are used at runtime, the constexpr fallbacks below only where the compiler
+ * folds them itself
+ * @return
+ */
+constexpr inline bool is_constant_evaluated()
+{
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+	return __builtin_is_constant_evaluated();
+#else
+	return false;
+#endif
+#elif defined(__GNUC__) && __GNUC__ >= 9
+	/// gcc 9 has the builtin but not __has_builtin
+	return __builtin_is_constant_evaluated();
+#else
+	return false;
+#endif
+}
+
+/**
+ * @brief cx_sqrt
+ * sqrt usable in constant expressions (newton iterations)
+ * @param value
+ * @return
+ */
+constexpr inline double cx_sqrt(double value)
+{
+	if(!is_constant_evaluated())
+		return sqrt(value);
+	if(value <= 0)
+		return 0;
+	double x = value < 1 ? 1 : value;
+	for(int i = 0; i < 2048; i++){
+		double next = 0.5 * (x + value / x);
+		if(next >= x)
+			break;
+		x = next;
+	}
+	return x;
+}
+
+/**
+ * @brief cx_sin
+ * sin usable in constant expressions (taylor series after reduction to [-pi; pi])
+ * @param rad
+ * @return
+ */
+constexpr inline double cx_sin(double rad)
+{
+	if(!is_constant_evaluated())
+		return sin(rad);
+	if(rad != rad || rad - rad != 0)
+		return rad - rad;					/// nan for nan and inf
+	const double pi2 = 2 * M_PI;
+	/// from 2^52 turns the step of rad is more than the period: the phase is lost,
+	/// and the turns would overflow long long further
+	const double max_turns = 4503599627370496.0;
+	double turns = rad / pi2;
+	if(!(turns < max_turns && turns > -max_turns))
+		return 0;
+	double x = rad - static_cast< double >(static_cast< long long >(turns)) * pi2;
+	if(x > M_PI)
+		x -= pi2;
+	if(x < -M_PI)
+		x += pi2;
+	double term = x, res = x;
+	for(int i = 1; i < 30; i++){
+		term *= -x * x / ((2 * i) * (2 * i + 1));
+		res += term;
+	}
+	return res;
+}
+
+/**
+ * @brief cx_cos
+ * cos usable in constant expressions
+ * @param rad
+ * @return
+ */
+constexpr inline double cx_cos(double rad)
+{
+	if(!is_constant_evaluated())
+		return cos(rad);
+	return cx_sin(rad + M_PI / 2);
+}
+
 }
 
 #endif // COMMON_
@@ -0,0 +1,188 @@
+#include <algorithm>
+
+#include "compass_heading.h"
+
+using namespace compass;
+
+namespace {
+
+/**
+ * @brief solve_linear
+ * gaussian elimination with partial pivoting; a and b are modified
+ */
+template< int n >
+bool solve_linear(double a[n][n], double b[n], double x[n])
+{
+	for(int col = 0; col < n; col++){
+		int pivot = col;
+		for(int r = col + 1; r < n; r++){
+			if(fabs(a[r][col]) > fabs(a[pivot][col]))
+				pivot = r;
+		}
+		if(fabs(a[pivot][col]) < 1e-12)
+			return false;
+		if(pivot != col){
+			FOREACH(j, n, std::swap(a[col][j], a[pivot][j]));
+			std::swap(b[col], b[pivot]);
+		}
+		for(int r = col + 1; r < n; r++){
+			double f = a[r][col] / a[col][col];
+			for(int j = col; j < n; j++)
+				a[r][j] -= f * a[col][j];
+			b[r] -= f * b[col];
+		}
+	}
+	for(int r = n - 1; r >= 0; r--){
+		double s = b[r];
+		for(int j = r + 1; j < n; j++)
+			s -= a[r][j] * x[j];
+		x[r] = s / a[r][r];
+	}
+	return true;
+}
+
+/**
+ * @brief eigen_symmetric
+ * jacobi rotations for symmetric 3x3 matrix: a = v * diag(d) * v^T
+ */
+void eigen_symmetric(const double m[3][3], double d[3], double v[3][3])
+{
+	double a[3][3];
+	FOREACH(i, 3, FOREACH(j, 3, a[i][j] = m[i][j]; v[i][j] = i == j? 1 : 0));
+	for(int sweep = 0; sweep < 50; sweep++){
+		double off = fabs(a[0][1]) + fabs(a[0][2]) + fabs(a[1][2]);
+		if(off < 1e-15)
+			break;
+		for(int p = 0; p < 2; p++){
+			for(int q = p + 1; q < 3; q++){
+				if(fabs(a[p][q]) < 1e-300)
+					continue;
+				double theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+				double t = (theta >= 0? 1 : -1) / (fabs(theta) + sqrt(theta * theta + 1));
+				double c = 1 / sqrt(t * t + 1), s = t * c;
+				for(int k = 0; k < 3; k++){
+					double akp = a[k][p], akq = a[k][q];
+					a[k][p] = c * akp - s * akq;
+					a[k][q] = s * akp + c * akq;
+				}
+				for(int k = 0; k < 3; k++){
+					double apk = a[p][k], aqk = a[q][k];
+					a[p][k] = c * apk - s * aqk;
+					a[q][k] = s * apk + c * aqk;
+				}
+				for(int k = 0; k < 3; k++){
+					double vkp = v[k][p], vkq = v[k][q];
+					v[k][p] = c * vkp - s * vkq;
+					v[k][q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+	FOREACH(i, 3, d[i] = a[i][i]);
+}
+
+}
+
+////////////////////////////////////////////////
+
+CompassCalibration::CompassCalibration()
+{
+	FOREACH(i, 3, FOREACH(j, 3, soft_iron[i][j] = i == j? 1 : 0));
+}
+
+////////////////////////////////////////////////
+
+CompassCalibrator::CompassCalibrator()
+{
+	reset();
+}
+
+void CompassCalibrator::reset()
+{
+	FOREACH(i, params, FOREACH(j, params, m_DtD[i][j] = 0));
+	FOREACH(i, params, m_Dt1[i] = 0);
+	m_scale = 0;
+	m_count = 0;
+}
+
+void CompassCalibrator::add(const vector3_::Vector3d &raw)
+{
+	if(m_scale == 0){
+		m_scale = raw.length();
+		if(m_scale == 0)
+			return;
+	}
+	/// samples are scaled to about 1 for the conditioning of the normal equations
+	double x = raw.x() / m_scale, y = raw.y() / m_scale, z = raw.z() / m_scale;
+	const double d[params] = {x * x, y * y, z * z, 2 * y * z, 2 * x * z, 2 * x * y, 2 * x, 2 * y, 2 * z};
+	for(int i = 0; i < params; i++){
+		for(int j = i; j < params; j++)
+			m_DtD[i][j] += d[i] * d[j];
+		m_Dt1[i] += d[i];
+	}
+	m_count++;
+}
+
+void CompassCalibrator::add(const sc::StructCompass &compass)
+{
+	add(vector3_::Vector3d(compass.data));
+}
+
+void CompassCalibrator::add(const vector3_::Vector3i *raw, size_t count)
+{
+	for(size_t i = 0; i < count; i++)
+		add(vector3_::Vector3d(raw[i]));
+}
+
+long long CompassCalibrator::count() const
+{
+	return m_count;
+}
+
+bool CompassCalibrator::solve(CompassCalibration &calibration) const
+{
+	if(m_count < params)
+		return false;
+
+	double a[params][params], b[params], beta[params];
+	for(int i = 0; i < params; i++){
+		for(int j = 0; j < params; j++)
+			a[i][j] = j >= i? m_DtD[i][j] : m_DtD[j][i];
+		b[i] = m_Dt1[i];
+	}
+	if(!solve_linear< params >(a, b, beta))
+		return false;
+
+	const double M[3][3] = {
+		{beta[0], beta[5], beta[4]},
+		{beta[5], beta[1], beta[3]},
+		{beta[4], beta[3], beta[2]}
+	};
+	double m3[3][3], u[3] = {beta[6], beta[7], beta[8]}, c[3];
+	FOREACH(i, 3, FOREACH(j, 3, m3[i][j] = M[i][j]));
+	if(!solve_linear< 3 >(m3, u, c))
+		return false;
+	FOREACH(i, 3, c[i] = -c[i]);
+
+	/// (x - c)^T M (x - c) = k
+	double k = 1;
+	FOREACH(i, 3, FOREACH(j, 3, k += c[i] * M[i][j] * c[j]));
+	if(k <= 0)
+		return false;
+
+	double A[3][3], d[3], v[3][3];
+	FOREACH(i, 3, FOREACH(j, 3, A[i][j] = M[i][j] / k));
+	eigen_symmetric(A, d, v);
+	if(d[0] <= 0 || d[1] <= 0 || d[2] <= 0)
+		return false;
+
+	/// mean radius of the ellipsoid in the scaled units
+	double radius = pow(d[0] * d[1] * d[2], -1.0 / 6.0);
+	FOREACH(i, 3, FOREACH(j, 3, {
+		double s = 0;
+		FOREACH(l, 3, s += v[i][l] * sqrt(d[l]) * v[j][l]);
+		calibration.soft_iron[i][j] = s * radius;
+	}));
+	calibration.hard_iron = vector3_::Vector3d(c[0], c[1], c[2]) * m_scale;
+	return true;
+}
@@ -0,0 +1,175 @@
+#ifndef COMPASS_HEADING_H
+#define COMPASS_HEADING_H
+
+#include <stddef.h>
+
+#include "common_.h"
+#include "vector3_.h"
+#include "quaternions.h"
+#include "precision.h"
+#include "struct_controls.h"
+
+namespace compass{
+
+/**
+ * @brief The CompassCalibration struct
+ * calibrated = soft_iron * (raw - hard_iron)
+ */
+struct CompassCalibration{
+	CompassCalibration();
+
+	inline vector3_::Vector3d apply(const vector3_::Vector3d& raw) const{
+		vector3_::Vector3d v = raw - hard_iron;
+		return vector3_::Vector3d(
+					soft_iron[0][0] * v.x() + soft_iron[0][1] * v.y() + soft_iron[0][2] * v.z(),
+					soft_iron[1][0] * v.x() + soft_iron[1][1] * v.y() + soft_iron[1][2] * v.z(),
+					soft_iron[2][0] * v.x() + soft_iron[2][1] * v.y() + soft_iron[2][2] * v.z());
+	}
+
+	vector3_::Vector3d hard_iron;
+	double soft_iron[3][3];
+};
+
+/**
+ * @brief heading_level
+ * heading in degrees [0; 360) of the field already rotated to the horizontal plane
+ */
+template< typename P >
+inline float heading_level(double xh, double yh)
+{
+	double h = common_::rad2angle(P::atan2(-yh, xh));
+	return static_cast< float >(h < 0? h + 360.0 : h);
+}
+
+/**
+ * @brief heading
+ * tilt compensated heading for tangaj and bank (degrees)
+ * @param mag - calibrated field in the sensor frame
+ * @param tangaj
+ * @param bank
+ * @return degrees [0; 360)
+ */
+template< typename P = precision::Exact >
+inline float heading(const vector3_::Vector3d& mag, double tangaj, double bank)
+{
+	double t = common_::angle2rad(tangaj), b = common_::angle2rad(bank);
+	double st = P::sin(t), ct = P::cos(t), sb = P::sin(b), cb = P::cos(b);
+	double xh = mag.x() * ct + (mag.y() * sb + mag.z() * cb) * st;
+	double yh = mag.y() * cb - mag.z() * sb;
+	return heading_level< P >(xh, yh);
+}
+
+/**
+ * @brief heading
+ * tilt compensated heading for the attitude (sensor to earth frame).
+ * yaw of the attitude is removed, so only its tilt is used
+ * @param mag - calibrated field in the sensor frame
+ * @param q
+ * @return degrees [0; 360)
+ */
+template< typename P = precision::Exact >
+inline float heading(const vector3_::Vector3d& mag, const quaternions::Quaternion& q)
+{
+	double q0 = q.w, q1 = q.x(), q2 = q.y(), q3 = q.z();
+	/// field in the earth frame
+	double ex = (1 - 2 * (q2 * q2 + q3 * q3)) * mag.x() + 2 * (q1 * q2 - q0 * q3) * mag.y() + 2 * (q1 * q3 + q0 * q2) * mag.z();
+	double ey = 2 * (q1 * q2 + q0 * q3) * mag.x() + (1 - 2 * (q1 * q1 + q3 * q3)) * mag.y() + 2 * (q2 * q3 - q0 * q1) * mag.z();
+	/// rotate back by the yaw of the attitude
+	double cy = 1 - 2 * (q2 * q2 + q3 * q3);
+	double sy = 2 * (q1 * q2 + q0 * q3);
+	double n = cy * cy + sy * sy;
+	n = n > 0? P::rsqrt(n) : 1;
+	cy *= n;
+	sy *= n;
+	return heading_level< P >(cy * ex + sy * ey, -sy * ex + cy * ey);
+}
+
+/**
+ * @brief headings
+ * batch of the headings with the attitudes
+ * @param mag - raw samples
+ * @param attitude
+ * @param calibration
+ * @param out - degrees
+ * @param count
+ */
+template< typename P = precision::Exact >
+void headings(const vector3_::Vector3i* mag, const quaternions::Quaternion* attitude,
+			  const CompassCalibration& calibration, float* out, size_t count)
+{
+	for(size_t i = 0; i < count; i++)
+		out[i] = heading< P >(calibration.apply(vector3_::Vector3d(mag[i])), attitude[i]);
+}
+
+/**
+ * @brief headings
+ * batch of the headings with tangaj and bank (degrees)
+ * @param mag - raw samples
+ * @param tangaj
+ * @param bank
+ * @param calibration
+ * @param out - degrees
+ * @param count
+ */
+template< typename P = precision::Exact >
+void headings(const vector3_::Vector3i* mag, const float* tangaj, const float* bank,
+			  const CompassCalibration& calibration, float* out, size_t count)
+{
+	for(size_t i = 0; i < count; i++)
+		out[i] = heading< P >(calibration.apply(vector3_::Vector3d(mag[i])), tangaj[i], bank[i]);
+}
+
+/**
+ * @brief headings
+ * course of the recorded telemetry from its compass, tangaj and bank
+ * @param telemetry
+ * @param calibration
+ * @param count
+ */
+template< typename P = precision::Exact >
+void headings(sc::StructTelemetry* telemetry, const CompassCalibration& calibration, size_t count)
+{
+	for(size_t i = 0; i < count; i++){
+		sc::StructTelemetry& st = telemetry[i];
+		st.course = heading< P >(calibration.apply(vector3_::Vector3d(st.compass.data)), st.tangaj, st.bank);
+	}
+}
+
+//////////////////////////////////////////////////
+/// \brief The CompassCalibrator class
+/// streaming fit of the ellipsoid x^T M x + 2 u^T x = 1 by least squares.
+/// only the normal equations (9x9) are accumulated, the samples are not stored.
+/// the vehicle should be rotated in all directions during the collection
+class CompassCalibrator{
+public:
+	enum{
+		params = 9
+	};
+
+	CompassCalibrator();
+
+	void reset();
+	void add(const vector3_::Vector3d& raw);
+	void add(const sc::StructCompass& compass);
+	void add(const vector3_::Vector3i* raw, size_t count);
+	long long count() const;
+
+	/**
+	 * @brief solve
+	 * hard and soft iron from the collected data. the calibrated field
+	 * lies on the sphere with the mean radius of the ellipsoid
+	 * @param calibration
+	 * @return false if the data is not enough or degenerate
+	 */
+	bool solve(CompassCalibration& calibration) const;
+
+private:
+	double m_DtD[params][params];
+	double m_Dt1[params];
+	double m_scale;
+	long long m_count;
+};
+
+}
+
+#endif // COMPASS_HEADING_H
@@ -0,0 +1,206 @@
+#include "coro_io.h"
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+using namespace coro;
+
+namespace {
+
+/// frame bigger than it is the error of the stream
+const size_t max_frame = 1 << 20;
+const size_t read_chunk = 16 * 1024;
+const int max_events = 64;
+
+}
+
+////////////////////////////////////////////////
+
+/**
+ * @brief The Executor::Detached struct
+ * the coroutine which owns the spawned task and destroys itself at the end
+ */
+struct Executor::Detached{
+	struct promise_type{
+		Detached get_return_object(){ return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void(){}
+		void unhandled_exception(){ std::terminate(); }
+	};
+};
+
+Executor::Executor()
+{
+	m_epoll = epoll_create1(EPOLL_CLOEXEC);
+	m_active = 0;
+	m_errors = 0;
+}
+
+Executor::~Executor()
+{
+	close(m_epoll);
+}
+
+void Executor::spawn(Task &&task)
+{
+	m_active++;
+	detach(this, std::move(task));
+}
+
+Executor::Detached Executor::detach(Executor *executor, Task task)
+{
+	try{
+		co_await task;
+	}catch(...){
+		executor->m_errors++;
+	}
+	executor->m_active--;
+}
+
+void Executor::run()
+{
+	epoll_event events[max_events];
+	while(m_active){
+		int n = epoll_wait(m_epoll, events, max_events, -1);
+		if(n < 0){
+			if(errno == EINTR)
+				continue;
+			break;
+		}
+		for(int i = 0; i < n; i++){
+			int fd = events[i].data.fd;
+			unsigned ev = events[i].events;
+			bool failed = ev & (EPOLLERR | EPOLLHUP);
+			/// the map may be changed by the resumed coroutine, so it is searched again
+			if(ev & (EPOLLIN | EPOLLRDHUP) || failed){
+				std::unordered_map< int, Waiters >::iterator it = m_waiters.find(fd);
+				if(it != m_waiters.end() && it->second.reader){
+					std::coroutine_handle<> h = std::exchange(it->second.reader, nullptr);
+					h.resume();
+				}
+			}
+			if(ev & EPOLLOUT || failed){
+				std::unordered_map< int, Waiters >::iterator it = m_waiters.find(fd);
+				if(it != m_waiters.end() && it->second.writer){
+					std::coroutine_handle<> h = std::exchange(it->second.writer, nullptr);
+					h.resume();
+				}
+			}
+		}
+	}
+}
+
+void Executor::forget(int fd)
+{
+	if(m_waiters.erase(fd))
+		epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, 0);
+}
+
+size_t Executor::active() const
+{
+	return m_active;
+}
+
+size_t Executor::errors() const
+{
+	return m_errors;
+}
+
+void Executor::wait(int fd, bool write, std::coroutine_handle<> handle)
+{
+	std::unordered_map< int, Waiters >::iterator it = m_waiters.find(fd);
+	if(it == m_waiters.end()){
+		/// edge triggered: the coroutine waits only after EAGAIN, so the next edge is not lost
+		epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+		ev.data.fd = fd;
+		epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev);
+		it = m_waiters.emplace(fd, Waiters()).first;
+	}
+	if(write)
+		it->second.writer = handle;
+	else
+		it->second.reader = handle;
+}
+
+////////////////////////////////////////////////
+
+FrameStream::FrameStream(Executor &executor, int fd)
+	: m_executor(executor)
+	, m_fd(fd)
+{
+	m_in.resize(read_chunk);
+	m_pos = 0;
+	m_used = 0;
+}
+
+int FrameStream::fd() const
+{
+	return m_fd;
+}
+
+TaskBool FrameStream::next_frame(size_t &size)
+{
+	for(;;){
+		if(m_used - m_pos >= 4){
+			const unsigned char* d = reinterpret_cast< const unsigned char* >(&m_in[m_pos]);
+			size = (static_cast< size_t >(d[0]) << 24) | (d[1] << 16) | (d[2] << 8) | d[3];
+			if(size > max_frame)
+				co_return false;
+			if(m_used - m_pos - 4 >= size)
+				co_return true;
+		}
+		/// the consumed frames are dropped before the buffer grows
+		if(m_pos){
+			memmove(&m_in[0], &m_in[m_pos], m_used - m_pos);
+			m_used -= m_pos;
+			m_pos = 0;
+		}
+		if(m_in.size() - m_used < read_chunk / 4)
+			m_in.resize(m_in.size() * 2);
+
+		ssize_t res = ::read(m_fd, &m_in[m_used], m_in.size() - m_used);
+		if(res > 0){
+			m_used += static_cast< size_t >(res);
+			continue;
+		}
+		if(res == 0)
+			co_return false;
+		if(errno == EINTR)
+			continue;
+		if(errno != EAGAIN && errno != EWOULDBLOCK)
+			co_return false;
+		co_await m_executor.readable(m_fd);
+	}
+}
+
+TaskBool FrameStream::write_framed()
+{
+	size_t size = m_frame.size();
+	m_out.resize(4 + size);
+	m_out[0] = static_cast< char >((size >> 24) & 0xff);
+	m_out[1] = static_cast< char >((size >> 16) & 0xff);
+	m_out[2] = static_cast< char >((size >> 8) & 0xff);
+	m_out[3] = static_cast< char >(size & 0xff);
+	if(size)
+		memcpy(&m_out[4], &m_frame[0], size);
+
+	size_t pos = 0;
+	while(pos < m_out.size()){
+		ssize_t res = ::write(m_fd, &m_out[pos], m_out.size() - pos);
+		if(res >= 0){
+			pos += static_cast< size_t >(res);
+			continue;
+		}
+		if(errno == EINTR)
+			continue;
+		if(errno != EAGAIN && errno != EWOULDBLOCK)
+			co_return false;
+		co_await m_executor.writable(m_fd);
+	}
+	co_return true;
+}
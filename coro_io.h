@@ -0,0 +1,291 @@
+#ifndef CORO_IO_H
+#define CORO_IO_H
+
+/// the coroutines require c++20: include coro_io.pri after struct_controls.pri
+
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "coro_io requires c++20 coroutines (CONFIG += c++2a, see coro_io.pri)"
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+#include <vector>
+#include <unordered_map>
+#include <stddef.h>
+
+#include "wire.h"
+#include "trace.h"
+
+namespace coro{
+
+namespace detail{
+
+struct FinalAwaiter{
+	bool await_ready() noexcept { return false; }
+	template< typename P >
+	std::coroutine_handle<> await_suspend(std::coroutine_handle< P > handle) noexcept{
+		std::coroutine_handle<> next = handle.promise().continuation;
+		return next? next : std::noop_coroutine();
+	}
+	void await_resume() noexcept {}
+};
+
+struct PromiseBase{
+	std::coroutine_handle<> continuation;
+	std::exception_ptr error;
+
+	std::suspend_always initial_suspend() noexcept { return {}; }
+	FinalAwaiter final_suspend() noexcept { return {}; }
+	void unhandled_exception(){ error = std::current_exception(); }
+};
+
+}
+
+//////////////////////////////////////////////////
+/// \brief The Task_ class
+/// lazy coroutine: starts when it is awaited and resumes the awaiting
+/// coroutine when finished (symmetric transfer, the stack does not grow)
+template< typename T >
+class Task_{
+public:
+	struct promise_type: detail::PromiseBase{
+		T value;
+
+		Task_ get_return_object(){
+			return Task_(std::coroutine_handle< promise_type >::from_promise(*this));
+		}
+		void return_value(T v){
+			value = std::move(v);
+		}
+	};
+
+	Task_(Task_&& other) noexcept: m_handle(std::exchange(other.m_handle, nullptr)){}
+	Task_(const Task_&) = delete;
+	Task_& operator=(const Task_&) = delete;
+	~Task_(){
+		if(m_handle)
+			m_handle.destroy();
+	}
+
+	bool await_ready() const noexcept { return false; }
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept{
+		m_handle.promise().continuation = awaiting;
+		return m_handle;
+	}
+	T await_resume(){
+		if(m_handle.promise().error)
+			std::rethrow_exception(m_handle.promise().error);
+		return std::move(m_handle.promise().value);
+	}
+
+private:
+	std::coroutine_handle< promise_type > m_handle;
+
+	explicit Task_(std::coroutine_handle< promise_type > handle): m_handle(handle){}
+};
+
+template<>
+class Task_< void >{
+public:
+	struct promise_type: detail::PromiseBase{
+		Task_ get_return_object(){
+			return Task_(std::coroutine_handle< promise_type >::from_promise(*this));
+		}
+		void return_void(){}
+	};
+
+	Task_(Task_&& other) noexcept: m_handle(std::exchange(other.m_handle, nullptr)){}
+	Task_(const Task_&) = delete;
+	Task_& operator=(const Task_&) = delete;
+	~Task_(){
+		if(m_handle)
+			m_handle.destroy();
+	}
+
+	bool await_ready() const noexcept { return false; }
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept{
+		m_handle.promise().continuation = awaiting;
+		return m_handle;
+	}
+	void await_resume(){
+		if(m_handle.promise().error)
+			std::rethrow_exception(m_handle.promise().error);
+	}
+
+private:
+	std::coroutine_handle< promise_type > m_handle;
+
+	explicit Task_(std::coroutine_handle< promise_type > handle): m_handle(handle){}
+};
+
+typedef Task_< void > Task;
+typedef Task_< bool > TaskBool;
+
+//////////////////////////////////////////////////
+/// \brief The Executor class
+/// single thread event loop (linux, epoll). the coroutines wait for the
+/// readiness of the descriptors and are resumed from run()
+class Executor{
+public:
+	struct IoAwaiter{
+		Executor* executor;
+		int fd;
+		bool write;
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle){
+			executor->wait(fd, write, handle);
+		}
+		void await_resume() const noexcept {}
+	};
+
+	Executor();
+	~Executor();
+
+	/**
+	 * @brief spawn
+	 * start the task; it is owned by the executor until finished
+	 * @param task
+	 */
+	void spawn(Task&& task);
+	/**
+	 * @brief run
+	 * resume the coroutines until all spawned tasks are finished
+	 */
+	void run();
+
+	/**
+	 * @brief readable
+	 * co_await executor.readable(fd) after read() returned EAGAIN
+	 */
+	IoAwaiter readable(int fd){ return IoAwaiter{this, fd, false}; }
+	IoAwaiter writable(int fd){ return IoAwaiter{this, fd, true}; }
+	/**
+	 * @brief forget
+	 * must be called before the descriptor is closed
+	 * @param fd
+	 */
+	void forget(int fd);
+
+	/**
+	 * @brief active
+	 * @return count of the not finished tasks
+	 */
+	size_t active() const;
+	/**
+	 * @brief errors
+	 * @return count of the tasks finished by the exception
+	 */
+	size_t errors() const;
+
+private:
+	struct Waiters{
+		std::coroutine_handle<> reader;
+		std::coroutine_handle<> writer;
+	};
+
+	int m_epoll;
+	size_t m_active;
+	size_t m_errors;
+	std::unordered_map< int, Waiters > m_waiters;
+
+	void wait(int fd, bool write, std::coroutine_handle<> handle);
+
+	struct Detached;
+	static Detached detach(Executor* executor, Task task);
+};
+
+//////////////////////////////////////////////////
+/// \brief The FrameStream class
+/// frames of [size uint32 big endian][write_to] over the nonblocking descriptor
+/// (the framing of ReplayEngine and IngestServer). the buffers are kept between
+/// the frames. one coroutine may read and another write at the same time.
+/// the returned task must be awaited at once: the value is taken by reference
+class FrameStream{
+public:
+	FrameStream(Executor& executor, int fd);
+
+	int fd() const;
+
+	/**
+	 * @brief read_frame
+	 * co_await stream.read_frame(telemetry)
+	 * @param value - StructTelemetry, StructControls...
+	 * @return false at the end of the stream or on the error
+	 */
+	template< typename T >
+	TaskBool read_frame(T& value){
+		size_t size = 0;
+		if(!co_await next_frame(size))
+			co_return false;
+		bool res = wire::decode(&m_in[m_pos + 4], size, value);
+		m_pos += 4 + size;
+		co_return res;
+	}
+	/**
+	 * @brief write_frame
+	 * co_await stream.write_frame(controls)
+	 * @param value
+	 * @return false on the error
+	 */
+	template< typename T >
+	TaskBool write_frame(const T& value){
+		wire::encode(value, m_frame);
+		co_return co_await write_framed();
+	}
+	/**
+	 * @brief read_frame
+	 * read_frame with the stamps of the sender; Receive and Decode are marked (WITH_TRACE)
+	 * @param value
+	 * @param stamps
+	 * @return
+	 */
+	template< typename T >
+	TaskBool read_frame(T& value, trace::TraceStamps& stamps){
+		size_t size = 0;
+		if(!co_await next_frame(size))
+			co_return false;
+		if(trace::enabled){
+			stamps = trace::TraceStamps();
+			stamps.mark(trace::Receive);
+		}
+		bool res = wire::decode(&m_in[m_pos + 4], size, value, stamps);
+		m_pos += 4 + size;
+		co_return res;
+	}
+	/**
+	 * @brief write_frame
+	 * write_frame with the stamps: Encode and Send are marked and appended to the frame (WITH_TRACE)
+	 * @param value
+	 * @param stamps - Sample may be marked by the caller
+	 * @return
+	 */
+	template< typename T >
+	TaskBool write_frame(const T& value, trace::TraceStamps& stamps){
+		wire::encode(value, m_frame, stamps);
+		stamps.mark(trace::Send);
+		trace::append(m_frame, stamps);
+		co_return co_await write_framed();
+	}
+
+private:
+	Executor& m_executor;
+	int m_fd;
+	std::vector< char > m_in;
+	size_t m_pos;
+	size_t m_used;
+	std::vector< char > m_frame;
+	std::vector< char > m_out;
+
+	/**
+	 * @brief next_frame
+	 * read until the whole frame is at m_pos
+	 */
+	TaskBool next_frame(size_t& size);
+	TaskBool write_framed();
+};
+
+}
+
+#endif // CORO_IO_H
@@ -0,0 +1,7 @@
+# coroutine frame reader/writer, include after struct_controls.pri:
+# the whole project is built as c++20
+CONFIG -= c++14
+CONFIG += c++2a
+
+HEADERS += $$PWD/coro_io.h
+SOURCES += $$PWD/coro_io.cpp
@@ -64,10 +64,10 @@ datastream::~datastream()
 
 int datastream::readRawData(char *data, int len)
 {
-	m_stream->readRawData(data, len);
+	return m_stream->readRawData(data, len);
 }
 
 int datastream::writeRawData(char *data, int len)
 {
-	m_stream->writeRawData(data, len);
+	return m_stream->writeRawData(data, len);
 }
@@ -11,6 +11,9 @@ public:
 	enum byteorder{bigendian, littleendian};
 	basicstream(): m_byteorder(bigendian){
 
+	}
+	virtual ~basicstream(){
+
 	}
 
 	/**
@@ -19,14 +22,14 @@ public:
 	 * @param len
 	 * @return
 	 */
-	virtual int readRawData(char* data, int len) {}
+	virtual int readRawData(char* data, int len) { return 0; }
 	/**
 	 * @brief writeRawData
 	 * @param data
 	 * @param len
 	 * @return
 	 */
-	virtual int writeRawData(char* data, int len) {}
+	virtual int writeRawData(char* data, int len) { return 0; }
 	/**
 	 * @brief pos
 	 * @return
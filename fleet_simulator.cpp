@@ -0,0 +1,456 @@
+#include "fleet_simulator.h"
+
+#include <thread>
+#include <algorithm>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+using namespace sim;
+
+namespace {
+
+const double gravity = 9.80665;
+const double gyro_lsb = 32768.0 / 250.0;		/// LSB per degree/s, fs_sel 0
+const double accel_lsb = 16384.0;				/// LSB per g, afs_sel 0
+const double compass_lsb = 1090.0;				/// LSB per gauss of hmc5883l
+const double field_horizontal = 0.25;			/// gauss, to the north (x of the world)
+const double field_vertical = 0.433;			/// gauss, down
+const double ticks_per_second = 1000;
+const int lanes = 4;
+
+/// four values of the same field of four vehicles
+#ifdef __SSE__
+struct Pack{
+	__m128 v;
+
+	Pack(){}
+	Pack(__m128 value): v(value){}
+	Pack(float value): v(_mm_set1_ps(value)){}
+
+	static inline Pack load(const float* data){
+		return Pack(_mm_loadu_ps(data));
+	}
+	inline void store(float* data) const{
+		_mm_storeu_ps(data, v);
+	}
+};
+
+inline Pack operator+ (Pack a, Pack b){ return Pack(_mm_add_ps(a.v, b.v)); }
+inline Pack operator- (Pack a, Pack b){ return Pack(_mm_sub_ps(a.v, b.v)); }
+inline Pack operator* (Pack a, Pack b){ return Pack(_mm_mul_ps(a.v, b.v)); }
+inline Pack operator/ (Pack a, Pack b){ return Pack(_mm_div_ps(a.v, b.v)); }
+inline Pack sqrt(Pack a){ return Pack(_mm_sqrt_ps(a.v)); }
+inline Pack max(Pack a, Pack b){ return Pack(_mm_max_ps(a.v, b.v)); }
+/// a < b ? x : y
+inline Pack select_less(Pack a, Pack b, Pack x, Pack y){
+	__m128 m = _mm_cmplt_ps(a.v, b.v);
+	return Pack(_mm_or_ps(_mm_and_ps(m, x.v), _mm_andnot_ps(m, y.v)));
+}
+#else
+struct Pack{
+	float v[lanes];
+
+	Pack(){}
+	Pack(float value){
+		FOREACH(i, lanes, v[i] = value);
+	}
+
+	static inline Pack load(const float* data){
+		Pack res;
+		FOREACH(i, lanes, res.v[i] = data[i]);
+		return res;
+	}
+	inline void store(float* data) const{
+		FOREACH(i, lanes, data[i] = v[i]);
+	}
+};
+
+inline Pack operator+ (Pack a, Pack b){ Pack r; FOREACH(i, lanes, r.v[i] = a.v[i] + b.v[i]); return r; }
+inline Pack operator- (Pack a, Pack b){ Pack r; FOREACH(i, lanes, r.v[i] = a.v[i] - b.v[i]); return r; }
+inline Pack operator* (Pack a, Pack b){ Pack r; FOREACH(i, lanes, r.v[i] = a.v[i] * b.v[i]); return r; }
+inline Pack operator/ (Pack a, Pack b){ Pack r; FOREACH(i, lanes, r.v[i] = a.v[i] / b.v[i]); return r; }
+inline Pack sqrt(Pack a){ Pack r; FOREACH(i, lanes, r.v[i] = sqrtf(a.v[i])); return r; }
+inline Pack max(Pack a, Pack b){ Pack r; FOREACH(i, lanes, r.v[i] = a.v[i] > b.v[i]? a.v[i] : b.v[i]); return r; }
+inline Pack select_less(Pack a, Pack b, Pack x, Pack y){
+	Pack r;
+	FOREACH(i, lanes, r.v[i] = a.v[i] < b.v[i]? x.v[i] : y.v[i]);
+	return r;
+}
+#endif
+
+inline unsigned long long mix64(unsigned long long x)
+{
+	/// splitmix64
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+inline int to_int(double value)
+{
+	return static_cast< int >(value < 0? value - 0.5 : value + 0.5);
+}
+
+}
+
+////////////////////////////////////////////////
+
+VehicleParams::VehicleParams()
+{
+	mass = 1.2;
+	arm = 0.25;
+	/// hover at the power 0.5
+	max_thrust = 2 * mass * gravity / sc::cnt_engines;
+	yaw_torque = 0.016;
+	inertia[0] = 0.015;
+	inertia[1] = 0.015;
+	inertia[2] = 0.026;
+	motor_tau = 0.03;
+	drag = 0.25;
+	angular_drag = 0.005;
+}
+
+SensorNoise::SensorNoise()
+{
+	gyro = 4;
+	accel = 40;
+	compass = 2;
+	pressure = 3;
+}
+
+////////////////////////////////////////////////
+
+FleetSimulator::FleetSimulator(size_t vehicles, double dt, int threads, unsigned long long seed)
+{
+	if(threads <= 0)
+		threads = std::max(1, static_cast< int >(std::thread::hardware_concurrency()));
+	m_vehicles = vehicles;
+	m_stride = (vehicles + lanes - 1) / lanes * lanes;
+	m_dt = dt > 0? dt : 0.001;
+	m_threads = threads;
+	m_seed = seed;
+	m_steps = 0;
+	m_state.assign(fields * m_stride, 0);
+	m_power_on.assign(m_stride, false);
+	/// the padding vehicles are simulated too, they must have the valid attitude
+	for(size_t i = 0; i < m_stride; i++)
+		reset(i);
+
+	m_generation = 0;
+	m_count = 0;
+	m_pending = 0;
+	m_stop = false;
+	size_t groups = m_stride / lanes;
+	size_t ranges = std::max< size_t >(1, std::min(static_cast< size_t >(m_threads), groups));
+	for(size_t r = 0; r <= ranges; r++)
+		m_ranges.push_back(groups * r / ranges * lanes);
+	for(size_t r = 1; r < ranges; r++)
+		m_workers.push_back(std::thread(&FleetSimulator::work, this, r));
+}
+
+FleetSimulator::~FleetSimulator()
+{
+	{
+		std::lock_guard< std::mutex > lock(m_mutex);
+		m_stop = true;
+	}
+	m_start.notify_all();
+	for(size_t i = 0; i < m_workers.size(); i++)
+		m_workers[i].join();
+}
+
+size_t FleetSimulator::vehicles() const
+{
+	return m_vehicles;
+}
+
+double FleetSimulator::dt() const
+{
+	return m_dt;
+}
+
+int FleetSimulator::threads() const
+{
+	return m_threads;
+}
+
+long long FleetSimulator::steps() const
+{
+	return m_steps;
+}
+
+double FleetSimulator::time() const
+{
+	return m_steps * m_dt;
+}
+
+void FleetSimulator::set_params(const VehicleParams &params)
+{
+	m_params = params;
+}
+
+const VehicleParams &FleetSimulator::params() const
+{
+	return m_params;
+}
+
+void FleetSimulator::set_noise(const SensorNoise &noise)
+{
+	m_noise = noise;
+}
+
+void FleetSimulator::reset(size_t vehicle, const vector3_::Vector3d &position, const quaternions::Quaternion &attitude)
+{
+	quaternions::Quaternion q = attitude.normalized();
+	for(int f = 0; f < fields; f++)
+		at(f, vehicle) = 0;
+	at(PX, vehicle) = static_cast< float >(position.x());
+	at(PY, vehicle) = static_cast< float >(position.y());
+	at(PZ, vehicle) = static_cast< float >(position.z());
+	at(QW, vehicle) = static_cast< float >(q.w);
+	at(QX, vehicle) = static_cast< float >(q.x());
+	at(QY, vehicle) = static_cast< float >(q.y());
+	at(QZ, vehicle) = static_cast< float >(q.z());
+	m_power_on[vehicle] = false;
+}
+
+void FleetSimulator::set_controls(size_t vehicle, const sc::StructControls &controls)
+{
+	float power[sc::cnt_engines];
+	m_mixer.mix(controls, power);
+	FOREACH(e, sc::cnt_engines, at(Command + e, vehicle) = power[e]);
+	m_power_on[vehicle] = controls.power_on;
+}
+
+void FleetSimulator::set_controls(const sc::StructControls *controls)
+{
+	std::vector< float > power(m_vehicles * sc::cnt_engines);
+	if(!power.empty())
+		m_mixer.mix(controls, &power[0], m_vehicles);
+	for(size_t i = 0; i < m_vehicles; i++){
+		FOREACH(e, sc::cnt_engines, at(Command + e, i) = power[i * sc::cnt_engines + e]);
+		m_power_on[i] = controls[i].power_on;
+	}
+}
+
+void FleetSimulator::step(int count)
+{
+	if(count <= 0)
+		return;
+	if(m_workers.empty()){
+		step_range(0, m_stride, count);
+		m_steps += count;
+		return;
+	}
+	{
+		std::lock_guard< std::mutex > lock(m_mutex);
+		m_count = count;
+		m_pending = static_cast< int >(m_workers.size());
+		m_generation++;
+	}
+	m_start.notify_all();
+	step_range(m_ranges[0], m_ranges[1], count);
+	/// the barrier: the state of all ranges is written before the return
+	std::unique_lock< std::mutex > lock(m_mutex);
+	m_done.wait(lock, [this]{ return m_pending == 0; });
+	m_steps += count;
+}
+
+vector3_::Vector3d FleetSimulator::position(size_t vehicle) const
+{
+	return vector3_::Vector3d(at(PX, vehicle), at(PY, vehicle), at(PZ, vehicle));
+}
+
+vector3_::Vector3d FleetSimulator::velocity(size_t vehicle) const
+{
+	return vector3_::Vector3d(at(VX, vehicle), at(VY, vehicle), at(VZ, vehicle));
+}
+
+quaternions::Quaternion FleetSimulator::attitude(size_t vehicle) const
+{
+	return quaternions::Quaternion(at(QX, vehicle), at(QY, vehicle), at(QZ, vehicle), at(QW, vehicle));
+}
+
+vector3_::Vector3d FleetSimulator::angular_velocity(size_t vehicle) const
+{
+	return vector3_::Vector3d(at(WX, vehicle), at(WY, vehicle), at(WZ, vehicle));
+}
+
+void FleetSimulator::telemetry(size_t vehicle, sc::StructTelemetry &telemetry) const
+{
+	quaternions::Quaternion q = attitude(vehicle);
+	double w = q.w, x = q.x(), y = q.y(), z = q.z();
+	double tangaj = common_::rad2angle(asin(std::max(-1.0, std::min(1.0, 2 * (w * y - x * z)))));
+	double bank = common_::rad2angle(atan2(2 * (y * z + w * x), 1 - 2 * (x * x + y * y)));
+	double course = common_::rad2angle(atan2(2 * (x * y + w * z), 1 - 2 * (y * y + z * z)));
+	if(course < 0)
+		course += 360;
+	quaternions::Quaternion inv = q.conj();
+	long long tick = static_cast< long long >(time() * ticks_per_second);
+
+	sc::StructGyroscope& g = telemetry.gyroscope;
+	vector3_::Vector3d rate = angular_velocity(vehicle);
+	g.gyro = vector3_::Vector3i(to_int(common_::rad2angle(rate.x()) * gyro_lsb + m_noise.gyro * noise(vehicle, 0)),
+								to_int(common_::rad2angle(rate.y()) * gyro_lsb + m_noise.gyro * noise(vehicle, 1)),
+								to_int(common_::rad2angle(rate.z()) * gyro_lsb + m_noise.gyro * noise(vehicle, 2)));
+	/// the specific force: the accelerometer at rest measures +g up
+	vector3_::Vector3d force = inv.rotatedVector(vector3_::Vector3d(at(AX, vehicle), at(AY, vehicle), at(AZ, vehicle) + gravity));
+	double ka = accel_lsb / gravity;
+	g.accel = vector3_::Vector3i(to_int(force.x() * ka + m_noise.accel * noise(vehicle, 3)),
+								 to_int(force.y() * ka + m_noise.accel * noise(vehicle, 4)),
+								 to_int(force.z() * ka + m_noise.accel * noise(vehicle, 5)));
+	g.afs_sel = 0;
+	g.fs_sel = 0;
+	g.temp = static_cast< float >(30 + 0.05 * noise(vehicle, 6));
+	g.freq = static_cast< float >(1 / m_dt);
+	g.tick = tick;
+
+	vector3_::Vector3d field = inv.rotatedVector(vector3_::Vector3d(field_horizontal, 0, -field_vertical));
+	telemetry.compass.data = vector3_::Vector3i(to_int(field.x() * compass_lsb + m_noise.compass * noise(vehicle, 7)),
+												to_int(field.y() * compass_lsb + m_noise.compass * noise(vehicle, 8)),
+												to_int(field.z() * compass_lsb + m_noise.compass * noise(vehicle, 9)));
+	telemetry.compass.tick = tick;
+
+	double height = at(PZ, vehicle);
+	double pressure = 101325.0 * pow(1 - 2.25577e-5 * height, 5.25588);
+	telemetry.barometer.data = to_int(pressure + m_noise.pressure * noise(vehicle, 10));
+	telemetry.barometer.temp = 250;
+	telemetry.barometer.tick = tick;
+
+	telemetry.power_on = m_power_on[vehicle];
+	FOREACH(e, sc::cnt_engines, telemetry.power[e] = at(Motor + e, vehicle));
+	telemetry.tangaj = static_cast< float >(tangaj);
+	telemetry.bank = static_cast< float >(bank);
+	telemetry.course = static_cast< float >(course);
+	telemetry.height = static_cast< float >(height);
+}
+
+void FleetSimulator::step_range(size_t from, size_t to, int count)
+{
+	const VehicleParams& p = m_params;
+	const Mixer::Matrix& mx = Mixer::matrix;
+	const Pack dt(static_cast< float >(m_dt)), half_dt(static_cast< float >(m_dt / 2)), zero(0.f), one(1.f), two(2.f);
+	const Pack k_motor(static_cast< float >(std::min(1.0, m_dt / p.motor_tau)));
+	const Pack thrust(static_cast< float >(p.max_thrust)), inv_mass(static_cast< float >(1 / p.mass));
+	const Pack drag(static_cast< float >(p.drag / p.mass)), angular_drag(static_cast< float >(p.angular_drag));
+	const Pack ixx(static_cast< float >(p.inertia[0])), iyy(static_cast< float >(p.inertia[1])), izz(static_cast< float >(p.inertia[2]));
+	const Pack arm(static_cast< float >(p.arm)), yaw_torque(static_cast< float >(p.yaw_torque));
+	const Pack g(static_cast< float >(gravity));
+	Pack bank[sc::cnt_engines], tangaj[sc::cnt_engines], yaw[sc::cnt_engines];
+	FOREACH(e, sc::cnt_engines, bank[e] = Pack(mx.bank[e]); tangaj[e] = Pack(mx.tangaj[e]); yaw[e] = Pack(mx.yaw[e]));
+
+	float* s = &m_state[0];
+	const size_t st = m_stride;
+	for(size_t i = from; i < to; i += lanes){
+		/// the state of four vehicles stays in the registers for all steps
+		Pack px = Pack::load(s + PX * st + i), py = Pack::load(s + PY * st + i), pz = Pack::load(s + PZ * st + i);
+		Pack vx = Pack::load(s + VX * st + i), vy = Pack::load(s + VY * st + i), vz = Pack::load(s + VZ * st + i);
+		Pack qw = Pack::load(s + QW * st + i), qx = Pack::load(s + QX * st + i);
+		Pack qy = Pack::load(s + QY * st + i), qz = Pack::load(s + QZ * st + i);
+		Pack wx = Pack::load(s + WX * st + i), wy = Pack::load(s + WY * st + i), wz = Pack::load(s + WZ * st + i);
+		Pack ax, ay, az;
+		Pack motor[sc::cnt_engines], command[sc::cnt_engines];
+		for(int e = 0; e < sc::cnt_engines; e++){
+			motor[e] = Pack::load(s + (Motor + e) * st + i);
+			command[e] = Pack::load(s + (Command + e) * st + i);
+		}
+
+		for(int n = 0; n < count; n++){
+			/// engines: the first order lag, thrusts and torques
+			Pack force(0.f), tx(0.f), ty(0.f), tz(0.f);
+			for(int e = 0; e < sc::cnt_engines; e++){
+				motor[e] = motor[e] + (command[e] - motor[e]) * k_motor;
+				Pack f = motor[e] * thrust;
+				force = force + f;
+				tx = tx + bank[e] * f;
+				ty = ty + tangaj[e] * f;
+				tz = tz + yaw[e] * f;
+			}
+			tx = tx * arm - angular_drag * wx;
+			ty = ty * arm - angular_drag * wy;
+			tz = tz * yaw_torque - angular_drag * wz;
+
+			/// euler equations: dw = I^-1 (t - w x Iw)
+			Pack dwx = (tx - (izz - iyy) * wy * wz) / ixx;
+			Pack dwy = (ty - (ixx - izz) * wz * wx) / iyy;
+			Pack dwz = (tz - (iyy - ixx) * wx * wy) / izz;
+			wx = wx + dwx * dt;
+			wy = wy + dwy * dt;
+			wz = wz + dwz * dt;
+
+			/// dq = q * (w, 0) / 2
+			Pack dqw = zero - (qx * wx + qy * wy + qz * wz);
+			Pack dqx = qw * wx + qy * wz - qz * wy;
+			Pack dqy = qw * wy - qx * wz + qz * wx;
+			Pack dqz = qw * wz + qx * wy - qy * wx;
+			qw = qw + dqw * half_dt;
+			qx = qx + dqx * half_dt;
+			qy = qy + dqy * half_dt;
+			qz = qz + dqz * half_dt;
+			Pack inv = one / sqrt(qw * qw + qx * qx + qy * qy + qz * qz);
+			qw = qw * inv;
+			qx = qx * inv;
+			qy = qy * inv;
+			qz = qz * inv;
+
+			/// thrust along z of the body in the world frame
+			Pack fm = force * inv_mass;
+			ax = fm * two * (qx * qz + qw * qy) - drag * vx;
+			ay = fm * two * (qy * qz - qw * qx) - drag * vy;
+			az = fm * (one - two * (qx * qx + qy * qy)) - g - drag * vz;
+			vx = vx + ax * dt;
+			vy = vy + ay * dt;
+			vz = vz + az * dt;
+			px = px + vx * dt;
+			py = py + vy * dt;
+			pz = pz + vz * dt;
+
+			/// the ground holds the vehicle: no fall below z = 0
+			Pack ground = select_less(pz, zero, one, zero);
+			Pack air = one - ground;
+			pz = max(pz, zero);
+			vz = air * vz + ground * max(vz, zero);
+			az = air * az + ground * max(az, zero);
+		}
+
+		px.store(s + PX * st + i); py.store(s + PY * st + i); pz.store(s + PZ * st + i);
+		vx.store(s + VX * st + i); vy.store(s + VY * st + i); vz.store(s + VZ * st + i);
+		qw.store(s + QW * st + i); qx.store(s + QX * st + i);
+		qy.store(s + QY * st + i); qz.store(s + QZ * st + i);
+		wx.store(s + WX * st + i); wy.store(s + WY * st + i); wz.store(s + WZ * st + i);
+		ax.store(s + AX * st + i); ay.store(s + AY * st + i); az.store(s + AZ * st + i);
+		FOREACH(e, sc::cnt_engines, motor[e].store(s + (Motor + e) * st + i));
+	}
+}
+
+void FleetSimulator::work(size_t range)
+{
+	unsigned long long generation = 0;
+	for(;;){
+		int count;
+		{
+			std::unique_lock< std::mutex > lock(m_mutex);
+			m_start.wait(lock, [&]{ return m_stop || m_generation != generation; });
+			if(m_stop)
+				return;
+			generation = m_generation;
+			count = m_count;
+		}
+		step_range(m_ranges[range], m_ranges[range + 1], count);
+		std::lock_guard< std::mutex > lock(m_mutex);
+		if(--m_pending == 0)
+			m_done.notify_one();
+	}
+}
+
+double FleetSimulator::noise(size_t vehicle, int channel) const
+{
+	/// counter based: the same value for the same seed, vehicle, step and channel
+	unsigned long long r = mix64(m_seed ^ mix64(vehicle * 0x100000001b3ULL ^ mix64(m_steps * 16 + channel)));
+	double sum = 0;
+	FOREACH(i, 4, sum += static_cast< double >((r >> (16 * i)) & 0xffff));
+	return (sum / 65536.0 - 2) * 1.7320508075688772;
+}
@@ -0,0 +1,186 @@
+#ifndef FLEET_SIMULATOR_H
+#define FLEET_SIMULATOR_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stddef.h>
+
+#include "struct_controls.h"
+#include "vector3_.h"
+#include "quaternions.h"
+#include "mixer.h"
+
+namespace sim{
+
+/**
+ * @brief The VehicleParams struct
+ * rigid body of the multirotor; the thrust of the engine is linear in its power [0; 1]
+ */
+struct VehicleParams{
+	VehicleParams();
+
+	double mass;				/// kg
+	double arm;					/// m, from the center to the engine
+	double max_thrust;			/// N of one engine at power 1
+	double yaw_torque;			/// N*m of the reaction per N of the thrust
+	double inertia[3];			/// kg*m^2 around x, y, z of the body
+	double motor_tau;			/// s, time constant of the engine
+	double drag;				/// N per m/s
+	double angular_drag;		/// N*m per rad/s
+};
+
+/**
+ * @brief The SensorNoise struct
+ * standard deviations of the sensors in their LSB (pressure in Pa)
+ */
+struct SensorNoise{
+	SensorNoise();
+
+	double gyro;
+	double accel;
+	double compass;
+	double pressure;
+};
+
+//////////////////////////////////////////////////
+/// \brief The FleetSimulator class
+/// many multirotors with the fixed time step. StructControls are mixed by
+/// Mixer_< cnt_engines > into the thrusts, the attitude is the quaternion
+/// integrated with the body rates, the position is in the world frame with
+/// z up. the state is stored by fields (SoA) and four vehicles are advanced
+/// at once with SSE; the vehicles are divided between the threads, so the
+/// results do not depend on the count of the threads. the threads are started
+/// once by the constructor and wait for step() between the calls.
+/// the torques are applied so that positive commands increase tangaj, bank
+/// and course of the telemetry (the conventions of HeightEstimator and
+/// compass::heading: attitude = z(course) * y(tangaj) * x(bank))
+class FleetSimulator{
+public:
+	typedef mixer::Mixer_< sc::cnt_engines > Mixer;
+
+	/**
+	 * @brief FleetSimulator
+	 * @param vehicles
+	 * @param dt - s, time step
+	 * @param threads - 0: by the count of the cores
+	 * @param seed - of the noise of the sensors
+	 */
+	FleetSimulator(size_t vehicles, double dt = 0.001, int threads = 0, unsigned long long seed = 1);
+	~FleetSimulator();
+	FleetSimulator(const FleetSimulator&) = delete;
+	FleetSimulator& operator=(const FleetSimulator&) = delete;
+
+	size_t vehicles() const;
+	double dt() const;
+	int threads() const;
+	/**
+	 * @brief steps
+	 * @return count of the steps from the start
+	 */
+	long long steps() const;
+	double time() const;
+
+	void set_params(const VehicleParams& params);
+	const VehicleParams& params() const;
+	void set_noise(const SensorNoise& noise);
+
+	/**
+	 * @brief reset
+	 * place the vehicle at rest with the engines stopped
+	 * @param vehicle
+	 * @param position - m
+	 * @param attitude
+	 */
+	void reset(size_t vehicle, const vector3_::Vector3d& position = vector3_::Vector3d(),
+			   const quaternions::Quaternion& attitude = quaternions::Quaternion());
+	/**
+	 * @brief set_controls
+	 * command of the vehicle until the next call
+	 * @param vehicle
+	 * @param controls
+	 */
+	void set_controls(size_t vehicle, const sc::StructControls& controls);
+	/**
+	 * @brief set_controls
+	 * commands of all vehicles
+	 * @param controls - vehicles() values
+	 */
+	void set_controls(const sc::StructControls* controls);
+
+	/**
+	 * @brief step
+	 * advance all vehicles
+	 * @param count - steps with the same commands
+	 */
+	void step(int count = 1);
+
+	vector3_::Vector3d position(size_t vehicle) const;
+	vector3_::Vector3d velocity(size_t vehicle) const;
+	quaternions::Quaternion attitude(size_t vehicle) const;
+	/**
+	 * @brief angular_velocity
+	 * @param vehicle
+	 * @return rad/s in the body frame
+	 */
+	vector3_::Vector3d angular_velocity(size_t vehicle) const;
+	/**
+	 * @brief telemetry
+	 * sensors of mpu6050 (fs_sel 0, afs_sel 0), hmc5883l and the barometer, the true
+	 * attitude and height and the power of the engines. the noise depends only on
+	 * the seed, the vehicle and the step
+	 * @param vehicle
+	 * @param telemetry
+	 */
+	void telemetry(size_t vehicle, sc::StructTelemetry& telemetry) const;
+
+private:
+	enum Field{
+		PX, PY, PZ,
+		VX, VY, VZ,
+		QW, QX, QY, QZ,
+		WX, WY, WZ,
+		AX, AY, AZ,							/// acceleration of the last step (world)
+		Motor,								/// power of the engines
+		Command = Motor + sc::cnt_engines,	/// power from the mixer
+		fields = Command + sc::cnt_engines
+	};
+
+	size_t m_vehicles;
+	size_t m_stride;						/// vehicles rounded up to the multiple of 4
+	double m_dt;
+	int m_threads;
+	unsigned long long m_seed;
+	long long m_steps;
+	VehicleParams m_params;
+	SensorNoise m_noise;
+	Mixer m_mixer;
+	std::vector< float > m_state;
+	std::vector< bool > m_power_on;
+
+	/// the pool: the range 0 is stepped by the caller of step(), range i by m_workers[i - 1]
+	std::vector< size_t > m_ranges;			/// bounds of the ranges of the vehicles
+	std::vector< std::thread > m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_start;
+	std::condition_variable m_done;
+	unsigned long long m_generation;		/// count of the started steps
+	int m_count;							/// count of the current step()
+	int m_pending;							/// workers not finished
+	bool m_stop;
+
+	inline float& at(int field, size_t vehicle){
+		return m_state[field * m_stride + vehicle];
+	}
+	inline float at(int field, size_t vehicle) const{
+		return m_state[field * m_stride + vehicle];
+	}
+	void step_range(size_t from, size_t to, int count);
+	void work(size_t range);
+	double noise(size_t vehicle, int channel) const;
+};
+
+}
+
+#endif // FLEET_SIMULATOR_H
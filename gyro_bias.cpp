@@ -0,0 +1,189 @@
+#include <algorithm>
+
+#include "gyro_bias.h"
+
+using namespace gyro_bias;
+
+Welford3::Welford3()
+{
+	clear();
+}
+
+void Welford3::clear()
+{
+	count = 0;
+	mean.clear();
+	m2.clear();
+}
+
+void Welford3::merge(const Welford3 &other)
+{
+	if(!other.count)
+		return;
+	if(!count){
+		*this = other;
+		return;
+	}
+	double n = static_cast< double >(count + other.count);
+	double wa = count / n, wb = other.count / n;
+	FOREACH(i, vector3_::Vector3d::count, {
+		double delta = other.mean.data[i] - mean.data[i];
+		mean.data[i] = mean.data[i] * wa + other.mean.data[i] * wb;
+		m2.data[i] += other.m2.data[i] + delta * delta * count * wb;
+	});
+	count += other.count;
+}
+
+vector3_::Vector3d Welford3::variance() const
+{
+	if(count < 2)
+		return vector3_::Vector3d();
+	return m2 * (1.0 / (count - 1));
+}
+
+double Welford3::max_variance() const
+{
+	vector3_::Vector3d v = variance();
+	return std::max(v.x(), std::max(v.y(), v.z()));
+}
+
+////////////////////////////////////////////////
+
+GyroBias::GyroBias()
+{
+	count = 0;
+	valid = false;
+}
+
+////////////////////////////////////////////////
+
+GyroBiasEstimator::GyroBiasEstimator(int window, double gyro_threshold,
+									 double accel_threshold, long long max_weight)
+	: m_sequence(0)
+	, m_shared_count(0)
+	, m_shared_valid(false)
+{
+	FOREACH(i, 6, m_shared[i].store(0, std::memory_order_relaxed));
+	set_window(window);
+	set_thresholds(gyro_threshold, accel_threshold);
+	set_max_weight(max_weight);
+	reset();
+}
+
+void GyroBiasEstimator::set_window(int window)
+{
+	m_window = window > 1? window : 2;
+}
+
+void GyroBiasEstimator::set_thresholds(double gyro_threshold, double accel_threshold)
+{
+	m_gyro_threshold = gyro_threshold;
+	m_accel_threshold = accel_threshold;
+}
+
+void GyroBiasEstimator::set_max_weight(long long max_weight)
+{
+	m_max_weight = max_weight;
+}
+
+void GyroBiasEstimator::reset()
+{
+	m_block_gyro.clear();
+	m_block_accel.clear();
+	m_total.clear();
+	m_bias = GyroBias();
+	m_still = false;
+	publish();
+}
+
+bool GyroBiasEstimator::add(const sc::StructGyroscope &gyroscope)
+{
+	m_block_gyro.add(vector3_::Vector3d(gyroscope.gyro));
+	m_block_accel.add(vector3_::Vector3d(gyroscope.accel));
+	if(m_block_gyro.count < m_window)
+		return false;
+	finish_block();
+	return m_still;
+}
+
+size_t GyroBiasEstimator::add(const sc::StructGyroscope *gyroscope, size_t count)
+{
+	size_t updates = 0;
+	for(size_t i = 0; i < count; i++){
+		if(add(gyroscope[i]))
+			updates++;
+	}
+	return updates;
+}
+
+const GyroBias &GyroBiasEstimator::bias() const
+{
+	return m_bias;
+}
+
+GyroBias GyroBiasEstimator::snapshot() const
+{
+	GyroBias res;
+	unsigned s1, s2;
+	do{
+		s1 = m_sequence.load(std::memory_order_acquire);
+		FOREACH(i, 3, res.offset.data[i] = m_shared[i].load(std::memory_order_relaxed));
+		FOREACH(i, 3, res.variance.data[i] = m_shared[3 + i].load(std::memory_order_relaxed));
+		res.count = m_shared_count.load(std::memory_order_relaxed);
+		res.valid = m_shared_valid.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		s2 = m_sequence.load(std::memory_order_relaxed);
+	}while((s1 & 1) || s1 != s2);
+	return res;
+}
+
+bool GyroBiasEstimator::is_still() const
+{
+	return m_still;
+}
+
+GyroBias GyroBiasEstimator::calibrate(const sc::StructGyroscope *gyroscope, size_t count, int window,
+									  double gyro_threshold, double accel_threshold)
+{
+	/// the whole log has the same weight
+	GyroBiasEstimator estimator(window, gyro_threshold, accel_threshold, 0);
+	estimator.add(gyroscope, count);
+	return estimator.bias();
+}
+
+void GyroBiasEstimator::finish_block()
+{
+	m_still = m_block_gyro.max_variance() < m_gyro_threshold &&
+			m_block_accel.max_variance() < m_accel_threshold;
+
+	if(m_still){
+		/// old estimation has the weight of max_weight samples at most
+		if(m_max_weight > 0 && m_total.count > m_max_weight){
+			double k = static_cast< double >(m_max_weight) / m_total.count;
+			m_total.m2 *= k;
+			m_total.count = m_max_weight;
+		}
+		m_total.merge(m_block_gyro);
+
+		m_bias.offset = m_total.mean;
+		m_bias.variance = m_total.variance();
+		m_bias.count = m_total.count;
+		m_bias.valid = true;
+		publish();
+	}
+
+	m_block_gyro.clear();
+	m_block_accel.clear();
+}
+
+void GyroBiasEstimator::publish()
+{
+	unsigned s = m_sequence.load(std::memory_order_relaxed);
+	m_sequence.store(s + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	FOREACH(i, 3, m_shared[i].store(m_bias.offset.data[i], std::memory_order_relaxed));
+	FOREACH(i, 3, m_shared[3 + i].store(m_bias.variance.data[i], std::memory_order_relaxed));
+	m_shared_count.store(m_bias.count, std::memory_order_relaxed);
+	m_shared_valid.store(m_bias.valid, std::memory_order_relaxed);
+	m_sequence.store(s + 2, std::memory_order_release);
+}
@@ -0,0 +1,157 @@
+#ifndef GYRO_BIAS_H
+#define GYRO_BIAS_H
+
+#include <atomic>
+#include <stddef.h>
+
+#include "vector3_.h"
+#include "struct_controls.h"
+
+namespace gyro_bias{
+
+/**
+ * @brief The Welford3 struct
+ * incremental mean and variance of the vector (Welford)
+ */
+struct Welford3{
+	Welford3();
+
+	void clear();
+	inline void add(const vector3_::Vector3d& value){
+		count++;
+		double inv = 1.0 / count;
+		FOREACH(i, vector3_::Vector3d::count, {
+			double delta = value.data[i] - mean.data[i];
+			mean.data[i] += delta * inv;
+			m2.data[i] += delta * (value.data[i] - mean.data[i]);
+		});
+	}
+	/**
+	 * @brief merge
+	 * parallel combination (Chan) of two sets
+	 * @param other
+	 */
+	void merge(const Welford3& other);
+	vector3_::Vector3d variance() const;
+	/**
+	 * @brief max_variance
+	 * maximum of the variance by axes
+	 * @return
+	 */
+	double max_variance() const;
+
+	long long count;
+	vector3_::Vector3d mean;
+	vector3_::Vector3d m2;
+};
+
+/**
+ * @brief The GyroBias struct
+ * result of the estimation (raw units of the gyroscope),
+ * offset is passed to StructGyroscope::angular_speed
+ */
+struct GyroBias{
+	GyroBias();
+
+	vector3_::Vector3d offset;
+	vector3_::Vector3d variance;
+	long long count;		/// count of the still samples in the estimation
+	bool valid;
+};
+
+//////////////////////////////////////////////////
+/// \brief The GyroBiasEstimator class
+/// online estimation of the gyroscope bias. samples are collected in the blocks of
+/// window samples; the block is still when the variance of gyro and accel is below
+/// the thresholds, and only still blocks update the bias. O(1) memory and time per sample.
+/// snapshot() may be called from the other thread (seqlock)
+class GyroBiasEstimator{
+public:
+	/**
+	 * @brief GyroBiasEstimator
+	 * @param window - samples in the block
+	 * @param gyro_threshold - maximum variance of gyro in the still block (raw units^2)
+	 * @param accel_threshold - maximum variance of accel in the still block (raw units^2)
+	 * @param max_weight - weight of the old estimation is limited by this count of samples,
+	 * so the bias follows the slow drift
+	 */
+	GyroBiasEstimator(int window = 100, double gyro_threshold = 50,
+					  double accel_threshold = 2500, long long max_weight = 10000);
+
+	void set_window(int window);
+	void set_thresholds(double gyro_threshold, double accel_threshold);
+	void set_max_weight(long long max_weight);
+	void reset();
+
+	/**
+	 * @brief add
+	 * add sample
+	 * @param gyroscope
+	 * @return true if the bias was updated
+	 */
+	bool add(const sc::StructGyroscope& gyroscope);
+	/**
+	 * @brief add
+	 * batch of the samples
+	 * @param gyroscope
+	 * @param count
+	 * @return count of the updates of the bias
+	 */
+	size_t add(const sc::StructGyroscope* gyroscope, size_t count);
+
+	/**
+	 * @brief bias
+	 * current estimation (thread of the updates only)
+	 * @return
+	 */
+	const GyroBias& bias() const;
+	/**
+	 * @brief snapshot
+	 * consistent copy of the estimation; safe to call from any thread
+	 * @return
+	 */
+	GyroBias snapshot() const;
+	/**
+	 * @brief is_still
+	 * the last complete block was still
+	 * @return
+	 */
+	bool is_still() const;
+
+	/**
+	 * @brief calibrate
+	 * estimation from the recorded log
+	 * @param gyroscope
+	 * @param count
+	 * @param window
+	 * @param gyro_threshold
+	 * @param accel_threshold
+	 * @return
+	 */
+	static GyroBias calibrate(const sc::StructGyroscope* gyroscope, size_t count, int window = 100,
+							  double gyro_threshold = 50, double accel_threshold = 2500);
+
+private:
+	int m_window;
+	double m_gyro_threshold;
+	double m_accel_threshold;
+	long long m_max_weight;
+	bool m_still;
+
+	Welford3 m_block_gyro;
+	Welford3 m_block_accel;
+	Welford3 m_total;
+	GyroBias m_bias;
+
+	std::atomic< unsigned > m_sequence;
+	std::atomic< double > m_shared[6];
+	std::atomic< long long > m_shared_count;
+	std::atomic< bool > m_shared_valid;
+
+	void finish_block();
+	void publish();
+};
+
+}
+
+#endif // GYRO_BIAS_H
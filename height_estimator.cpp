@@ -0,0 +1,171 @@
+#include "height_estimator.h"
+
+using namespace height;
+
+AltitudeTable::AltitudeTable(double reference)
+{
+	m_inv_step = (size - 1) / (max_ratio - min_ratio);
+	for(int i = 0; i < size; i++){
+		double ratio = min_ratio + i * (max_ratio - min_ratio) / (size - 1);
+		m_table[i] = altitude_exact(ratio, 1.0);
+	}
+	set_reference(reference);
+}
+
+void AltitudeTable::set_reference(double reference)
+{
+	if(reference <= 0)
+		reference = sea_level_pressure;
+	m_reference = reference;
+	m_inv_reference = 1.0 / reference;
+}
+
+double AltitudeTable::reference() const
+{
+	return m_reference;
+}
+
+double AltitudeTable::altitude_exact(double pressure, double reference)
+{
+	return 44330.0 * (1.0 - pow(pressure / reference, 1.0 / 5.255));
+}
+
+////////////////////////////////////////////////
+
+HeightEstimator::HeightEstimator(double reference)
+{
+	set_noise(0.5, 0.5, 0.01);
+	set_reference(reference);
+}
+
+void HeightEstimator::set_noise(double accel_noise, double baro_noise, double bias_noise)
+{
+	m_accel_var = accel_noise * accel_noise;
+	m_baro_var = baro_noise * baro_noise;
+	m_bias_var = bias_noise * bias_noise;
+}
+
+void HeightEstimator::set_reference(double reference)
+{
+	m_auto_reference = reference <= 0;
+	m_table.set_reference(reference);
+	reset();
+}
+
+void HeightEstimator::reset()
+{
+	m_initialized = false;
+	m_last_baro_tick = -1;
+	FOREACH(i, 3, m_x[i] = 0);
+	FOREACH(i, 3, FOREACH(j, 3, m_P[i][j] = 0));
+	m_P[0][0] = 100;
+	m_P[1][1] = 10;
+	m_P[2][2] = 1;
+}
+
+void HeightEstimator::predict(double accel_z, double dt)
+{
+	if(dt <= 0)
+		return;
+	double a = accel_z - m_x[2];
+	double dt2 = 0.5 * dt * dt;
+	m_x[0] += m_x[1] * dt + a * dt2;
+	m_x[1] += a * dt;
+
+	/// P = F * P * F^T + Q
+	const double F[3][3] = {
+		{1, dt, -dt2},
+		{0, 1, -dt},
+		{0, 0, 1}
+	};
+	double FP[3][3];
+	FOREACH(i, 3, FOREACH(j, 3, FP[i][j] = F[i][0] * m_P[0][j] + F[i][1] * m_P[1][j] + F[i][2] * m_P[2][j]));
+	FOREACH(i, 3, FOREACH(j, 3, m_P[i][j] = FP[i][0] * F[j][0] + FP[i][1] * F[j][1] + FP[i][2] * F[j][2]));
+
+	const double g[2] = {dt2, dt};
+	FOREACH(i, 2, FOREACH(j, 2, m_P[i][j] += m_accel_var * g[i] * g[j]));
+	m_P[2][2] += m_bias_var * dt;
+}
+
+void HeightEstimator::correct(double altitude)
+{
+	if(!m_initialized){
+		m_x[0] = altitude;
+		m_initialized = true;
+		return;
+	}
+	double s = m_P[0][0] + m_baro_var;
+	double k[3];
+	FOREACH(i, 3, k[i] = m_P[i][0] / s);
+	double y = altitude - m_x[0];
+	FOREACH(i, 3, m_x[i] += k[i] * y);
+	double row[3] = {m_P[0][0], m_P[0][1], m_P[0][2]};
+	FOREACH(i, 3, FOREACH(j, 3, m_P[i][j] -= k[i] * row[j]));
+}
+
+void HeightEstimator::update(const sc::StructGyroscope &gyroscope, const quaternions::Quaternion &attitude)
+{
+	float freq = gyroscope.freq > 0? gyroscope.freq : sc::default_freq;
+	predict(vertical_accel(gyroscope, attitude), 1.0 / freq);
+}
+
+void HeightEstimator::update(const sc::StructBarometer &barometer)
+{
+	if(barometer.data <= 0)
+		return;
+	if(m_auto_reference && !m_initialized)
+		m_table.set_reference(barometer.data);
+	m_last_baro_tick = barometer.tick;
+	correct(m_table.altitude(barometer.data));
+}
+
+void HeightEstimator::process(sc::StructTelemetry *telemetry, size_t count)
+{
+	for(size_t i = 0; i < count; i++){
+		sc::StructTelemetry& st = telemetry[i];
+		if(m_initialized)
+			update(st.gyroscope, attitude(st.tangaj, st.bank));
+		if(st.barometer.tick != m_last_baro_tick)
+			update(st.barometer);
+		to_telemetry(st);
+	}
+}
+
+double HeightEstimator::height() const
+{
+	return m_x[0];
+}
+
+double HeightEstimator::vertical_speed() const
+{
+	return m_x[1];
+}
+
+double HeightEstimator::accel_bias() const
+{
+	return m_x[2];
+}
+
+bool HeightEstimator::initialized() const
+{
+	return m_initialized;
+}
+
+void HeightEstimator::to_telemetry(sc::StructTelemetry &telemetry) const
+{
+	telemetry.height = static_cast< float >(m_x[0]);
+}
+
+double HeightEstimator::vertical_accel(const sc::StructGyroscope &gyroscope, const quaternions::Quaternion &attitude)
+{
+	/// LSB per g of mpu6050 for afs_sel 0..3
+	double lsb = 16384.0 / (1 << (gyroscope.afs_sel & 3));
+	vector3_::Vector3d a = attitude.rotatedVector(vector3_::Vector3d(gyroscope.accel));
+	return (a.z() / lsb - 1.0) * gravity;
+}
+
+quaternions::Quaternion HeightEstimator::attitude(double tangaj, double bank)
+{
+	return quaternions::Quaternion::fromAxisAndAngle(0, 1, 0, tangaj) *
+			quaternions::Quaternion::fromAxisAndAngle(1, 0, 0, bank);
+}
@@ -0,0 +1,167 @@
+#ifndef HEIGHT_ESTIMATOR_H
+#define HEIGHT_ESTIMATOR_H
+
+#include <stddef.h>
+
+#include "common_.h"
+#include "vector3_.h"
+#include "quaternions.h"
+#include "struct_controls.h"
+
+namespace height{
+
+const double sea_level_pressure = 101325.0;		/// Pa
+const double gravity = 9.80665;					/// m/s^2
+
+//////////////////////////////////////////////////
+/// \brief The AltitudeTable class
+/// barometric formula h = 44330 * (1 - (p / p0)^(1 / 5.255)) by the table
+/// of the pressure ratio with linear interpolation (error < 5 mm in [0.3; 1.1])
+class AltitudeTable{
+public:
+	enum{
+		size = 1024
+	};
+	static constexpr double min_ratio = 0.3;
+	static constexpr double max_ratio = 1.1;
+
+	AltitudeTable(double reference = sea_level_pressure);
+
+	/**
+	 * @brief set_reference
+	 * pressure at zero height (Pa)
+	 * @param reference
+	 */
+	void set_reference(double reference);
+	double reference() const;
+
+	/**
+	 * @brief altitude
+	 * @param pressure - Pa
+	 * @return meters above the reference
+	 */
+	inline double altitude(double pressure) const{
+		double x = (pressure * m_inv_reference - min_ratio) * m_inv_step;
+		if(x <= 0)
+			return m_table[0];
+		if(x >= size - 1)
+			return m_table[size - 1];
+		int i = static_cast< int >(x);
+		double f = x - i;
+		return m_table[i] + (m_table[i + 1] - m_table[i]) * f;
+	}
+	/**
+	 * @brief altitude_exact
+	 * the formula with pow
+	 * @param pressure
+	 * @param reference
+	 * @return
+	 */
+	static double altitude_exact(double pressure, double reference = sea_level_pressure);
+
+private:
+	double m_table[size];
+	double m_reference;
+	double m_inv_reference;
+	double m_inv_step;
+};
+
+//////////////////////////////////////////////////
+/// \brief The HeightEstimator class
+/// kalman filter with the state [height, vertical speed, accelerometer bias].
+/// prediction uses the vertical acceleration from StructGyroscope::accel (rotated by
+/// the attitude), correction uses the altitude from StructBarometer::data (Pa).
+/// all matrices are fixed 3x3, nothing is allocated per step
+class HeightEstimator{
+public:
+	/**
+	 * @brief HeightEstimator
+	 * @param reference - pressure at zero height; 0 - pressure of the first barometer sample
+	 */
+	HeightEstimator(double reference = 0);
+
+	/**
+	 * @brief set_noise
+	 * @param accel_noise - standard deviation of the acceleration (m/s^2)
+	 * @param baro_noise - standard deviation of the barometer altitude (m)
+	 * @param bias_noise - random walk of the accelerometer bias (m/s^2 per sqrt(s))
+	 */
+	void set_noise(double accel_noise, double baro_noise, double bias_noise);
+	void set_reference(double reference);
+	void reset();
+
+	/**
+	 * @brief predict
+	 * @param accel_z - vertical acceleration without gravity, up is positive (m/s^2)
+	 * @param dt - seconds
+	 */
+	void predict(double accel_z, double dt);
+	/**
+	 * @brief correct
+	 * @param altitude - meters
+	 */
+	void correct(double altitude);
+
+	/**
+	 * @brief update
+	 * prediction with the accelerometer; dt = 1 / freq of the gyroscope
+	 * @param gyroscope
+	 * @param attitude - orientation of the sensor (sensor to earth frame)
+	 */
+	void update(const sc::StructGyroscope& gyroscope,
+				const quaternions::Quaternion& attitude = quaternions::Quaternion());
+	/**
+	 * @brief update
+	 * correction with the barometer
+	 * @param barometer
+	 */
+	void update(const sc::StructBarometer& barometer);
+
+	/**
+	 * @brief process
+	 * batch mode for the recorded telemetry: every frame predicts with its gyroscope
+	 * and attitude (tangaj, bank), new barometer ticks correct. height of the frames is set
+	 * @param telemetry
+	 * @param count
+	 */
+	void process(sc::StructTelemetry* telemetry, size_t count);
+
+	double height() const;
+	double vertical_speed() const;
+	double accel_bias() const;
+	bool initialized() const;
+	void to_telemetry(sc::StructTelemetry& telemetry) const;
+
+	/**
+	 * @brief vertical_accel
+	 * vertical acceleration without gravity from the accelerometer (m/s^2)
+	 * @param gyroscope
+	 * @param attitude
+	 * @return
+	 */
+	static double vertical_accel(const sc::StructGyroscope& gyroscope, const quaternions::Quaternion& attitude);
+	/**
+	 * @brief attitude
+	 * orientation from tangaj and bank (degrees)
+	 * @param tangaj
+	 * @param bank
+	 * @return
+	 */
+	static quaternions::Quaternion attitude(double tangaj, double bank);
+
+private:
+	AltitudeTable m_table;
+	bool m_auto_reference;
+	bool m_initialized;
+	long long m_last_baro_tick;
+
+	double m_x[3];
+	double m_P[3][3];
+	double m_accel_var;
+	double m_baro_var;
+	double m_bias_var;
+};
+
+}
+
+#endif // HEIGHT_ESTIMATOR_H
@@ -0,0 +1,627 @@
+#include "ingest.h"
+
+#include <algorithm>
+#include <new>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "wire.h"
+
+using namespace ingest;
+
+namespace {
+
+/// frame bigger than it breaks the connection
+const size_t max_frame = 1 << 20;
+const size_t read_chunk = 64 * 1024;
+/// reads of one connection per wakeup
+const int max_reads = 4;
+const int max_events = 64;
+const size_t cache_line = 64;
+
+inline long long now_ns()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast< long long >(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+inline unsigned get_be32(const char* data)
+{
+	const unsigned char* d = reinterpret_cast< const unsigned char* >(data);
+	return (static_cast< unsigned >(d[0]) << 24) | (d[1] << 16) | (d[2] << 8) | d[3];
+}
+
+inline bool set_nonblock(int fd)
+{
+	int flags = fcntl(fd, F_GETFL, 0);
+	return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+inline void wake(int fd)
+{
+	unsigned long long one = 1;
+	while(::write(fd, &one, sizeof(one)) < 0 && errno == EINTR){
+	}
+}
+
+inline void drain(int fd)
+{
+	unsigned long long value;
+	while(::read(fd, &value, sizeof(value)) < 0 && errno == EINTR){
+	}
+}
+
+}
+
+static_assert(std::is_trivially_copyable< VehicleState >::value, "VehicleState is copied by bytes");
+
+namespace ingest{
+
+/**
+ * @brief The VehicleSlot struct
+ * VehicleState of one vehicle behind the sequence number (odd while it is written).
+ * the bytes are kept in atomic words, so the readers race with the writer
+ * without the undefined behaviour and retry if the sequence has changed
+ */
+struct VehicleSlot{
+	enum{
+		words = (sizeof(VehicleState) + 7) / 8
+	};
+	std::atomic< unsigned > sequence;
+	long long frames;							/// used by the thread of the shard only
+	std::atomic< unsigned long long > data[words];
+};
+
+}
+
+namespace {
+
+/**
+ * @brief create_slot
+ * the slot on its own cache lines: the size is rounded up to them too,
+ * so the writers of the neighbouring slots do not share a line
+ */
+VehicleSlot* create_slot()
+{
+	void* ptr = 0;
+	size_t size = (sizeof(VehicleSlot) + cache_line - 1) / cache_line * cache_line;
+	if(posix_memalign(&ptr, cache_line, size) != 0)
+		return 0;
+	VehicleSlot* slot = new (ptr) VehicleSlot;
+	slot->sequence.store(0, std::memory_order_relaxed);
+	slot->frames = 0;
+	return slot;
+}
+
+void destroy_slot(VehicleSlot* slot)
+{
+	slot->~VehicleSlot();
+	free(slot);
+}
+
+/**
+ * @brief publish
+ * write the state of the vehicle; only from the thread of the shard
+ */
+void publish(VehicleSlot* slot, int vehicle, long long received_ns, const sc::StructTelemetry& telemetry)
+{
+	unsigned long long buffer[VehicleSlot::words] = {};
+	char* bytes = reinterpret_cast< char* >(buffer);
+	long long frames = slot->frames;
+	memcpy(bytes + offsetof(VehicleState, vehicle), &vehicle, sizeof(vehicle));
+	memcpy(bytes + offsetof(VehicleState, frames), &frames, sizeof(frames));
+	memcpy(bytes + offsetof(VehicleState, received_ns), &received_ns, sizeof(received_ns));
+	memcpy(bytes + offsetof(VehicleState, telemetry), &telemetry, sizeof(telemetry));
+
+	unsigned s = slot->sequence.load(std::memory_order_relaxed);
+	slot->sequence.store(s + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	FOREACH(i, VehicleSlot::words, slot->data[i].store(buffer[i], std::memory_order_relaxed));
+	slot->sequence.store(s + 2, std::memory_order_release);
+}
+
+/**
+ * @brief load
+ * consistent copy of the state; from any thread
+ */
+void load(const VehicleSlot* slot, VehicleState& state)
+{
+	unsigned long long buffer[VehicleSlot::words];
+	for(;;){
+		unsigned s1 = slot->sequence.load(std::memory_order_acquire);
+		FOREACH(i, VehicleSlot::words, buffer[i] = slot->data[i].load(std::memory_order_relaxed));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		unsigned s2 = slot->sequence.load(std::memory_order_relaxed);
+		if(s1 == s2 && !(s1 & 1))
+			break;
+	}
+	memcpy(&state, buffer, sizeof(state));
+}
+
+}
+
+////////////////////////////////////////////////
+
+IngestRecord::IngestRecord()
+{
+	vehicle = 0;
+	received_ns = 0;
+}
+
+VehicleState::VehicleState()
+{
+	vehicle = 0;
+	frames = 0;
+	received_ns = 0;
+}
+
+IngestStats::IngestStats()
+{
+	connections = frames = bytes = errors = 0;
+}
+
+////////////////////////////////////////////////
+
+IngestServer::IngestServer(int shards, size_t batch)
+	: m_started(false)
+{
+	if(shards <= 0)
+		shards = std::max(1, static_cast< int >(std::thread::hardware_concurrency()));
+	m_batch = batch? batch : 1;
+	m_listen = -1;
+	m_wake = -1;
+	m_port = 0;
+	for(int i = 0; i < shards; i++)
+		m_shards.push_back(new IngestShard(i, m_batch));
+}
+
+IngestServer::~IngestServer()
+{
+	stop();
+	for(size_t i = 0; i < m_shards.size(); i++)
+		delete m_shards[i];
+}
+
+void IngestServer::set_consumer(const IngestServer::Consumer &consumer)
+{
+	m_consumer = consumer;
+}
+
+bool IngestServer::start(unsigned short port, const std::string &address)
+{
+	if(m_started)
+		return false;
+
+	m_listen = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if(m_listen < 0)
+		return false;
+	int one = 1;
+	setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if(inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1
+			|| bind(m_listen, reinterpret_cast< sockaddr* >(&addr), sizeof(addr)) < 0
+			|| listen(m_listen, SOMAXCONN) < 0){
+		close(m_listen);
+		m_listen = -1;
+		return false;
+	}
+	socklen_t len = sizeof(addr);
+	getsockname(m_listen, reinterpret_cast< sockaddr* >(&addr), &len);
+	m_port = ntohs(addr.sin_port);
+
+	m_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	bool ok = m_wake >= 0;
+	size_t started = 0;
+	for(; ok && started < m_shards.size(); started++)
+		ok = m_shards[started]->start(m_consumer);
+	if(!ok){
+		for(size_t i = 0; i < started; i++)
+			m_shards[i]->stop();
+		if(m_wake >= 0)
+			close(m_wake);
+		close(m_listen);
+		m_listen = m_wake = -1;
+		return false;
+	}
+
+	m_started = true;
+	m_acceptor = std::thread(&IngestServer::accept_loop, this);
+	return true;
+}
+
+void IngestServer::stop()
+{
+	if(!m_started)
+		return;
+	m_started = false;
+	wake(m_wake);
+	m_acceptor.join();
+	for(size_t i = 0; i < m_shards.size(); i++)
+		m_shards[i]->stop();
+	close(m_listen);
+	close(m_wake);
+	m_listen = m_wake = -1;
+}
+
+bool IngestServer::is_started() const
+{
+	return m_started;
+}
+
+unsigned short IngestServer::port() const
+{
+	return m_port;
+}
+
+int IngestServer::shards() const
+{
+	return static_cast< int >(m_shards.size());
+}
+
+int IngestServer::shard_of(int vehicle) const
+{
+	return static_cast< int >(static_cast< unsigned >(vehicle) % m_shards.size());
+}
+
+bool IngestServer::latest(int vehicle, VehicleState &state) const
+{
+	return m_shards[shard_of(vehicle)]->latest(vehicle, state);
+}
+
+size_t IngestServer::vehicles() const
+{
+	size_t res = 0;
+	for(size_t i = 0; i < m_shards.size(); i++)
+		res += m_shards[i]->vehicles();
+	return res;
+}
+
+IngestStats IngestServer::stats() const
+{
+	IngestStats res;
+	for(size_t i = 0; i < m_shards.size(); i++){
+		IngestStats s = m_shards[i]->stats();
+		res.connections += s.connections;
+		res.frames += s.frames;
+		res.bytes += s.bytes;
+		res.errors += s.errors;
+	}
+	return res;
+}
+
+void IngestServer::accept_loop()
+{
+	/// connections which have not sent the id yet
+	struct Hello{
+		char data[4];
+		size_t used;
+	};
+	std::unordered_map< int, Hello > hello;
+
+	int ep = epoll_create1(EPOLL_CLOEXEC);
+	epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = m_listen;
+	epoll_ctl(ep, EPOLL_CTL_ADD, m_listen, &ev);
+	ev.data.fd = m_wake;
+	epoll_ctl(ep, EPOLL_CTL_ADD, m_wake, &ev);
+
+	epoll_event events[max_events];
+	while(m_started){
+		int n = epoll_wait(ep, events, max_events, -1);
+		for(int i = 0; i < n; i++){
+			int fd = events[i].data.fd;
+			if(fd == m_wake){
+				drain(m_wake);
+				continue;
+			}
+			if(fd == m_listen){
+				int client;
+				while((client = accept4(m_listen, 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0){
+					int one = 1;
+					setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+					Hello h;
+					h.used = 0;
+					hello[client] = h;
+					ev.data.fd = client;
+					epoll_ctl(ep, EPOLL_CTL_ADD, client, &ev);
+				}
+				continue;
+			}
+			std::unordered_map< int, Hello >::iterator it = hello.find(fd);
+			if(it == hello.end())
+				continue;
+			Hello& h = it->second;
+			/// only the id is read, the frames are left for the shard
+			ssize_t res = ::read(fd, h.data + h.used, sizeof(h.data) - h.used);
+			if(res < 0 && (errno == EAGAIN || errno == EINTR))
+				continue;
+			if(res <= 0){
+				epoll_ctl(ep, EPOLL_CTL_DEL, fd, 0);
+				close(fd);
+				hello.erase(it);
+				continue;
+			}
+			h.used += static_cast< size_t >(res);
+			if(h.used == sizeof(h.data)){
+				int vehicle = static_cast< int >(get_be32(h.data));
+				epoll_ctl(ep, EPOLL_CTL_DEL, fd, 0);
+				hello.erase(it);
+				m_shards[shard_of(vehicle)]->add_connection(fd, vehicle);
+			}
+		}
+	}
+	for(std::unordered_map< int, Hello >::iterator it = hello.begin(); it != hello.end(); ++it)
+		close(it->first);
+	close(ep);
+}
+
+////////////////////////////////////////////////
+
+IngestShard::IngestShard(int index, size_t batch)
+	: m_stop(false)
+	, m_frames(0)
+	, m_bytes(0)
+	, m_errors(0)
+	, m_open(0)
+{
+	m_index = index;
+	m_epoll = -1;
+	m_wake = -1;
+	m_batch.resize(batch);
+	m_batch_count = 0;
+}
+
+IngestShard::~IngestShard()
+{
+	stop();
+	for(std::unordered_map< int, VehicleSlot* >::iterator it = m_slots.begin(); it != m_slots.end(); ++it)
+		destroy_slot(it->second);
+}
+
+bool IngestShard::start(const IngestServer::Consumer &consumer)
+{
+	m_consumer = consumer;
+	m_epoll = epoll_create1(EPOLL_CLOEXEC);
+	m_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = m_wake;
+	if(m_epoll < 0 || m_wake < 0 || epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake, &ev) < 0){
+		if(m_epoll >= 0)
+			close(m_epoll);
+		if(m_wake >= 0)
+			close(m_wake);
+		m_epoll = m_wake = -1;
+		return false;
+	}
+
+	m_stop = false;
+	m_thread = std::thread(&IngestShard::loop, this);
+	return true;
+}
+
+void IngestShard::stop()
+{
+	if(!m_thread.joinable())
+		return;
+	m_stop = true;
+	wake(m_wake);
+	m_thread.join();
+
+	for(std::unordered_map< int, Connection >::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+		close(it->first);
+	m_connections.clear();
+	{
+		std::lock_guard< std::mutex > lock(m_pending_mutex);
+		for(size_t i = 0; i < m_pending.size(); i++)
+			close(m_pending[i].first);
+		m_pending.clear();
+	}
+	m_open = 0;
+	close(m_epoll);
+	close(m_wake);
+	m_epoll = m_wake = -1;
+}
+
+void IngestShard::add_connection(int fd, int vehicle)
+{
+	{
+		std::lock_guard< std::mutex > lock(m_pending_mutex);
+		m_pending.push_back(std::make_pair(fd, vehicle));
+	}
+	wake(m_wake);
+}
+
+bool IngestShard::latest(int vehicle, VehicleState &state) const
+{
+	const VehicleSlot* slot;
+	{
+		std::lock_guard< std::mutex > lock(m_table_mutex);
+		std::unordered_map< int, VehicleSlot* >::const_iterator it = m_slots.find(vehicle);
+		if(it == m_slots.end())
+			return false;
+		slot = it->second;
+	}
+	load(slot, state);
+	return true;
+}
+
+size_t IngestShard::vehicles() const
+{
+	std::lock_guard< std::mutex > lock(m_table_mutex);
+	return m_slots.size();
+}
+
+IngestStats IngestShard::stats() const
+{
+	IngestStats res;
+	res.connections = m_open;
+	res.frames = m_frames;
+	res.bytes = m_bytes;
+	res.errors = m_errors;
+	return res;
+}
+
+void IngestShard::loop()
+{
+	epoll_event events[max_events];
+	while(!m_stop){
+		int n = epoll_wait(m_epoll, events, max_events, -1);
+		for(int i = 0; i < n; i++){
+			int fd = events[i].data.fd;
+			if(fd == m_wake){
+				drain(m_wake);
+				accept_pending();
+				continue;
+			}
+			std::unordered_map< int, Connection >::iterator it = m_connections.find(fd);
+			if(it == m_connections.end())
+				continue;
+			if(!read_connection(it->second))
+				close_connection(fd);
+		}
+		/// the records of this wakeup are not held until the batch is full
+		flush();
+	}
+}
+
+void IngestShard::accept_pending()
+{
+	std::vector< std::pair< int, int > > pending;
+	{
+		std::lock_guard< std::mutex > lock(m_pending_mutex);
+		pending.swap(m_pending);
+	}
+	for(size_t i = 0; i < pending.size(); i++){
+		Connection c;
+		c.fd = pending[i].first;
+		c.vehicle = pending[i].second;
+		c.buffer.resize(read_chunk);
+		c.used = 0;
+		{
+			/// the map is changed by this thread only, so it is read without the lock
+			std::unordered_map< int, VehicleSlot* >::iterator it = m_slots.find(c.vehicle);
+			if(it != m_slots.end()){
+				c.slot = it->second;
+			}else{
+				c.slot = create_slot();
+				if(!c.slot){
+					close(c.fd);
+					m_errors++;
+					continue;
+				}
+				publish(c.slot, c.vehicle, 0, sc::StructTelemetry());
+				std::lock_guard< std::mutex > lock(m_table_mutex);
+				m_slots[c.vehicle] = c.slot;
+			}
+		}
+		epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN | EPOLLRDHUP;
+		ev.data.fd = c.fd;
+		if(epoll_ctl(m_epoll, EPOLL_CTL_ADD, c.fd, &ev) < 0){
+			close(c.fd);
+			m_errors++;
+			continue;
+		}
+		m_connections[c.fd] = c;
+		m_open++;
+	}
+}
+
+bool IngestShard::read_connection(IngestShard::Connection &connection)
+{
+	for(int reads = 0; reads < max_reads; reads++){
+		if(connection.buffer.size() - connection.used < read_chunk / 4)
+			connection.buffer.resize(connection.buffer.size() * 2);
+		ssize_t res = ::read(connection.fd, &connection.buffer[connection.used],
+				connection.buffer.size() - connection.used);
+		if(res < 0){
+			if(errno == EINTR)
+				continue;
+			if(errno == EAGAIN || errno == EWOULDBLOCK)
+				return true;
+			m_errors++;
+			return false;
+		}
+		if(res == 0)
+			return false;
+		connection.used += static_cast< size_t >(res);
+		m_bytes += res;
+
+		const char* data = &connection.buffer[0];
+		size_t pos = 0;
+		while(connection.used - pos >= 4){
+			size_t size = get_be32(data + pos);
+			if(size > max_frame){
+				m_errors++;
+				return false;
+			}
+			if(connection.used - pos - 4 < size)
+				break;
+
+			IngestRecord& record = m_batch[m_batch_count];
+			record.vehicle = connection.vehicle;
+			record.received_ns = now_ns();
+			if(trace::enabled){
+				record.stamps = trace::TraceStamps();
+				record.stamps.set(trace::Receive, record.received_ns);
+			}
+			if(!wire::decode(data + pos + 4, size, record.telemetry, record.stamps)){
+				m_errors++;
+			}else{
+				connection.slot->frames++;
+				publish(connection.slot, connection.vehicle, record.received_ns, record.telemetry);
+				m_frames++;
+				if(++m_batch_count == m_batch.size())
+					flush();
+			}
+			pos += 4 + size;
+		}
+		if(pos){
+			memmove(&connection.buffer[0], data + pos, connection.used - pos);
+			connection.used -= pos;
+		}
+		/// shrink after the big frame
+		if(connection.used < read_chunk && connection.buffer.size() > 4 * read_chunk)
+			connection.buffer.resize(read_chunk);
+	}
+	return true;
+}
+
+void IngestShard::close_connection(int fd)
+{
+	epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, 0);
+	close(fd);
+	m_connections.erase(fd);
+	m_open--;
+}
+
+void IngestShard::flush()
+{
+	if(!m_batch_count)
+		return;
+	if(m_consumer)
+		m_consumer(m_index, &m_batch[0], m_batch_count);
+	m_batch_count = 0;
+}
@@ -0,0 +1,209 @@
+#ifndef INGEST_H
+#define INGEST_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <stddef.h>
+
+#include "struct_controls.h"
+#include "trace.h"
+
+namespace ingest{
+
+/**
+ * @brief The IngestRecord struct
+ * decoded frame of the vehicle
+ */
+struct IngestRecord{
+	IngestRecord();
+
+	int vehicle;
+	long long received_ns;		/// monotonic clock
+	sc::StructTelemetry telemetry;
+	trace::TraceStamps stamps;	/// of the sender and Receive, Decode (WITH_TRACE)
+};
+
+/**
+ * @brief The VehicleState struct
+ * the latest telemetry of the vehicle
+ */
+struct VehicleState{
+	VehicleState();
+
+	int vehicle;
+	long long frames;
+	long long received_ns;
+	sc::StructTelemetry telemetry;
+};
+
+/**
+ * @brief The IngestStats struct
+ */
+struct IngestStats{
+	IngestStats();
+
+	long long connections;		/// open connections
+	long long frames;
+	long long bytes;
+	long long errors;			/// broken frames and connections
+};
+
+class IngestShard;
+struct VehicleSlot;
+
+//////////////////////////////////////////////////
+/// \brief The IngestServer class
+/// receives StructTelemetry from many vehicles over tcp (linux, epoll).
+/// the vehicle sends its id (uint32 big endian) after the connection and then
+/// frames of [size uint32 big endian][StructTelemetry::write_to] - as
+/// ReplayEngine with framing.
+/// the acceptor thread reads the id and passes the connection to the shard
+/// vehicle % shards, so every vehicle has one event loop and its state
+/// is written by one thread. the shard decodes into the preallocated batch
+/// and gives it to the consumer from its thread; the latest state of the
+/// vehicle is published through the seqlock of its slot, so latest() never
+/// blocks the shards
+class IngestServer{
+public:
+	/// called from the threads of the shards
+	typedef std::function< void (int shard, const IngestRecord* records, size_t count) > Consumer;
+
+	/**
+	 * @brief IngestServer
+	 * @param shards - 0: by the count of the cores
+	 * @param batch - max count of the records passed to the consumer at once
+	 */
+	IngestServer(int shards = 0, size_t batch = 256);
+	~IngestServer();
+
+	/**
+	 * @brief set_consumer
+	 * must be set before start
+	 * @param consumer
+	 */
+	void set_consumer(const Consumer& consumer);
+
+	/**
+	 * @brief start
+	 * @param port - 0: any free port, see port()
+	 * @param address
+	 * @return false if the socket, the eventfd or one of the shards is not opened
+	 */
+	bool start(unsigned short port, const std::string& address = "0.0.0.0");
+	void stop();
+	bool is_started() const;
+	unsigned short port() const;
+	int shards() const;
+
+	/**
+	 * @brief shard_of
+	 * @param vehicle
+	 * @return index of the shard which owns the vehicle
+	 */
+	int shard_of(int vehicle) const;
+	/**
+	 * @brief latest
+	 * the last telemetry of the vehicle; may be called from any thread
+	 * @param vehicle
+	 * @param state
+	 * @return false if the vehicle was not connected
+	 */
+	bool latest(int vehicle, VehicleState& state) const;
+	/**
+	 * @brief vehicles
+	 * @return count of the known vehicles
+	 */
+	size_t vehicles() const;
+	IngestStats stats() const;
+
+private:
+	std::vector< IngestShard* > m_shards;
+	size_t m_batch;
+	Consumer m_consumer;
+	int m_listen;
+	int m_wake;
+	unsigned short m_port;
+	std::atomic< bool > m_started;
+	std::thread m_acceptor;
+
+	void accept_loop();
+};
+
+//////////////////////////////////////////////////
+/// \brief The IngestShard class
+/// event loop of the part of the vehicles. one connection is read at most
+/// max_reads times per wakeup, so a busy vehicle does not starve the others
+class IngestShard{
+public:
+	IngestShard(int index, size_t batch);
+	~IngestShard();
+
+	bool start(const IngestServer::Consumer& consumer);
+	void stop();
+	/**
+	 * @brief add_connection
+	 * pass the connection to the loop; from any thread
+	 * @param fd
+	 * @param vehicle
+	 */
+	void add_connection(int fd, int vehicle);
+
+	bool latest(int vehicle, VehicleState& state) const;
+	size_t vehicles() const;
+	IngestStats stats() const;
+
+private:
+	struct Connection{
+		int fd;
+		int vehicle;
+		VehicleSlot* slot;
+		std::vector< char > buffer;
+		size_t used;
+	};
+
+	int m_index;
+	int m_epoll;
+	int m_wake;
+	std::atomic< bool > m_stop;
+	std::thread m_thread;
+	IngestServer::Consumer m_consumer;
+
+	std::mutex m_pending_mutex;
+	std::vector< std::pair< int, int > > m_pending;
+
+	std::unordered_map< int, Connection > m_connections;
+
+	std::vector< IngestRecord > m_batch;
+	size_t m_batch_count;
+
+	/// guards the map only: the slots are created by the thread of the shard and never move
+	mutable std::mutex m_table_mutex;
+	std::unordered_map< int, VehicleSlot* > m_slots;
+
+	std::atomic< long long > m_frames;
+	std::atomic< long long > m_bytes;
+	std::atomic< long long > m_errors;
+	std::atomic< long long > m_open;
+
+	void loop();
+	void accept_pending();
+	/**
+	 * @brief read_connection
+	 * read what came, but not more than max_reads times: the rest is
+	 * reported by the next epoll_wait (level-triggered)
+	 * @param connection
+	 * @return false if the connection should be closed
+	 */
+	bool read_connection(Connection& connection);
+	void close_connection(int fd);
+	void flush();
+};
+
+}
+
+#endif // INGEST_H
@@ -0,0 +1,466 @@
+#include "load_generator.h"
+
+#include <thread>
+#include <algorithm>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "replay.h"
+#include "wire.h"
+#include "trace.h"
+
+using namespace loadgen;
+
+namespace {
+
+const double gravity = 9.80665;
+const double gyro_lsb = 32768.0 / 250.0;		/// LSB per degree/s, fs_sel 0
+const double accel_lsb = 16384.0;				/// LSB per g, afs_sel 0
+const double compass_lsb = 1090.0;				/// LSB per gauss of hmc5883l
+const double field_horizontal = 0.25;			/// gauss
+const double field_vertical = 0.433;			/// gauss, down
+
+/// registers of mpu6050 in raw
+const int raw_first = 0x0d;
+const int reg_smplrt_div = 0x19;
+const int reg_config = 0x1a;
+const int reg_gyro_config = 0x1b;
+const int reg_accel_config = 0x1c;
+const int reg_int_pin_cfg = 0x37;
+const int reg_int_enable = 0x38;
+const int reg_int_status = 0x3a;
+
+inline void put_be(std::vector< char >& out, unsigned long long value, int bytes)
+{
+	for(int i = bytes - 1; i >= 0; i--)
+		out.push_back(static_cast< char >((value >> (8 * i)) & 0xff));
+}
+
+inline int to_int(double value)
+{
+	return static_cast< int >(value < 0? value - 0.5 : value + 0.5);
+}
+
+bool write_all(int fd, const char* data, size_t size)
+{
+	while(size){
+		ssize_t res = ::write(fd, data, size);
+		if(res < 0){
+			if(errno == EINTR)
+				continue;
+			return false;
+		}
+		data += res;
+		size -= static_cast< size_t >(res);
+	}
+	return true;
+}
+
+}
+
+////////////////////////////////////////////////
+
+Profile::Profile()
+{
+	tilt = 2;
+	tilt_period = 3;
+	yaw_rate = 0;
+	base_height = 10;
+	climb_rate = 0;
+	heave = 0.2;
+	heave_period = 4;
+	vibration_freq = 137;
+	vibration = 150;
+}
+
+Profile Profile::hover()
+{
+	return Profile();
+}
+
+Profile Profile::circle()
+{
+	Profile res;
+	res.tilt = 15;
+	res.tilt_period = 12;
+	res.yaw_rate = 30;
+	res.heave = 0.5;
+	return res;
+}
+
+Profile Profile::climb()
+{
+	Profile res;
+	res.tilt = 5;
+	res.base_height = 0;
+	res.climb_rate = 2;
+	res.heave = 1;
+	res.heave_period = 6;
+	return res;
+}
+
+Noise::Noise()
+{
+	gyro = 4;
+	accel = 40;
+	compass = 2;
+	pressure = 3;
+}
+
+Rates::Rates()
+{
+	gyroscope = 1000;
+	compass = 75;
+	barometer = 50;
+	controls = 50;
+	ticks_per_second = 1000;
+}
+
+////////////////////////////////////////////////
+
+SensorGenerator::SensorGenerator(unsigned long long seed, const Profile &profile, const Noise &noise, const Rates &rates)
+{
+	m_profile = profile;
+	m_noise = noise;
+	m_rates = rates;
+	if(m_rates.gyroscope <= 0)
+		m_rates.gyroscope = 1000;
+	if(m_rates.ticks_per_second <= 0)
+		m_rates.ticks_per_second = 1000;
+	m_state = (seed + 1) * 0x9e3779b97f4a7c15ULL | 1;
+	m_index = -1;
+	m_time = 0;
+	m_phase = (gauss() + 4) * M_PI;
+	m_next_compass = m_next_barometer = m_next_controls = 0;
+	m_tangaj = m_bank = m_course = 0;
+	m_height = m_profile.base_height;
+
+	/// registers matching the rate and the ranges
+	unsigned char* raw = m_gyroscope.raw;
+	raw[0] = 0x4c;
+	raw[1] = 0x4d;
+	raw[2] = 0x4b;
+	raw[3] = 0x55;
+	bool dlpf = m_rates.gyroscope <= 1000;
+	int divider = to_int((dlpf? 1000 : 8000) / m_rates.gyroscope) - 1;
+	raw[reg_smplrt_div - raw_first] = static_cast< unsigned char >(std::max(0, std::min(255, divider)));
+	raw[reg_config - raw_first] = dlpf? 0x01 : 0x00;
+	raw[reg_gyro_config - raw_first] = 0;
+	raw[reg_accel_config - raw_first] = 0;
+	raw[reg_int_pin_cfg - raw_first] = 0x02;
+	raw[reg_int_enable - raw_first] = 0x01;
+	raw[reg_int_status - raw_first] = 0x01;
+	m_gyroscope.fs_sel = 0;
+	m_gyroscope.afs_sel = 0;
+	m_gyroscope.freq = static_cast< float >(m_rates.gyroscope);
+}
+
+int SensorGenerator::step()
+{
+	const Profile& p = m_profile;
+	m_index++;
+	m_time = m_index / m_rates.gyroscope;
+	double t = m_time;
+
+	double w = 2 * M_PI / p.tilt_period;
+	double s = sin(w * t + m_phase), c = cos(w * t + m_phase);
+	m_tangaj = p.tilt * s;
+	m_bank = p.tilt * c;
+	m_course = fmod(p.yaw_rate * t + common_::rad2angle(m_phase), 360.0);
+	if(m_course < 0)
+		m_course += 360;
+	double wh = 2 * M_PI / p.heave_period;
+	double sh = sin(wh * t);
+	m_height = p.base_height + p.climb_rate * t + p.heave * sh;
+	double vertical = -p.heave * wh * wh * sh;
+
+	/// rates of the euler angles to the body rates (degrees/s)
+	double d_tangaj = p.tilt * w * c, d_bank = -p.tilt * w * s, d_course = p.yaw_rate;
+	double th = common_::angle2rad(m_tangaj), ph = common_::angle2rad(m_bank), ps = common_::angle2rad(m_course);
+	double sth = sin(th), cth = cos(th), sph = sin(ph), cph = cos(ph);
+	double wx = d_bank - d_course * sth;
+	double wy = d_tangaj * cph + d_course * sph * cth;
+	double wz = -d_tangaj * sph + d_course * cph * cth;
+	m_gyroscope.gyro = vector3_::Vector3i(to_int(wx * gyro_lsb + m_noise.gyro * gauss()),
+										  to_int(wy * gyro_lsb + m_noise.gyro * gauss()),
+										  to_int(wz * gyro_lsb + m_noise.gyro * gauss()));
+
+	/// the specific force (up) in the body frame and the vibration of the engines
+	double g = accel_lsb * (1 + vertical / gravity);
+	double vib = p.vibration * sin(2 * M_PI * p.vibration_freq * t);
+	m_gyroscope.accel = vector3_::Vector3i(to_int(-g * sth + vib + m_noise.accel * gauss()),
+										   to_int(g * sph * cth + vib + m_noise.accel * gauss()),
+										   to_int(g * cph * cth + vib + m_noise.accel * gauss()));
+	m_gyroscope.temp = static_cast< float >(30 + 0.05 * gauss());
+	m_gyroscope.tick = tick();
+
+	int res = GyroscopeUpdated;
+	if(t >= m_next_compass){
+		m_next_compass += 1 / m_rates.compass;
+		/// earth field rotated by -course, then by the inverse tangaj and bank
+		double vx = field_horizontal * cos(ps), vy = -field_horizontal * sin(ps), vz = -field_vertical;
+		double ux = vx * cth - vz * sth, uy = vy, uz = vx * sth + vz * cth;
+		m_compass.data = vector3_::Vector3i(to_int(ux * compass_lsb + m_noise.compass * gauss()),
+											to_int((uy * cph + uz * sph) * compass_lsb + m_noise.compass * gauss()),
+											to_int((-uy * sph + uz * cph) * compass_lsb + m_noise.compass * gauss()));
+		m_compass.tick = m_gyroscope.tick;
+		res |= CompassUpdated;
+	}
+	if(t >= m_next_barometer){
+		m_next_barometer += 1 / m_rates.barometer;
+		double pressure = 101325.0 * pow(1 - 2.25577e-5 * m_height, 5.25588);
+		m_barometer.data = to_int(pressure + m_noise.pressure * gauss());
+		m_barometer.temp = 250;
+		m_barometer.tick = m_gyroscope.tick;
+		res |= BarometerUpdated;
+	}
+	if(t >= m_next_controls){
+		m_next_controls += 1 / m_rates.controls;
+		res |= ControlsDue;
+	}
+	return res;
+}
+
+double SensorGenerator::time() const
+{
+	return m_time;
+}
+
+const sc::StructGyroscope &SensorGenerator::gyroscope() const
+{
+	return m_gyroscope;
+}
+
+const sc::StructCompass &SensorGenerator::compass() const
+{
+	return m_compass;
+}
+
+const sc::StructBarometer &SensorGenerator::barometer() const
+{
+	return m_barometer;
+}
+
+void SensorGenerator::telemetry(sc::StructTelemetry &telemetry) const
+{
+	telemetry.gyroscope = m_gyroscope;
+	telemetry.compass = m_compass;
+	telemetry.barometer = m_barometer;
+	telemetry.tangaj = static_cast< float >(m_tangaj);
+	telemetry.bank = static_cast< float >(m_bank);
+	telemetry.course = static_cast< float >(m_course);
+	telemetry.height = static_cast< float >(m_height);
+
+	sc::StructControls c;
+	controls(c);
+	telemetry.power_on = c.power_on;
+	m_mixer.mix(c, telemetry.power);
+}
+
+void SensorGenerator::controls(sc::StructControls &controls) const
+{
+	const Profile& p = m_profile;
+	double wh = 2 * M_PI / p.heave_period;
+	double vertical = -p.heave * wh * wh * sin(wh * m_time);
+	controls.power_on = true;
+	controls.throttle = static_cast< float >(std::max(0.0, std::min(1.0, 0.5 * (1 + vertical / gravity))));
+	controls.tangaj = static_cast< float >(m_tangaj / 45);
+	controls.bank = static_cast< float >(m_bank / 45);
+	controls.yaw = static_cast< float >(p.yaw_rate / 180);
+}
+
+int SensorGenerator::next(sc::StructTelemetry &telemetry)
+{
+	int res = step();
+	this->telemetry(telemetry);
+	return res;
+}
+
+double SensorGenerator::gauss()
+{
+	/// xorshift64*, sum of four uniform values (approximately normal)
+	m_state ^= m_state >> 12;
+	m_state ^= m_state << 25;
+	m_state ^= m_state >> 27;
+	unsigned long long r = m_state * 0x2545f4914f6cdd1dULL;
+	double sum = 0;
+	FOREACH(i, 4, sum += static_cast< double >((r >> (16 * i)) & 0xffff));
+	return (sum / 65536.0 - 2) * 1.7320508075688772;
+}
+
+long long SensorGenerator::tick() const
+{
+	return static_cast< long long >(m_time * m_rates.ticks_per_second);
+}
+
+////////////////////////////////////////////////
+
+GeneratorStats::GeneratorStats()
+{
+	frames = controls = bytes = 0;
+	seconds = frames_per_s = 0;
+}
+
+////////////////////////////////////////////////
+
+LoadGenerator::LoadGenerator(int workers, const Profile &profile, const Noise &noise, const Rates &rates)
+{
+	if(workers <= 0)
+		workers = std::max(1, static_cast< int >(std::thread::hardware_concurrency()));
+	m_workers = workers;
+	m_profile = profile;
+	m_noise = noise;
+	m_rates = rates;
+	m_seed = 1;
+	m_first_vehicle = 0;
+	m_framing = Sized;
+	m_controls = false;
+	m_rate = 0;
+	m_chunk = 256;
+}
+
+int LoadGenerator::workers() const
+{
+	return m_workers;
+}
+
+void LoadGenerator::set_seed(unsigned long long seed)
+{
+	m_seed = seed;
+}
+
+void LoadGenerator::set_first_vehicle(int vehicle)
+{
+	m_first_vehicle = vehicle;
+}
+
+void LoadGenerator::set_framing(LoadGenerator::Framing framing)
+{
+	m_framing = framing;
+}
+
+void LoadGenerator::set_controls(bool controls)
+{
+	m_controls = controls;
+}
+
+void LoadGenerator::set_rate(double frames_per_second)
+{
+	m_rate = frames_per_second > 0? frames_per_second : 0;
+}
+
+void LoadGenerator::set_chunk(size_t frames)
+{
+	m_chunk = frames? frames : 1;
+}
+
+GeneratorStats LoadGenerator::run(long long frames, const LoadGenerator::Sink &sink)
+{
+	std::vector< GeneratorStats > stats(m_workers);
+	std::vector< std::thread > threads;
+	long long start = replay::ReplayEngine::now_ns();
+	for(int w = 0; w < m_workers; w++){
+		long long count = frames / m_workers + (w < frames % m_workers? 1 : 0);
+		threads.push_back(std::thread(&LoadGenerator::work, this, w, count, std::cref(sink), std::ref(stats[w])));
+	}
+	for(size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+
+	GeneratorStats res;
+	for(size_t i = 0; i < stats.size(); i++){
+		res.frames += stats[i].frames;
+		res.controls += stats[i].controls;
+		res.bytes += stats[i].bytes;
+	}
+	res.seconds = (replay::ReplayEngine::now_ns() - start) / 1e9;
+	res.frames_per_s = res.seconds > 0? res.frames / res.seconds : 0;
+	return res;
+}
+
+GeneratorStats LoadGenerator::run(long long frames, std::vector<std::vector<char> > &buffers)
+{
+	buffers.assign(m_workers, std::vector< char >());
+	return run(frames, [&buffers](int worker, const char* data, size_t size){
+		buffers[worker].insert(buffers[worker].end(), data, data + size);
+		return true;
+	});
+}
+
+LoadGenerator::Sink LoadGenerator::fd_sink(const std::vector<int> &fds)
+{
+	return [fds](int worker, const char* data, size_t size){
+		return !fds.empty() && write_all(fds[worker % fds.size()], data, size);
+	};
+}
+
+bool LoadGenerator::send_hello(int fd, int vehicle)
+{
+	std::vector< char > id;
+	put_be(id, static_cast< unsigned >(vehicle), 4);
+	return write_all(fd, &id[0], id.size());
+}
+
+void LoadGenerator::work(int worker, long long frames, const LoadGenerator::Sink &sink, GeneratorStats &stats) const
+{
+	/// the samples depend on the vehicle, not on the count of the workers
+	SensorGenerator generator(m_seed + static_cast< unsigned long long >(m_first_vehicle + worker) * 7919ULL,
+							  m_profile, m_noise, m_rates);
+	sc::StructTelemetry telemetry;
+	sc::StructControls controls;
+	std::vector< char > chunk, data;
+	trace::TraceStamps stamps;
+	/// seconds per frame of this worker
+	double period = m_rate > 0? m_workers / m_rate : 0;
+	long long start = replay::ReplayEngine::now_ns();
+
+	long long done = 0;
+	while(done < frames){
+		chunk.clear();
+		long long count = 0, count_controls = 0;
+		for(; count < static_cast< long long >(m_chunk) && done < frames; done++){
+			int updated = generator.next(telemetry);
+			long long tick = telemetry.gyroscope.tick;
+			if(trace::enabled){
+				stamps = trace::TraceStamps();
+				stamps.mark(trace::Sample);
+			}
+			wire::encode(telemetry, data, stamps);
+			/// the chunk is the send queue of the worker
+			stamps.mark(trace::Enqueue);
+			trace::append(data, stamps);
+			if(m_framing == Recorded){
+				put_be(chunk, static_cast< unsigned long long >(tick), 8);
+				put_be(chunk, replay::RecordedFrame::Telemetry, 4);
+			}
+			put_be(chunk, data.size(), 4);
+			chunk.insert(chunk.end(), data.begin(), data.end());
+			count++;
+
+			if(m_controls && (updated & SensorGenerator::ControlsDue)){
+				generator.controls(controls);
+				wire::encode(controls, data);
+				if(m_framing == Recorded){
+					put_be(chunk, static_cast< unsigned long long >(tick), 8);
+					put_be(chunk, replay::RecordedFrame::Controls, 4);
+				}
+				put_be(chunk, data.size(), 4);
+				chunk.insert(chunk.end(), data.begin(), data.end());
+				count_controls++;
+			}
+		}
+		if(period > 0){
+			long long deadline = start + static_cast< long long >(done * period * 1e9);
+			timespec ts;
+			ts.tv_sec = deadline / 1000000000LL;
+			ts.tv_nsec = deadline % 1000000000LL;
+			while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0) == EINTR){
+			}
+		}
+		if(!sink(worker, &chunk[0], chunk.size()))
+			break;
+		stats.frames += count;
+		stats.controls += count_controls;
+		stats.bytes += static_cast< long long >(chunk.size());
+	}
+}
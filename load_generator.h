@@ -0,0 +1,252 @@
+#ifndef LOAD_GENERATOR_H
+#define LOAD_GENERATOR_H
+
+#include <vector>
+#include <functional>
+#include <stddef.h>
+
+#include "struct_controls.h"
+#include "mixer.h"
+
+namespace loadgen{
+
+/**
+ * @brief The Profile struct
+ * motion of the vehicle:
+ * tangaj = tilt * sin(w t), bank = tilt * cos(w t), w = 2 pi / tilt_period,
+ * course = yaw_rate * t, height = base_height + climb_rate * t + heave * sin(2 pi t / heave_period)
+ */
+struct Profile{
+	Profile();
+
+	static Profile hover();
+	static Profile circle();
+	static Profile climb();
+
+	double tilt;				/// degrees
+	double tilt_period;			/// s
+	double yaw_rate;			/// degrees/s
+	double base_height;			/// m
+	double climb_rate;			/// m/s
+	double heave;				/// m
+	double heave_period;		/// s
+	double vibration_freq;		/// Hz, vibration of the engines on the accelerometer
+	double vibration;			/// LSB of the accelerometer
+};
+
+/**
+ * @brief The Noise struct
+ * standard deviations of the sensors
+ */
+struct Noise{
+	Noise();
+
+	double gyro;				/// LSB
+	double accel;				/// LSB
+	double compass;				/// LSB
+	double pressure;			/// Pa
+};
+
+/**
+ * @brief The Rates struct
+ * rates of the sensors (Hz); ticks are in 1 / ticks_per_second
+ */
+struct Rates{
+	Rates();
+
+	double gyroscope;
+	double compass;
+	double barometer;
+	double controls;
+	double ticks_per_second;
+};
+
+//////////////////////////////////////////////////
+/// \brief The SensorGenerator class
+/// deterministic sensors of mpu6050 (fs_sel 0, afs_sel 0), hmc5883l and the
+/// barometer for the motion profile. the values are consistent with the
+/// conventions of HeightEstimator and compass::heading; raw holds the
+/// registers 0x0d..0x3a matching the rate and the ranges
+class SensorGenerator{
+public:
+	enum Updated{
+		GyroscopeUpdated = 1,
+		CompassUpdated = 2,
+		BarometerUpdated = 4,
+		ControlsDue = 8
+	};
+
+	SensorGenerator(unsigned long long seed = 1, const Profile& profile = Profile::hover(),
+					const Noise& noise = Noise(), const Rates& rates = Rates());
+
+	/**
+	 * @brief step
+	 * advance by one sample of the gyroscope
+	 * @return mask of Updated
+	 */
+	int step();
+	/**
+	 * @brief time
+	 * @return seconds from the start
+	 */
+	double time() const;
+
+	const sc::StructGyroscope& gyroscope() const;
+	const sc::StructCompass& compass() const;
+	const sc::StructBarometer& barometer() const;
+	/**
+	 * @brief telemetry
+	 * sensors with the true attitude, height and power of the engines
+	 * @param telemetry
+	 */
+	void telemetry(sc::StructTelemetry& telemetry) const;
+	/**
+	 * @brief controls
+	 * the command of the pilot for the profile at the current time
+	 * @param controls
+	 */
+	void controls(sc::StructControls& controls) const;
+
+	/**
+	 * @brief next
+	 * step and fill the telemetry
+	 * @param telemetry
+	 * @return mask of Updated
+	 */
+	int next(sc::StructTelemetry& telemetry);
+
+private:
+	Profile m_profile;
+	Noise m_noise;
+	Rates m_rates;
+	unsigned long long m_state;
+	long long m_index;
+	double m_time;
+	double m_phase;
+	double m_next_compass;
+	double m_next_barometer;
+	double m_next_controls;
+
+	double m_tangaj;
+	double m_bank;
+	double m_course;
+	double m_height;
+
+	sc::StructGyroscope m_gyroscope;
+	sc::StructCompass m_compass;
+	sc::StructBarometer m_barometer;
+	mixer::MixerQuadX m_mixer;
+
+	double gauss();
+	long long tick() const;
+};
+
+/**
+ * @brief The GeneratorStats struct
+ */
+struct GeneratorStats{
+	GeneratorStats();
+
+	long long frames;			/// telemetry frames
+	long long controls;			/// StructControls frames (set_controls)
+	long long bytes;			/// of all frames with the framing
+	double seconds;
+	double frames_per_s;		/// telemetry frames per second
+};
+
+//////////////////////////////////////////////////
+/// \brief The LoadGenerator class
+/// encodes the frames of many simulated vehicles on several threads.
+/// every worker has its own SensorGenerator (vehicle first_vehicle + worker)
+/// and gives the chunks of the encoded frames to the sink from its thread
+class LoadGenerator{
+public:
+	enum Framing{
+		Sized,				/// [size uint32][data] - ReplayEngine::run, IngestServer
+		Recorded			/// [tick int64][type int32][size uint32][data] - ReplayEngine::load
+	};
+
+	/// returns false to stop the worker
+	typedef std::function< bool (int worker, const char* data, size_t size) > Sink;
+
+	/**
+	 * @brief LoadGenerator
+	 * @param workers - 0: by the count of the cores
+	 */
+	LoadGenerator(int workers = 0, const Profile& profile = Profile::hover(),
+				  const Noise& noise = Noise(), const Rates& rates = Rates());
+
+	int workers() const;
+	void set_seed(unsigned long long seed);
+	void set_first_vehicle(int vehicle);
+	void set_framing(Framing framing);
+	/**
+	 * @brief set_controls
+	 * add StructControls frames at the rate of the controls
+	 * @param controls
+	 */
+	void set_controls(bool controls);
+	/**
+	 * @brief set_rate
+	 * total telemetry frames per second of all workers, 0 - unlimited
+	 * @param frames_per_second
+	 */
+	void set_rate(double frames_per_second);
+	/**
+	 * @brief set_chunk
+	 * telemetry frames in one call of the sink
+	 * @param frames
+	 */
+	void set_chunk(size_t frames);
+
+	/**
+	 * @brief run
+	 * generate the telemetry frames divided between the workers
+	 * @param frames
+	 * @param sink
+	 * @return
+	 */
+	GeneratorStats run(long long frames, const Sink& sink);
+	/**
+	 * @brief run
+	 * to the memory: one buffer per worker
+	 * @param frames
+	 * @param buffers
+	 * @return
+	 */
+	GeneratorStats run(long long frames, std::vector< std::vector< char > >& buffers);
+
+	/**
+	 * @brief fd_sink
+	 * the worker writes to fds[worker % size] (files, sockets, pipes)
+	 * @param fds
+	 * @return
+	 */
+	static Sink fd_sink(const std::vector< int >& fds);
+	/**
+	 * @brief send_hello
+	 * the id of the vehicle expected by IngestServer after the connection
+	 * @param fd
+	 * @param vehicle
+	 * @return
+	 */
+	static bool send_hello(int fd, int vehicle);
+
+private:
+	int m_workers;
+	Profile m_profile;
+	Noise m_noise;
+	Rates m_rates;
+	unsigned long long m_seed;
+	int m_first_vehicle;
+	Framing m_framing;
+	bool m_controls;
+	double m_rate;
+	size_t m_chunk;
+
+	void work(int worker, long long frames, const Sink& sink, GeneratorStats& stats) const;
+};
+
+}
+
+#endif // LOAD_GENERATOR_H
@@ -0,0 +1,297 @@
+#ifndef MIXER_H
+#define MIXER_H
+
+#include <stddef.h>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "common_.h"
+#include "struct_controls.h"
+
+namespace mixer{
+
+/**
+ * @brief The FrameType enum
+ * FrameX - the nose is between two engines, FramePlus - engine 0 is on the nose.
+ * engines are numbered clockwise (view from above), engine 0 rotates counterclockwise
+ * and the direction of rotation alternates
+ */
+enum FrameType{
+	FrameX,
+	FramePlus
+};
+
+/**
+ * @brief The MixMatrix_ struct
+ * factors of the commands for every engine
+ */
+template< int engines >
+struct MixMatrix_{
+	float bank[engines];		/// roll, positive - right side down
+	float tangaj[engines];		/// pitch, positive - nose up
+	float yaw[engines];			/// positive - clockwise from above
+};
+
+/**
+ * @brief make_matrix
+ * mixing matrix for the engines placed evenly on the circle.
+ * roll and pitch columns are scaled so that the maximum factor is 1
+ * @return
+ */
+template< int engines, FrameType frame >
+constexpr MixMatrix_< engines > make_matrix()
+{
+	MixMatrix_< engines > m = {};
+	double offset = frame == FrameX? 180.0 / engines : 0;
+	double max_bank = 0, max_tangaj = 0;
+	for(int i = 0; i < engines; i++){
+		double a = common_::angle2rad(offset + 360.0 * i / engines);
+		double b = -common_::cx_sin(a);
+		double t = common_::cx_cos(a);
+		/// remove the noise of the series for the engines on the axes
+		if(common_::fIsNull(b)) b = 0;
+		if(common_::fIsNull(t)) t = 0;
+		m.bank[i] = static_cast< float >(b);
+		m.tangaj[i] = static_cast< float >(t);
+		m.yaw[i] = i % 2 == 0? 1.f : -1.f;
+		if((b < 0? -b : b) > max_bank) max_bank = b < 0? -b : b;
+		if((t < 0? -t : t) > max_tangaj) max_tangaj = t < 0? -t : t;
+	}
+	for(int i = 0; i < engines; i++){
+		m.bank[i] = static_cast< float >(m.bank[i] / max_bank);
+		m.tangaj[i] = static_cast< float >(m.tangaj[i] / max_tangaj);
+	}
+	return m;
+}
+
+//////////////////////////////////////////////////
+/// \brief The Mixer_ class
+/// converts throttle/tangaj/bank/yaw to the power of the engines.
+/// throttle is expected in the range of the power, the other commands in [-1; 1].
+/// when the outputs do not fit in [min_power; max_power] the yaw is reduced first,
+/// then roll and pitch are scaled and at last the throttle is shifted
+template< int engines, FrameType frame = FrameX >
+class Mixer_{
+public:
+	static_assert(engines >= 4 && engines % 2 == 0, "count of the engines must be even and not less than 4");
+
+	typedef MixMatrix_< engines > Matrix;
+	enum{
+		count = engines
+	};
+	static constexpr Matrix matrix = make_matrix< engines, frame >();
+
+	Mixer_(float min_power = 0, float max_power = 1){
+		set_range(min_power, max_power);
+	}
+	void set_range(float min_power, float max_power){
+		m_min = min_power;
+		m_max = max_power > min_power? max_power : min_power;
+	}
+	float min_power() const{
+		return m_min;
+	}
+	float max_power() const{
+		return m_max;
+	}
+
+	/**
+	 * @brief mix
+	 * @param throttle
+	 * @param tangaj
+	 * @param bank
+	 * @param yaw
+	 * @param power - array of engines values
+	 * @return true if the command was limited
+	 */
+	bool mix(float throttle, float tangaj, float bank, float yaw, float* power) const{
+		float att[engines], y[engines];
+		float amin = 0, amax = 0, mmin = 0, mmax = 0;
+		for(int i = 0; i < engines; i++){
+			att[i] = matrix.bank[i] * bank + matrix.tangaj[i] * tangaj;
+			y[i] = matrix.yaw[i] * yaw;
+			float m = att[i] + y[i];
+			if(!i){
+				amin = amax = att[i];
+				mmin = mmax = m;
+			}else{
+				if(att[i] < amin) amin = att[i];
+				if(att[i] > amax) amax = att[i];
+				if(m < mmin) mmin = m;
+				if(m > mmax) mmax = m;
+			}
+		}
+		float sa, sy;
+		bool saturated = desaturate(amax - amin, mmax - mmin, sa, sy);
+
+		float lo = 0, hi = 0;
+		for(int i = 0; i < engines; i++){
+			float m = att[i] * sa + y[i] * sy;
+			att[i] = m;
+			if(!i || m < lo) lo = m;
+			if(!i || m > hi) hi = m;
+		}
+		float t = shift_throttle(throttle, lo, hi, saturated);
+		for(int i = 0; i < engines; i++)
+			power[i] = clamp(t + att[i]);
+		return saturated;
+	}
+	/**
+	 * @brief mix
+	 * engines are off when power_on is false
+	 * @param controls
+	 * @param power
+	 * @return
+	 */
+	bool mix(const sc::StructControls& controls, float* power) const{
+		if(!controls.power_on){
+			for(int i = 0; i < engines; i++)
+				power[i] = m_min;
+			return false;
+		}
+		return mix(controls.throttle, controls.tangaj, controls.bank, controls.yaw, power);
+	}
+	/**
+	 * @brief apply
+	 * write the result to StructTelemetry::power (only for cnt_engines engines)
+	 * @param controls
+	 * @param telemetry
+	 * @return
+	 */
+	bool apply(const sc::StructControls& controls, sc::StructTelemetry& telemetry) const{
+		static_assert(engines == sc::cnt_engines, "StructTelemetry has cnt_engines engines");
+		telemetry.power_on = controls.power_on;
+		return mix(controls, telemetry.power);
+	}
+	/**
+	 * @brief mix
+	 * batch of the commands for simulation. power is count * engines values
+	 * @param controls
+	 * @param power
+	 * @param count
+	 * @return count of the limited commands
+	 */
+	size_t mix(const sc::StructControls* controls, float* power, size_t count) const{
+		size_t saturated = 0;
+		for(size_t i = 0; i < count; i++){
+			const sc::StructControls& c = controls[i];
+			float* p = power + i * engines;
+			if(!c.power_on){
+				for(int j = 0; j < engines; j++)
+					p[j] = m_min;
+				continue;
+			}
+#ifdef __SSE__
+			if(engines % 4 == 0){
+				saturated += mix_sse(c.throttle, c.tangaj, c.bank, c.yaw, p);
+				continue;
+			}
+#endif
+			saturated += mix(c.throttle, c.tangaj, c.bank, c.yaw, p);
+		}
+		return saturated;
+	}
+
+private:
+	float m_min;
+	float m_max;
+
+	inline float clamp(float value) const{
+		return value < m_min? m_min : (value > m_max? m_max : value);
+	}
+	/**
+	 * @brief desaturate
+	 * scale of roll/pitch (sa) and yaw (sy) so that the span of the outputs fits the range
+	 */
+	inline bool desaturate(float span_att, float span_all, float& sa, float& sy) const{
+		float range = m_max - m_min;
+		sa = sy = 1;
+		if(span_att > range){
+			sa = range / span_att;
+			sy = 0;
+			return true;
+		}
+		if(span_all > range){
+			/// span is convex on the yaw factor, so the linear estimation always fits
+			sy = (range - span_att) / (span_all - span_att);
+			return true;
+		}
+		return false;
+	}
+	inline float shift_throttle(float throttle, float lo, float hi, bool& saturated) const{
+		float t = throttle;
+		if(t + lo < m_min)
+			t = m_min - lo;
+		if(t + hi > m_max)
+			t = m_max - hi;
+		if(t != throttle)
+			saturated = true;
+		return t;
+	}
+
+#ifdef __SSE__
+	static inline float hmin(__m128 v){
+		v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+		v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(v);
+	}
+	static inline float hmax(__m128 v){
+		v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+		v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(v);
+	}
+	/**
+	 * @brief mix_sse
+	 * the same as mix() with four engines per register
+	 */
+	inline bool mix_sse(float throttle, float tangaj, float bank, float yaw, float* power) const{
+		enum{ blocks = engines / 4 > 0? engines / 4 : 1 };
+		__m128 att[blocks], y[blocks];
+		__m128 vb = _mm_set1_ps(bank), vt = _mm_set1_ps(tangaj), vy = _mm_set1_ps(yaw);
+		__m128 amin, amax, mmin, mmax;
+		for(int k = 0; k < blocks; k++){
+			att[k] = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(matrix.bank + 4 * k), vb),
+								_mm_mul_ps(_mm_loadu_ps(matrix.tangaj + 4 * k), vt));
+			y[k] = _mm_mul_ps(_mm_loadu_ps(matrix.yaw + 4 * k), vy);
+			__m128 m = _mm_add_ps(att[k], y[k]);
+			amin = k? _mm_min_ps(amin, att[k]) : att[k];
+			amax = k? _mm_max_ps(amax, att[k]) : att[k];
+			mmin = k? _mm_min_ps(mmin, m) : m;
+			mmax = k? _mm_max_ps(mmax, m) : m;
+		}
+		float sa, sy;
+		bool saturated = desaturate(hmax(amax) - hmin(amin), hmax(mmax) - hmin(mmin), sa, sy);
+
+		__m128 vsa = _mm_set1_ps(sa), vsy = _mm_set1_ps(sy), lo, hi;
+		for(int k = 0; k < blocks; k++){
+			att[k] = _mm_add_ps(_mm_mul_ps(att[k], vsa), _mm_mul_ps(y[k], vsy));
+			lo = k? _mm_min_ps(lo, att[k]) : att[k];
+			hi = k? _mm_max_ps(hi, att[k]) : att[k];
+		}
+		__m128 vt2 = _mm_set1_ps(shift_throttle(throttle, hmin(lo), hmax(hi), saturated));
+		__m128 vmin = _mm_set1_ps(m_min), vmax = _mm_set1_ps(m_max);
+		for(int k = 0; k < blocks; k++)
+			_mm_storeu_ps(power + 4 * k, _mm_min_ps(_mm_max_ps(_mm_add_ps(vt2, att[k]), vmin), vmax));
+		return saturated;
+	}
+#endif
+};
+
+template< int engines, FrameType frame >
+constexpr typename Mixer_< engines, frame >::Matrix Mixer_< engines, frame >::matrix;
+
+typedef Mixer_< 4, FrameX > MixerQuadX;
+typedef Mixer_< 4, FramePlus > MixerQuadPlus;
+typedef Mixer_< 6, FrameX > MixerHexa;
+typedef Mixer_< 8, FrameX > MixerOcto;
+
+static_assert(MixerQuadX::matrix.tangaj[0] == 1.f && MixerQuadX::matrix.bank[0] == -1.f,
+			  "engine 0 of quad X is front right");
+static_assert(MixerQuadPlus::matrix.tangaj[0] == 1.f && MixerQuadPlus::matrix.bank[0] == 0.f,
+			  "engine 0 of quad + is on the nose");
+
+}
+
+#endif // MIXER_H
@@ -0,0 +1,140 @@
+#ifndef PRECISION_H
+#define PRECISION_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "common_.h"
+
+namespace precision{
+
+//////////////////////////////////////////////////
+/// \brief The Exact struct
+/// policy with the functions from math.h
+/// (usable in constant expressions)
+struct Exact{
+	static constexpr inline double sqrt(double value){
+		return common_::cx_sqrt(value);
+	}
+	static constexpr inline double rsqrt(double value){
+		return 1.0 / common_::cx_sqrt(value);
+	}
+	static constexpr inline double sin(double rad){
+		return common_::cx_sin(rad);
+	}
+	static constexpr inline double cos(double rad){
+		return common_::cx_cos(rad);
+	}
+	static inline double acos(double value){
+		return ::acos(value);
+	}
+	static inline double atan2(double y, double x){
+		return ::atan2(y, x);
+	}
+};
+
+//////////////////////////////////////////////////
+/// \brief The Fast struct
+/// policy with the approximations. maximum errors:
+/// rsqrt	- 2.5e-7 relative (for values in the float range)
+/// sqrt	- 2.5e-7 relative
+/// sin/cos	- 6e-8 absolute
+/// acos	- 7e-8 absolute for values in [-1; 1]
+/// atan2	- 3e-8 absolute
+struct Fast{
+	/**
+	 * @brief rsqrt
+	 * hardware estimation (or bit trick) and refinement by newton steps
+	 * @param value
+	 * @return
+	 */
+	static inline double rsqrt(double value){
+#ifdef __SSE__
+		double y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(static_cast< float >(value))));
+		return y * (1.5 - 0.5 * value * y * y);
+#else
+		int64_t i;
+		memcpy(&i, &value, sizeof(i));
+		i = 0x5FE6EB50C7B537A9LL - (i >> 1);
+		double y;
+		memcpy(&y, &i, sizeof(y));
+		y = y * (1.5 - 0.5 * value * y * y);
+		y = y * (1.5 - 0.5 * value * y * y);
+		y = y * (1.5 - 0.5 * value * y * y);
+		return y;
+#endif
+	}
+	static inline double sqrt(double value){
+		if(value <= 0)
+			return 0;
+		return value * rsqrt(value);
+	}
+	/**
+	 * @brief sin
+	 * reduction to [-pi/2; pi/2] and polynomial of the 11th degree
+	 * @param rad
+	 * @return
+	 */
+	static inline double sin(double rad){
+		const double pi2 = 2 * M_PI;
+		double n = rad * (1 / pi2);
+		n = static_cast< double >(static_cast< long long >(n < 0 ? n - 0.5 : n + 0.5));
+		double x = rad - pi2 * n;
+		if(x > M_PI_2)
+			x = M_PI - x;
+		else if(x < -M_PI_2)
+			x = -M_PI - x;
+		double x2 = x * x;
+		return x * (1 + x2 * (-1.0 / 6 + x2 * (1.0 / 120 + x2 * (-1.0 / 5040 +
+				x2 * (1.0 / 362880 + x2 * (-1.0 / 39916800))))));
+	}
+	static inline double cos(double rad){
+		return sin(rad + M_PI_2);
+	}
+	/**
+	 * @brief acos
+	 * Abramowitz and Stegun 4.4.46
+	 * @param value
+	 * @return
+	 */
+	static inline double acos(double value){
+		bool negate = value < 0;
+		double x = negate ? -value : value;
+		if(x > 1)
+			x = 1;
+		double res = 1.5707963050 + x * (-0.2145988016 + x * (0.0889789874 + x * (-0.0501743046 +
+				x * (0.0308918810 + x * (-0.0170881256 + x * (0.0066700901 + x * -0.0012624911))))));
+		res *= ::sqrt(1 - x);
+		return negate ? M_PI - res : res;
+	}
+	/**
+	 * @brief atan2
+	 * reduction to [0; 1] and Abramowitz and Stegun 4.4.49. no branches on the data
+	 * except the selects, so loops over arrays can be vectorized
+	 * @param y
+	 * @param x
+	 * @return
+	 */
+	static inline double atan2(double y, double x){
+		double ax = x < 0 ? -x : x;
+		double ay = y < 0 ? -y : y;
+		double mx = ax > ay ? ax : ay;
+		double mn = ax > ay ? ay : ax;
+		double z = mx > 0 ? mn / mx : 0;
+		double z2 = z * z;
+		double r = z * (1 + z2 * (-0.3333314528 + z2 * (0.1999355085 + z2 * (-0.1420889944 +
+				z2 * (0.1065626393 + z2 * (-0.0752896400 + z2 * (0.0429096138 +
+				z2 * (-0.0161657367 + z2 * 0.0028662257))))))));
+		r = ay > ax ? M_PI_2 - r : r;
+		r = x < 0 ? M_PI - r : r;
+		return y < 0 ? -r : r;
+	}
+};
+
+}
+
+#endif // PRECISION_H
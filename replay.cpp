@@ -0,0 +1,350 @@
+#include "replay.h"
+
+#include <fstream>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "wire.h"
+#include "trace.h"
+
+using namespace replay;
+
+namespace {
+
+inline void put_be(std::vector< char >& out, unsigned long long value, int bytes)
+{
+	for(int i = bytes - 1; i >= 0; i--)
+		out.push_back(static_cast< char >((value >> (8 * i)) & 0xff));
+}
+
+inline unsigned long long get_be(const unsigned char* data, int bytes)
+{
+	unsigned long long res = 0;
+	for(int i = 0; i < bytes; i++)
+		res = (res << 8) | data[i];
+	return res;
+}
+
+/**
+ * @brief write_all
+ * write the buffer to the descriptor completely. sockets are written by send with
+ * MSG_NOSIGNAL; socket is cleared when the descriptor is not a socket
+ */
+bool write_all(int fd, const char* data, size_t size, bool& socket)
+{
+	while(size){
+		ssize_t res = socket? ::send(fd, data, size, MSG_NOSIGNAL) : ::write(fd, data, size);
+		if(res < 0){
+			if(errno == EINTR)
+				continue;
+			if(socket && errno == ENOTSOCK){
+				socket = false;
+				continue;
+			}
+			return false;
+		}
+		data += res;
+		size -= static_cast< size_t >(res);
+	}
+	return true;
+}
+
+/**
+ * @brief The SigpipeBlock class
+ * SIGPIPE of the pipes is blocked in the thread while the object lives;
+ * the pending one is taken before the mask is restored
+ */
+class SigpipeBlock{
+public:
+	SigpipeBlock(){
+		sigemptyset(&m_set);
+		sigaddset(&m_set, SIGPIPE);
+		pthread_sigmask(SIG_BLOCK, &m_set, &m_old);
+	}
+	~SigpipeBlock(){
+		if(!sigismember(&m_old, SIGPIPE)){
+			timespec zero = {0, 0};
+			while(sigtimedwait(&m_set, 0, &zero) == SIGPIPE){
+			}
+			pthread_sigmask(SIG_SETMASK, &m_old, 0);
+		}
+	}
+
+private:
+	sigset_t m_set;
+	sigset_t m_old;
+};
+
+inline int bucket_of(long long ns)
+{
+	int b = 0;
+	while(ns > 0 && b < ReplayStats::buckets - 1){
+		ns >>= 1;
+		b++;
+	}
+	return b;
+}
+
+}
+
+////////////////////////////////////////////////
+
+RecordedFrame::RecordedFrame()
+{
+	tick = 0;
+	type = Telemetry;
+}
+
+////////////////////////////////////////////////
+
+ReplayStats::ReplayStats()
+{
+	frames = bytes = errors = 0;
+	aborted = false;
+	elapsed_s = frames_per_s = lateness_mean_ns = 0;
+	lateness_max_ns = 0;
+	FOREACH(i, buckets, histogram[i] = 0);
+}
+
+long long ReplayStats::lateness_percentile(double p) const
+{
+	long long total = 0;
+	FOREACH(i, buckets, total += histogram[i]);
+	if(!total)
+		return 0;
+	long long need = static_cast< long long >(p * total);
+	long long acc = 0;
+	for(int i = 0; i < buckets; i++){
+		acc += histogram[i];
+		if(acc >= need && acc)
+			return i? (1LL << i) : 0;
+	}
+	return lateness_max_ns;
+}
+
+////////////////////////////////////////////////
+
+ReplayEngine::ReplayEngine()
+{
+	m_speed = 1;
+	m_ticks_per_second = 1000;
+	m_spin_ns = 100000;
+	m_framing = true;
+}
+
+void ReplayEngine::add(const RecordedFrame &frame)
+{
+	m_frames.push_back(frame);
+}
+
+void ReplayEngine::add(const sc::StructTelemetry &telemetry)
+{
+	m_frames.push_back(RecordedFrame());
+	RecordedFrame& frame = m_frames.back();
+	frame.tick = telemetry.gyroscope.tick;
+	frame.type = RecordedFrame::Telemetry;
+	wire::encode(telemetry, frame.data);
+}
+
+void ReplayEngine::add(const sc::StructControls &controls, long long tick)
+{
+	m_frames.push_back(RecordedFrame());
+	RecordedFrame& frame = m_frames.back();
+	frame.tick = tick;
+	frame.type = RecordedFrame::Controls;
+	wire::encode(controls, frame.data);
+}
+
+void ReplayEngine::clear()
+{
+	m_frames.clear();
+}
+
+size_t ReplayEngine::count() const
+{
+	return m_frames.size();
+}
+
+const std::vector<RecordedFrame> &ReplayEngine::frames() const
+{
+	return m_frames;
+}
+
+bool ReplayEngine::load(const std::string &path)
+{
+	m_frames.clear();
+	std::ifstream file(path.c_str(), std::ios::binary);
+	if(!file)
+		return false;
+	std::vector< RecordedFrame > frames;
+	unsigned char header[16];
+	while(file.read(reinterpret_cast< char* >(header), sizeof(header))){
+		RecordedFrame frame;
+		frame.tick = static_cast< long long >(get_be(header, 8));
+		frame.type = static_cast< int >(get_be(header + 8, 4));
+		size_t size = static_cast< size_t >(get_be(header + 12, 4));
+		/// the size is not trusted: a damaged header must not allocate 4 GB
+		if(size > RecordedFrame::max_size)
+			return false;
+		frame.data.resize(size);
+		if(size && !file.read(&frame.data[0], size))
+			return false;
+		frames.push_back(frame);
+	}
+	if(!file.eof())
+		return false;
+	m_frames.swap(frames);
+	return true;
+}
+
+bool ReplayEngine::save(const std::string &path) const
+{
+	std::ofstream file(path.c_str(), std::ios::binary);
+	if(!file)
+		return false;
+	std::vector< char > header;
+	for(size_t i = 0; i < m_frames.size(); i++){
+		const RecordedFrame& frame = m_frames[i];
+		header.clear();
+		put_be(header, static_cast< unsigned long long >(frame.tick), 8);
+		put_be(header, static_cast< unsigned long long >(frame.type), 4);
+		put_be(header, frame.data.size(), 4);
+		file.write(&header[0], header.size());
+		if(!frame.data.empty())
+			file.write(&frame.data[0], frame.data.size());
+	}
+	return static_cast< bool >(file);
+}
+
+void ReplayEngine::set_speed(double speed)
+{
+	m_speed = speed > 0? speed : 0;
+}
+
+void ReplayEngine::set_ticks_per_second(double ticks_per_second)
+{
+	if(ticks_per_second > 0)
+		m_ticks_per_second = ticks_per_second;
+}
+
+void ReplayEngine::set_spin(long long spin_ns)
+{
+	m_spin_ns = spin_ns > 0? spin_ns : 0;
+}
+
+void ReplayEngine::set_framing(bool framing)
+{
+	m_framing = framing;
+}
+
+ReplayStats ReplayEngine::run(int fd, int loops)
+{
+	SigpipeBlock block;
+	bool socket = true;
+	std::vector< char > buffer;
+	return run([fd, &buffer, &socket, this](const char* data, size_t size){
+		if(!m_framing)
+			return write_all(fd, data, size, socket);
+		/// one write per frame
+		buffer.clear();
+		put_be(buffer, size, 4);
+		buffer.insert(buffer.end(), data, data + size);
+		return write_all(fd, &buffer[0], buffer.size(), socket);
+	}, loops, true);
+}
+
+ReplayStats ReplayEngine::run(const Callback &callback, int loops)
+{
+	return run(callback, loops, false);
+}
+
+ReplayStats ReplayEngine::run(const Callback &callback, int loops, bool abort_on_error)
+{
+	ReplayStats stats;
+	if(m_frames.empty() || loops < 1)
+		return stats;
+
+	long long first_tick = m_frames.front().tick;
+	long long last_tick = m_frames.back().tick;
+	/// duration of one pass in ns; the next loop starts one tick after the last frame
+	double ns_per_tick = m_speed > 0? 1e9 / (m_ticks_per_second * m_speed) : 0;
+	double loop_ns = (last_tick - first_tick + 1) * ns_per_tick;
+
+	double lateness_sum = 0;
+	/// the frame with the stamps (WITH_TRACE)
+	std::vector< char > traced;
+	long long start = now_ns();
+	for(int loop = 0; loop < loops && !stats.aborted; loop++){
+		for(size_t i = 0; i < m_frames.size(); i++){
+			const RecordedFrame& frame = m_frames[i];
+			long long deadline = start;
+			if(m_speed > 0){
+				deadline += static_cast< long long >(loop * loop_ns + (frame.tick - first_tick) * ns_per_tick);
+				wait_until(deadline);
+			}
+			long long sent = now_ns();
+			const char* data = frame.data.empty()? 0 : &frame.data[0];
+			size_t size = frame.data.size();
+			if(trace::enabled){
+				/// Sample is the time the frame was due, so the lateness is its first stage
+				trace::TraceStamps stamps;
+				if(m_speed > 0)
+					stamps.set(trace::Sample, deadline);
+				stamps.set(trace::Send, sent);
+				traced.assign(frame.data.begin(), frame.data.end());
+				trace::append(traced, stamps);
+				data = &traced[0];
+				size = traced.size();
+			}
+			if(!callback(data, size)){
+				stats.errors++;
+				if(abort_on_error){
+					stats.aborted = true;
+					break;
+				}
+				continue;
+			}
+
+			stats.frames++;
+			stats.bytes += frame.data.size();
+			if(m_speed > 0){
+				long long late = sent - deadline;
+				if(late < 0)
+					late = 0;
+				lateness_sum += late;
+				if(late > stats.lateness_max_ns)
+					stats.lateness_max_ns = late;
+				stats.histogram[bucket_of(late)]++;
+			}
+		}
+	}
+	long long elapsed = now_ns() - start;
+	stats.elapsed_s = elapsed / 1e9;
+	stats.frames_per_s = elapsed > 0? stats.frames / stats.elapsed_s : 0;
+	stats.lateness_mean_ns = stats.frames? lateness_sum / stats.frames : 0;
+	return stats;
+}
+
+long long ReplayEngine::now_ns()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast< long long >(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+void ReplayEngine::wait_until(long long deadline) const
+{
+	long long sleep_until = deadline - m_spin_ns;
+	if(now_ns() < sleep_until){
+		timespec ts;
+		ts.tv_sec = sleep_until / 1000000000LL;
+		ts.tv_nsec = sleep_until % 1000000000LL;
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0) == EINTR){
+		}
+	}
+	while(now_ns() < deadline){
+	}
+}
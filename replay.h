@@ -0,0 +1,168 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <stddef.h>
+
+#include "struct_controls.h"
+
+namespace replay{
+
+/**
+ * @brief The RecordedFrame struct
+ * encoded frame with the time of its appearance
+ */
+struct RecordedFrame{
+	enum Type{
+		Telemetry = 0,
+		Controls = 1
+	};
+	enum{
+		max_size = 1 << 20		/// limit of data in the recording (max_frame of ingest)
+	};
+
+	RecordedFrame();
+
+	long long tick;
+	int type;
+	std::vector< char > data;
+};
+
+/**
+ * @brief The ReplayStats struct
+ * result of the replay. lateness is the difference between the real and
+ * the scheduled time of the sending (ns)
+ */
+struct ReplayStats{
+	ReplayStats();
+
+	enum{
+		buckets = 40		/// log2 histogram of the lateness
+	};
+
+	long long frames;
+	long long bytes;
+	long long errors;			/// failed writes
+	bool aborted;				/// the run to the descriptor stopped on the failed write
+	double elapsed_s;
+	double frames_per_s;
+	double lateness_mean_ns;
+	long long lateness_max_ns;
+	long long histogram[buckets];
+
+	/**
+	 * @brief lateness_percentile
+	 * upper bound of the bucket with the percentile
+	 * @param p - [0; 1]
+	 * @return ns
+	 */
+	long long lateness_percentile(double p) const;
+};
+
+//////////////////////////////////////////////////
+/// \brief The ReplayEngine class
+/// re-emits the recorded frames paced by their ticks.
+/// time of the frame = start + (tick - first tick) / ticks_per_second / speed,
+/// so the schedule does not drift. the engine sleeps until spin_ns before the
+/// deadline and then busy-waits on the monotonic clock
+class ReplayEngine{
+public:
+	/// returns false if the frame is not delivered
+	typedef std::function< bool (const char* data, size_t size) > Callback;
+
+	ReplayEngine();
+
+	/**
+	 * @brief add
+	 * add encoded frame
+	 * @param frame
+	 */
+	void add(const RecordedFrame& frame);
+	/**
+	 * @brief add
+	 * encode and add telemetry; the tick is from the gyroscope
+	 * @param telemetry
+	 */
+	void add(const sc::StructTelemetry& telemetry);
+	/**
+	 * @brief add
+	 * encode and add controls
+	 * @param controls
+	 * @param tick
+	 */
+	void add(const sc::StructControls& controls, long long tick);
+	void clear();
+	size_t count() const;
+	const std::vector< RecordedFrame >& frames() const;
+
+	/**
+	 * @brief load
+	 * read the recording: frames of [tick int64][type int32][size uint32][data], big endian.
+	 * the frames replace the current ones; on the error no frames are left
+	 * @param path
+	 * @return false on the error of the file or the frame greater than RecordedFrame::max_size
+	 */
+	bool load(const std::string& path);
+	bool save(const std::string& path) const;
+
+	/**
+	 * @brief set_speed
+	 * 1 - real time, 1000 - thousand times faster, 0 - as fast as possible
+	 * @param speed
+	 */
+	void set_speed(double speed);
+	void set_ticks_per_second(double ticks_per_second);
+	/**
+	 * @brief set_spin
+	 * time before the deadline spent in the busy wait
+	 * @param spin_ns
+	 */
+	void set_spin(long long spin_ns);
+	/**
+	 * @brief set_framing
+	 * prefix every frame by its size (uint32 big endian, as QDataStream writes QByteArray)
+	 * @param framing
+	 */
+	void set_framing(bool framing);
+
+	/**
+	 * @brief run
+	 * replay to the file descriptor (socket, pipe). the closed peer does not raise
+	 * SIGPIPE; the first failed write stops the run (the stream is broken), see ReplayStats::aborted
+	 * @param fd
+	 * @param loops - repeat the recording
+	 * @return
+	 */
+	ReplayStats run(int fd, int loops = 1);
+	/**
+	 * @brief run
+	 * replay to the callback in the same process; the frames not delivered are counted as errors
+	 * @param callback
+	 * @param loops
+	 * @return
+	 */
+	ReplayStats run(const Callback& callback, int loops = 1);
+
+	/**
+	 * @brief now_ns
+	 * monotonic clock
+	 * @return
+	 */
+	static long long now_ns();
+
+private:
+	std::vector< RecordedFrame > m_frames;
+	double m_speed;
+	double m_ticks_per_second;
+	long long m_spin_ns;
+	bool m_framing;
+
+	void wait_until(long long deadline) const;
+	ReplayStats run(const Callback& callback, int loops, bool abort_on_error);
+};
+
+}
+
+#endif // REPLAY_H
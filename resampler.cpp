@@ -0,0 +1,331 @@
+#include <algorithm>
+
+#include "resampler.h"
+
+using namespace resampler;
+
+namespace {
+
+inline GyroValue gyro_value(const sc::StructGyroscope& gyroscope)
+{
+	GyroValue res;
+	res.gyro = gyroscope.gyro;
+	res.accel = gyroscope.accel;
+	res.temp = gyroscope.temp;
+	return res;
+}
+
+inline vector3_::Vector3d compass_value(const sc::StructCompass& compass)
+{
+	return vector3_::Vector3d(compass.data);
+}
+
+inline quaternions::Quaternion attitude_value(const AttitudeSample& attitude)
+{
+	return attitude.attitude;
+}
+
+inline BaroValue baro_value(const sc::StructBarometer& barometer)
+{
+	BaroValue res;
+	res.data = barometer.data;
+	res.temp = barometer.temp;
+	return res;
+}
+
+/**
+ * @brief ceil_grid
+ * first tick of the grid not less than tick
+ */
+inline long long ceil_grid(long long tick, long long period)
+{
+	long long k = tick / period;
+	if(k * period < tick)
+		k++;
+	return k * period;
+}
+
+/**
+ * @brief array_at
+ * interpolation over the sorted array; cursor moves forward only
+ */
+template< typename S, typename V >
+inline V array_at(const S* src, size_t count, size_t& cursor, long long tick, V (*value)(const S&))
+{
+	while(cursor + 1 < count && src[cursor + 1].tick <= tick)
+		cursor++;
+	if(cursor + 1 >= count || tick <= src[cursor].tick)
+		return value(src[cursor]);
+	double t = static_cast< double >(tick - src[cursor].tick) / (src[cursor + 1].tick - src[cursor].tick);
+	return lerp(value(src[cursor]), value(src[cursor + 1]), t);
+}
+
+}
+
+////////////////////////////////////////////////
+
+AlignedSample::AlignedSample()
+{
+	tick = 0;
+	gyro_temp = 0;
+	pressure = 0;
+	baro_temp = 0;
+}
+
+////////////////////////////////////////////////
+
+SensorResampler::SensorResampler(long long period, int streams, size_t window)
+	: m_gyroscope(window)
+	, m_compass(window)
+	, m_barometer(window)
+	, m_attitude(window)
+{
+	m_streams = streams;
+	m_max_lag = 0;
+	set_period(period);
+	reset();
+}
+
+void SensorResampler::set_period(long long period)
+{
+	m_period = period > 0? period : 1;
+}
+
+long long SensorResampler::period() const
+{
+	return m_period;
+}
+
+void SensorResampler::set_max_lag(long long max_lag)
+{
+	m_max_lag = max_lag;
+}
+
+void SensorResampler::reset()
+{
+	m_gyroscope.clear();
+	m_compass.clear();
+	m_barometer.clear();
+	m_attitude.clear();
+	m_next_tick = 0;
+	m_newest_tick = 0;
+	m_skipped = 0;
+	m_started = false;
+}
+
+size_t SensorResampler::dropped() const
+{
+	return m_gyroscope.dropped() + m_compass.dropped() + m_barometer.dropped() + m_attitude.dropped();
+}
+
+long long SensorResampler::skipped() const
+{
+	return m_skipped;
+}
+
+void SensorResampler::push(const sc::StructGyroscope &gyroscope)
+{
+	if(!(m_streams & GyroscopeStream))
+		return;
+	m_gyroscope.push(gyroscope.tick, gyro_value(gyroscope));
+	update_newest(gyroscope.tick);
+}
+
+void SensorResampler::push(const sc::StructCompass &compass)
+{
+	if(!(m_streams & CompassStream))
+		return;
+	m_compass.push(compass.tick, compass_value(compass));
+	update_newest(compass.tick);
+}
+
+void SensorResampler::push(const sc::StructBarometer &barometer)
+{
+	if(!(m_streams & BarometerStream))
+		return;
+	m_barometer.push(barometer.tick, baro_value(barometer));
+	update_newest(barometer.tick);
+}
+
+void SensorResampler::push_attitude(long long tick, const quaternions::Quaternion &attitude)
+{
+	if(!(m_streams & AttitudeStream))
+		return;
+	m_attitude.push(tick, attitude);
+	update_newest(tick);
+}
+
+bool SensorResampler::next(AlignedSample &out)
+{
+	if(!m_started){
+		long long first = 0;
+		bool has = false;
+		if(m_streams & GyroscopeStream){
+			if(m_gyroscope.empty()) return false;
+			first = m_gyroscope.first_tick();
+			has = true;
+		}
+		if(m_streams & CompassStream){
+			if(m_compass.empty()) return false;
+			first = has? std::max(first, m_compass.first_tick()) : m_compass.first_tick();
+			has = true;
+		}
+		if(m_streams & BarometerStream){
+			if(m_barometer.empty()) return false;
+			first = has? std::max(first, m_barometer.first_tick()) : m_barometer.first_tick();
+			has = true;
+		}
+		if(m_streams & AttitudeStream){
+			if(m_attitude.empty()) return false;
+			first = has? std::max(first, m_attitude.first_tick()) : m_attitude.first_tick();
+			has = true;
+		}
+		if(!has)
+			return false;
+		m_next_tick = ceil_grid(first, m_period);
+		m_started = true;
+	}
+
+	/// the samples of the tick are dropped from a full window: go to the first covered tick
+	long long start = m_next_tick;
+	start = window_start(m_gyroscope, GyroscopeStream, start);
+	start = window_start(m_compass, CompassStream, start);
+	start = window_start(m_barometer, BarometerStream, start);
+	start = window_start(m_attitude, AttitudeStream, start);
+	if(start > m_next_tick){
+		m_skipped += (start - m_next_tick) / m_period;
+		m_next_tick = start;
+	}
+
+	long long tick = m_next_tick;
+	if(!ready(m_gyroscope, GyroscopeStream, tick) || !ready(m_compass, CompassStream, tick) ||
+			!ready(m_barometer, BarometerStream, tick) || !ready(m_attitude, AttitudeStream, tick))
+		return false;
+
+	GyroValue g = GyroValue();
+	vector3_::Vector3d compass;
+	BaroValue b = BaroValue();
+	quaternions::Quaternion attitude;
+	if(((m_streams & GyroscopeStream) && !m_gyroscope.at(tick, g)) ||
+			((m_streams & CompassStream) && !m_compass.at(tick, compass)) ||
+			((m_streams & BarometerStream) && !m_barometer.at(tick, b)) ||
+			((m_streams & AttitudeStream) && !m_attitude.at(tick, attitude)))
+		return false;
+
+	out.tick = tick;
+	if(m_streams & GyroscopeStream){
+		out.gyro = g.gyro;
+		out.accel = g.accel;
+		out.gyro_temp = g.temp;
+	}
+	if(m_streams & CompassStream)
+		out.compass = compass;
+	if(m_streams & BarometerStream){
+		out.pressure = b.data;
+		out.baro_temp = b.temp;
+	}
+	if(m_streams & AttitudeStream)
+		out.attitude = attitude;
+
+	m_next_tick += m_period;
+	return true;
+}
+
+size_t SensorResampler::resample(const sc::StructGyroscope *gyroscope, size_t count_gyroscope,
+								 const sc::StructCompass *compass, size_t count_compass,
+								 const sc::StructBarometer *barometer, size_t count_barometer,
+								 long long period, std::vector<AlignedSample> &out)
+{
+	return resample(gyroscope, count_gyroscope, compass, count_compass, barometer, count_barometer,
+					0, 0, period, out);
+}
+
+size_t SensorResampler::resample(const sc::StructGyroscope *gyroscope, size_t count_gyroscope,
+								 const sc::StructCompass *compass, size_t count_compass,
+								 const sc::StructBarometer *barometer, size_t count_barometer,
+								 const AttitudeSample *attitude, size_t count_attitude,
+								 long long period, std::vector<AlignedSample> &out)
+{
+	if(period <= 0 || (!count_gyroscope && !count_compass && !count_barometer && !count_attitude))
+		return 0;
+
+	bool has = false;
+	long long first = 0, last = 0;
+	if(count_gyroscope){
+		first = gyroscope[0].tick;
+		last = gyroscope[count_gyroscope - 1].tick;
+		has = true;
+	}
+	if(count_compass){
+		first = has? std::max(first, compass[0].tick) : compass[0].tick;
+		last = has? std::min(last, compass[count_compass - 1].tick) : compass[count_compass - 1].tick;
+		has = true;
+	}
+	if(count_barometer){
+		first = has? std::max(first, barometer[0].tick) : barometer[0].tick;
+		last = has? std::min(last, barometer[count_barometer - 1].tick) : barometer[count_barometer - 1].tick;
+		has = true;
+	}
+	if(count_attitude){
+		first = has? std::max(first, attitude[0].tick) : attitude[0].tick;
+		last = has? std::min(last, attitude[count_attitude - 1].tick) : attitude[count_attitude - 1].tick;
+	}
+
+	long long start = ceil_grid(first, period);
+	if(start > last)
+		return 0;
+
+	size_t count = static_cast< size_t >((last - start) / period) + 1;
+	size_t offset = out.size();
+	out.resize(offset + count);
+
+	size_t cg = 0, cc = 0, cb = 0, ca = 0;
+	for(size_t i = 0; i < count; i++){
+		AlignedSample& s = out[offset + i];
+		long long tick = start + static_cast< long long >(i) * period;
+		s.tick = tick;
+		if(count_gyroscope){
+			GyroValue g = array_at(gyroscope, count_gyroscope, cg, tick, gyro_value);
+			s.gyro = g.gyro;
+			s.accel = g.accel;
+			s.gyro_temp = g.temp;
+		}
+		if(count_compass)
+			s.compass = array_at(compass, count_compass, cc, tick, compass_value);
+		if(count_barometer){
+			BaroValue b = array_at(barometer, count_barometer, cb, tick, baro_value);
+			s.pressure = b.data;
+			s.baro_temp = b.temp;
+		}
+		if(count_attitude)
+			s.attitude = array_at(attitude, count_attitude, ca, tick, attitude_value);
+	}
+	return count;
+}
+
+void SensorResampler::update_newest(long long tick)
+{
+	if(tick > m_newest_tick)
+		m_newest_tick = tick;
+}
+
+template< typename V >
+long long SensorResampler::window_start(const Track_<V> &track, int stream, long long tick) const
+{
+	if(!(m_streams & stream) || track.empty() || track.covers(tick))
+		return tick;
+	return std::max(tick, ceil_grid(track.first_tick(), m_period));
+}
+
+template< typename V >
+bool SensorResampler::ready(const Track_<V> &track, int stream, long long tick) const
+{
+	if(!(m_streams & stream))
+		return true;
+	if(track.empty())
+		return false;
+	if(track.last_tick() >= tick)
+		return true;
+	/// the stream is silent too long: repeat its last value
+	return m_max_lag > 0 && m_newest_tick - track.last_tick() > m_max_lag && m_newest_tick >= tick;
+}
@@ -0,0 +1,318 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <vector>
+#include <stddef.h>
+
+#include "common_.h"
+#include "vector3_.h"
+#include "quaternions.h"
+#include "struct_controls.h"
+
+namespace resampler{
+
+/**
+ * @brief The GyroValue struct
+ * interpolated part of StructGyroscope
+ */
+struct GyroValue{
+	vector3_::Vector3d gyro;
+	vector3_::Vector3d accel;
+	double temp;
+};
+
+/**
+ * @brief The BaroValue struct
+ * interpolated part of StructBarometer
+ */
+struct BaroValue{
+	double data;
+	double temp;
+};
+
+/**
+ * @brief The AlignedSample struct
+ * values of all sensors at the one tick (raw units of the sensors)
+ */
+struct AlignedSample{
+	AlignedSample();
+
+	long long tick;
+	vector3_::Vector3d gyro;
+	vector3_::Vector3d accel;
+	double gyro_temp;
+	vector3_::Vector3d compass;
+	double pressure;
+	double baro_temp;
+	quaternions::Quaternion attitude;
+};
+
+/**
+ * @brief The AttitudeSample struct
+ * attitude at the tick for the batch resample
+ */
+struct AttitudeSample{
+	long long tick;
+	quaternions::Quaternion attitude;
+};
+
+/// linear interpolation for the values, slerp for the attitude
+inline double lerp(double a, double b, double t){
+	return a + (b - a) * t;
+}
+inline vector3_::Vector3d lerp(const vector3_::Vector3d& a, const vector3_::Vector3d& b, double t){
+	return a + (b - a) * t;
+}
+inline GyroValue lerp(const GyroValue& a, const GyroValue& b, double t){
+	GyroValue res;
+	res.gyro = lerp(a.gyro, b.gyro, t);
+	res.accel = lerp(a.accel, b.accel, t);
+	res.temp = lerp(a.temp, b.temp, t);
+	return res;
+}
+inline BaroValue lerp(const BaroValue& a, const BaroValue& b, double t){
+	BaroValue res;
+	res.data = lerp(a.data, b.data, t);
+	res.temp = lerp(a.temp, b.temp, t);
+	return res;
+}
+inline quaternions::Quaternion lerp(const quaternions::Quaternion& a, const quaternions::Quaternion& b, double t){
+	return quaternions::Quaternion::slerp(a, b, t);
+}
+
+//////////////////////////////////////////////////
+/// \brief The Track_ class
+/// ring buffer of the samples of one sensor with fixed capacity (look-behind window).
+/// at() moves forward only, so every sample is popped once - O(1) amortized per query.
+/// when the window overflows the oldest samples are dropped and counted; the ticks
+/// before the window are not covered any more
+template< typename V >
+class Track_{
+public:
+	Track_(size_t capacity = 64){
+		set_capacity(capacity);
+	}
+	void set_capacity(size_t capacity){
+		if(capacity < 2)
+			capacity = 2;
+		m_ticks.resize(capacity);
+		m_values.resize(capacity);
+		clear();
+	}
+	void clear(){
+		m_head = 0;
+		m_count = 0;
+		m_dropped = 0;
+	}
+	inline bool empty() const{
+		return m_count == 0;
+	}
+	inline size_t size() const{
+		return m_count;
+	}
+	inline long long first_tick() const{
+		return m_ticks[m_head];
+	}
+	inline long long last_tick() const{
+		return m_ticks[index(m_count - 1)];
+	}
+	/**
+	 * @brief dropped
+	 * @return count of the samples dropped by the overflow of the window since clear()
+	 */
+	inline size_t dropped() const{
+		return m_dropped;
+	}
+	/**
+	 * @brief covers
+	 * the samples around the tick are in the window: false for the ticks before
+	 * the window after the overflow. before the first sample of the track the tick
+	 * is covered by the first value
+	 * @param tick
+	 * @return
+	 */
+	inline bool covers(long long tick) const{
+		return m_count && !(m_dropped && tick < first_tick());
+	}
+	/**
+	 * @brief push
+	 * add sample. samples with the tick not greater than the last one are ignored.
+	 * when the window is full the oldest sample is dropped and counted
+	 * @param tick
+	 * @param value
+	 */
+	void push(long long tick, const V& value){
+		if(m_count && tick <= last_tick())
+			return;
+		if(m_count == m_ticks.size()){
+			m_head = index(1);
+			m_count--;
+			m_dropped++;
+		}
+		size_t i = index(m_count);
+		m_ticks[i] = tick;
+		m_values[i] = value;
+		m_count++;
+	}
+	/**
+	 * @brief at
+	 * value at the tick; ticks of the queries must not decrease
+	 * @param tick
+	 * @param value
+	 * @return false if the tick is not covered (empty track or the samples are dropped), value is not changed
+	 */
+	bool at(long long tick, V& value){
+		if(!covers(tick))
+			return false;
+		while(m_count >= 2 && m_ticks[index(1)] <= tick){
+			m_head = index(1);
+			m_count--;
+		}
+		if(m_count == 1 || tick <= m_ticks[m_head]){
+			value = m_values[m_head];
+			return true;
+		}
+		size_t i1 = index(1);
+		double t = static_cast< double >(tick - m_ticks[m_head]) / (m_ticks[i1] - m_ticks[m_head]);
+		value = lerp(m_values[m_head], m_values[i1], t);
+		return true;
+	}
+
+private:
+	std::vector< long long > m_ticks;
+	std::vector< V > m_values;
+	size_t m_head;
+	size_t m_count;
+	size_t m_dropped;
+
+	inline size_t index(size_t offset) const{
+		size_t i = m_head + offset;
+		return i >= m_ticks.size()? i - m_ticks.size() : i;
+	}
+};
+
+//////////////////////////////////////////////////
+/// \brief The SensorResampler class
+/// aligns the streams of the sensors to the common grid of ticks:
+/// tick = k * period. the sample is ready when every enabled stream
+/// has data at or after the tick (or lags more than max_lag).
+/// the window of every stream must hold the samples that come while the slowest
+/// stream is waited for (1 kHz gyroscope and 10 Hz barometer: more than 100).
+/// after the overflow the grid ticks before the windows are skipped and counted,
+/// the output is never made from the dropped samples
+class SensorResampler{
+public:
+	enum Stream{
+		GyroscopeStream		= 1,
+		CompassStream		= 2,
+		BarometerStream		= 4,
+		AttitudeStream		= 8,
+		SensorStreams		= GyroscopeStream | CompassStream | BarometerStream
+	};
+
+	/**
+	 * @brief SensorResampler
+	 * @param period - step of the output grid in ticks
+	 * @param streams - mask of Stream
+	 * @param window - capacity of the buffer of every stream
+	 */
+	SensorResampler(long long period, int streams = SensorStreams, size_t window = 64);
+
+	void set_period(long long period);
+	long long period() const;
+	/**
+	 * @brief set_max_lag
+	 * a stream which is behind the newest sample more than max_lag ticks
+	 * does not hold the output: its last value is repeated. 0 - always wait
+	 * @param max_lag
+	 */
+	void set_max_lag(long long max_lag);
+	void reset();
+	/**
+	 * @brief dropped
+	 * @return count of the samples dropped by the overflow of the windows since reset()
+	 */
+	size_t dropped() const;
+	/**
+	 * @brief skipped
+	 * @return count of the grid ticks not produced because their samples were dropped
+	 */
+	long long skipped() const;
+
+	void push(const sc::StructGyroscope& gyroscope);
+	void push(const sc::StructCompass& compass);
+	void push(const sc::StructBarometer& barometer);
+	void push_attitude(long long tick, const quaternions::Quaternion& attitude);
+
+	/**
+	 * @brief next
+	 * get next aligned sample if it is ready
+	 * @param out
+	 * @return false if not enough data
+	 */
+	bool next(AlignedSample& out);
+
+	/**
+	 * @brief resample
+	 * batch mode for the recorded logs: the arrays are sorted by tick,
+	 * empty array means the stream is absent. samples are produced
+	 * from the first tick where all streams have data to the last one
+	 * @param gyroscope
+	 * @param count_gyroscope
+	 * @param compass
+	 * @param count_compass
+	 * @param barometer
+	 * @param count_barometer
+	 * @param period
+	 * @param out - samples are appended
+	 * @return count of the produced samples
+	 */
+	static size_t resample(const sc::StructGyroscope* gyroscope, size_t count_gyroscope,
+						   const sc::StructCompass* compass, size_t count_compass,
+						   const sc::StructBarometer* barometer, size_t count_barometer,
+						   long long period, std::vector< AlignedSample >& out);
+	/**
+	 * @brief resample
+	 * batch mode with the attitude stream (slerp between the samples), as AttitudeStream of next()
+	 * @param gyroscope
+	 * @param count_gyroscope
+	 * @param compass
+	 * @param count_compass
+	 * @param barometer
+	 * @param count_barometer
+	 * @param attitude
+	 * @param count_attitude
+	 * @param period
+	 * @param out - samples are appended
+	 * @return count of the produced samples
+	 */
+	static size_t resample(const sc::StructGyroscope* gyroscope, size_t count_gyroscope,
+						   const sc::StructCompass* compass, size_t count_compass,
+						   const sc::StructBarometer* barometer, size_t count_barometer,
+						   const AttitudeSample* attitude, size_t count_attitude,
+						   long long period, std::vector< AlignedSample >& out);
+
+private:
+	long long m_period;
+	long long m_max_lag;
+	long long m_next_tick;
+	long long m_newest_tick;
+	long long m_skipped;
+	int m_streams;
+	bool m_started;
+
+	Track_< GyroValue > m_gyroscope;
+	Track_< vector3_::Vector3d > m_compass;
+	Track_< BaroValue > m_barometer;
+	Track_< quaternions::Quaternion > m_attitude;
+
+	void update_newest(long long tick);
+	template< typename V >
+	long long window_start(const Track_< V >& track, int stream, long long tick) const;
+	template< typename V >
+	bool ready(const Track_< V >& track, int stream, long long tick) const;
+};
+
+}
+
+#endif // RESAMPLER_H
@@ -0,0 +1,223 @@
+#include "servo_scheduler.h"
+
+using namespace servo;
+
+ServoState::ServoState()
+{
+	pin = 0;
+	rest_angle = 0;
+	value0 = 0;
+	slope = 0;
+	t0 = 0;
+	angle = 0;
+	high = 0;
+	half_period = 0;
+	pwm_freq = 0;
+	generation = 0;
+	active = false;
+}
+
+////////////////////////////////////////////////
+
+ServoScheduler::ServoScheduler(size_t reserve_pins)
+{
+	m_now = 0;
+	m_states.reserve(reserve_pins);
+	std::vector< ServoEvent > storage;
+	storage.reserve(reserve_pins * 2);
+	m_events = std::priority_queue< ServoEvent, std::vector< ServoEvent >, std::greater< ServoEvent > >(
+				std::greater< ServoEvent >(), std::move(storage));
+}
+
+int ServoScheduler::add_pin(int pin, float rest_angle)
+{
+	int slot = get_slot(pin);
+	ServoState& s = m_states[slot];
+	s.rest_angle = rest_angle;
+	if(!s.active)
+		set_value(s, rest_angle, m_now);
+	return slot;
+}
+
+bool ServoScheduler::update(const sc::StructServo &servo, long long now_us)
+{
+	int slot = get_slot(servo.pin);
+	bool trigger = servo.trigger_start(m_states[slot].last);
+	m_states[slot].last = servo;
+	if(!trigger)
+		return false;
+	return start(servo, now_us);
+}
+
+bool ServoScheduler::start(const sc::StructServo &servo, long long now_us)
+{
+	/// the meander reschedules itself until WorkEnd
+	if(servo.freq_meandr > 0 && !(servo.timework_ms > 0))
+		return false;
+
+	advance(now_us);
+
+	int slot = get_slot(servo.pin);
+	ServoState& s = m_states[slot];
+	float current = target(slot);
+
+	s.generation++;
+	s.active = true;
+	s.angle = servo.angle;
+	s.half_period = 0;
+
+	if(servo.freq_meandr > 0){
+		s.half_period = static_cast< long long >(500000.0 / servo.freq_meandr);
+		if(s.half_period < 1)
+			s.half_period = 1;
+		s.high = servo.angle;
+		set_value(s, servo.angle, m_now);
+		schedule(slot, m_now + s.half_period, ServoEvent::MeanderEdge);
+	}else if(servo.speed_of_change > 0 && current != servo.angle){
+		float delta = servo.angle - current;
+		float slope = static_cast< float >(servo.speed_of_change / 1e6);
+		long long duration = static_cast< long long >((delta < 0? -delta : delta) / slope);
+		set_value(s, current, m_now);
+		s.slope = delta < 0? -slope : slope;
+		schedule(slot, m_now + duration, ServoEvent::RampEnd);
+	}else{
+		set_value(s, servo.angle, m_now);
+	}
+
+	if(servo.timework_ms > 0)
+		schedule(slot, m_now + static_cast< long long >(servo.timework_ms * 1000.0), ServoEvent::WorkEnd);
+	return true;
+}
+
+void ServoScheduler::start(const sc::StructAngleCtrl &ctrl, long long now_us)
+{
+	advance(now_us);
+
+	int slot = get_slot(ctrl.pin);
+	ServoState& s = m_states[slot];
+	s.generation++;
+	s.active = true;
+	s.angle = ctrl.angle;
+	s.half_period = 0;
+	s.pwm_freq = ctrl.freq;
+	set_value(s, ctrl.angle, m_now);
+	if(ctrl.timework_ms > 0)
+		schedule(slot, m_now + ctrl.timework_ms * 1000LL, ServoEvent::WorkEnd);
+}
+
+void ServoScheduler::advance(long long now_us)
+{
+	while(!m_events.empty() && m_events.top().deadline <= now_us){
+		ServoEvent ev = m_events.top();
+		m_events.pop();
+		m_now = ev.deadline;
+		process(ev);
+	}
+	if(now_us > m_now)
+		m_now = now_us;
+}
+
+long long ServoScheduler::now() const
+{
+	return m_now;
+}
+
+size_t ServoScheduler::count() const
+{
+	return m_states.size();
+}
+
+int ServoScheduler::slot(int pin) const
+{
+	std::unordered_map< int, int >::const_iterator it = m_slots.find(pin);
+	return it == m_slots.end()? -1 : it->second;
+}
+
+int ServoScheduler::pin(int slot) const
+{
+	return m_states[slot].pin;
+}
+
+bool ServoScheduler::active(int slot) const
+{
+	return m_states[slot].active;
+}
+
+float ServoScheduler::pwm_freq(int slot) const
+{
+	return m_states[slot].pwm_freq;
+}
+
+void ServoScheduler::targets(float *out) const
+{
+	for(size_t i = 0; i < m_states.size(); i++)
+		out[i] = target(static_cast< int >(i));
+}
+
+size_t ServoScheduler::pending() const
+{
+	return m_events.size();
+}
+
+int ServoScheduler::get_slot(int pin)
+{
+	std::unordered_map< int, int >::iterator it = m_slots.find(pin);
+	if(it != m_slots.end())
+		return it->second;
+	int slot = static_cast< int >(m_states.size());
+	m_states.push_back(ServoState());
+	m_states.back().pin = pin;
+	m_states.back().t0 = m_now;
+	m_slots[pin] = slot;
+	return slot;
+}
+
+void ServoScheduler::schedule(int slot, long long deadline, int type)
+{
+	ServoEvent ev;
+	ev.deadline = deadline;
+	ev.slot = slot;
+	ev.generation = m_states[slot].generation;
+	ev.type = type;
+	m_events.push(ev);
+}
+
+void ServoScheduler::set_value(ServoState &s, float value, long long t)
+{
+	s.value0 = value;
+	s.slope = 0;
+	s.t0 = t;
+}
+
+void ServoScheduler::process(const ServoEvent &ev)
+{
+	ServoState& s = m_states[ev.slot];
+	/// the edge of the previous move
+	if(ev.generation != s.generation)
+		return;
+
+	switch (ev.type) {
+		case ServoEvent::RampEnd:
+			set_value(s, s.angle, ev.deadline);
+			break;
+		case ServoEvent::MeanderEdge:
+			if(!s.active)
+				break;
+			s.high = s.high == s.angle? s.rest_angle : s.angle;
+			set_value(s, s.high, ev.deadline);
+			schedule(ev.slot, ev.deadline + s.half_period, ServoEvent::MeanderEdge);
+			break;
+		case ServoEvent::WorkEnd:
+		default:
+			s.active = false;
+			if(s.half_period){
+				set_value(s, s.rest_angle, ev.deadline);
+			}else{
+				float value = s.value0 + s.slope * (ev.deadline - s.t0);
+				set_value(s, value, ev.deadline);
+			}
+			/// drop pending edges of this move
+			s.generation++;
+			break;
+	}
+}
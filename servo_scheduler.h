@@ -0,0 +1,156 @@
+#ifndef SERVO_SCHEDULER_H
+#define SERVO_SCHEDULER_H
+
+#include <vector>
+#include <queue>
+#include <functional>
+#include <utility>
+#include <unordered_map>
+#include <stddef.h>
+
+#include "struct_controls.h"
+
+namespace servo{
+
+/**
+ * @brief The ServoEvent struct
+ * pending edge of the timeline of one pin
+ */
+struct ServoEvent{
+	enum Type{
+		RampEnd,			/// ramp reached the target angle
+		MeanderEdge,		/// meander switches the level
+		WorkEnd				/// timework_ms is over
+	};
+
+	long long deadline;
+	int slot;
+	unsigned int generation;
+	int type;
+
+	bool operator> (const ServoEvent& other) const{
+		return deadline > other.deadline;
+	}
+};
+
+/**
+ * @brief The ServoState struct
+ * current segment of the output: value = value0 + slope * (now - t0)
+ */
+struct ServoState{
+	ServoState();
+
+	int pin;
+	float rest_angle;		/// level of the meander opposite to angle and the value at start
+	float value0;
+	float slope;			/// degrees per microsecond
+	long long t0;
+
+	float angle;			/// target angle of the move
+	float high;				/// current level of the meander
+	long long half_period;	/// of the meander in microseconds, 0 - no meander
+	float pwm_freq;			/// freq from StructAngleCtrl
+	unsigned int generation;
+	bool active;
+
+	sc::StructServo last;
+};
+
+//////////////////////////////////////////////////
+/// \brief The ServoScheduler class
+/// turns StructServo/StructAngleCtrl into timed output for many pins.
+/// the move is converted to the timeline when it starts:
+/// - speed_of_change > 0: ramp from the current angle to angle with speed_of_change deg/s,
+///   otherwise the angle is set at once
+/// - freq_meandr > 0: the output switches between angle and rest angle with this frequency
+/// - after timework_ms the pin becomes inactive and holds the last value
+///   (meander returns to the rest angle). a meander without timework_ms
+///   would never end, so such moves are rejected.
+/// edges are kept in the heap ordered by deadline, the target of every pin
+/// is available in O(1) after advance(). time is in microseconds
+class ServoScheduler{
+public:
+	ServoScheduler(size_t reserve_pins = 64);
+
+	/**
+	 * @brief add_pin
+	 * register pin (pins are also added on the first command)
+	 * @param pin
+	 * @param rest_angle
+	 * @return slot of the pin
+	 */
+	int add_pin(int pin, float rest_angle = 0);
+	/**
+	 * @brief update
+	 * pass every received StructServo; the move starts on trigger_start
+	 * @param servo
+	 * @param now_us
+	 * @return true if the move is started
+	 */
+	bool update(const sc::StructServo& servo, long long now_us);
+	/**
+	 * @brief start
+	 * start the move without the check of trigger_start
+	 * @param servo
+	 * @param now_us
+	 * @return false if the move is rejected (meander with timework_ms <= 0)
+	 */
+	bool start(const sc::StructServo& servo, long long now_us);
+	/**
+	 * @brief start
+	 * set the angle for timework_ms
+	 * @param ctrl
+	 * @param now_us
+	 */
+	void start(const sc::StructAngleCtrl& ctrl, long long now_us);
+	/**
+	 * @brief advance
+	 * process all edges up to now_us
+	 * @param now_us
+	 */
+	void advance(long long now_us);
+
+	long long now() const;
+	size_t count() const;
+	int slot(int pin) const;
+	int pin(int slot) const;
+	bool active(int slot) const;
+	float pwm_freq(int slot) const;
+	/**
+	 * @brief target
+	 * angle of the slot at the time of the last advance()
+	 * @param slot
+	 * @return
+	 */
+	inline float target(int slot) const{
+		const ServoState& s = m_states[slot];
+		return s.value0 + s.slope * (m_now - s.t0);
+	}
+	/**
+	 * @brief targets
+	 * angles of all slots
+	 * @param out - array of count() values
+	 */
+	void targets(float* out) const;
+	/**
+	 * @brief pending
+	 * count of the edges in the heap (including outdated ones)
+	 * @return
+	 */
+	size_t pending() const;
+
+private:
+	std::vector< ServoState > m_states;
+	std::unordered_map< int, int > m_slots;
+	std::priority_queue< ServoEvent, std::vector< ServoEvent >, std::greater< ServoEvent > > m_events;
+	long long m_now;
+
+	int get_slot(int pin);
+	void schedule(int slot, long long deadline, int type);
+	void set_value(ServoState& s, float value, long long t);
+	void process(const ServoEvent& ev);
+};
+
+}
+
+#endif // SERVO_SCHEDULER_H
@@ -0,0 +1,460 @@
+#include "shm_ring.h"
+
+#include <new>
+#include <algorithm>
+#include <type_traits>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+using namespace shm;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+			  "atomics in the shared memory must be lock free");
+static_assert(std::is_trivially_copyable< sc::StructTelemetry >::value &&
+			  std::is_trivially_copyable< sc::StructControls >::value,
+			  "the structs are copied to the ring as is");
+
+namespace shm{
+
+struct RingHeader{
+	std::atomic< unsigned > magic;				/// written the last by create()
+	unsigned version;
+	unsigned long long capacity;
+	unsigned long long slot_size;
+	unsigned long long stride;
+
+	alignas(64) std::atomic< unsigned long long > head;
+	alignas(64) std::atomic< unsigned > futex;	/// low bits of head
+	std::atomic< unsigned > waiters;
+};
+
+/// the slot is followed by the frame in the atomic words: the readers race
+/// with the writer coming round the ring without the undefined behaviour
+/// and drop the copy if seq has changed
+struct RingSlot{
+	std::atomic< unsigned long long > seq;		/// 2 * index + 1 - writing, 2 * index + 2 - written
+	std::atomic< int > type;
+	std::atomic< unsigned > size;
+};
+
+static_assert(sizeof(RingSlot) == 16 && sizeof(std::atomic< unsigned long long >) == 8,
+			  "the frame follows the slot in 8 byte words");
+
+}
+
+namespace {
+
+const unsigned magic = 0x53484d52;		/// "SHMR"
+const unsigned version = 1;
+const size_t line = 64;
+const int spin_count = 256;
+
+inline size_t round_up(size_t value, size_t align)
+{
+	return (value + align - 1) / align * align;
+}
+
+inline size_t words_of(size_t size)
+{
+	return (size + 7) / 8;
+}
+
+inline std::atomic< unsigned long long >* slot_data(RingSlot* slot)
+{
+	return reinterpret_cast< std::atomic< unsigned long long >* >(reinterpret_cast< char* >(slot) + sizeof(RingSlot));
+}
+
+inline void store_words(std::atomic< unsigned long long >* words, const char* data, size_t size)
+{
+	size_t full = size / 8;
+	unsigned long long word;
+	for(size_t i = 0; i < full; i++){
+		memcpy(&word, data + 8 * i, 8);
+		words[i].store(word, std::memory_order_relaxed);
+	}
+	if(size % 8){
+		word = 0;
+		memcpy(&word, data + 8 * full, size % 8);
+		words[full].store(word, std::memory_order_relaxed);
+	}
+}
+
+inline void load_words(const std::atomic< unsigned long long >* words, char* out, size_t size)
+{
+	size_t full = size / 8;
+	unsigned long long word;
+	for(size_t i = 0; i < full; i++){
+		word = words[i].load(std::memory_order_relaxed);
+		memcpy(out + 8 * i, &word, 8);
+	}
+	if(size % 8){
+		word = words[full].load(std::memory_order_relaxed);
+		memcpy(out + 8 * full, &word, size % 8);
+	}
+}
+
+inline void cpu_relax()
+{
+#ifdef __SSE__
+	_mm_pause();
+#endif
+}
+
+inline long futex(std::atomic< unsigned >* word, int op, unsigned value, const timespec* timeout)
+{
+	/// not FUTEX_PRIVATE_FLAG: the word is shared between the processes
+	return syscall(SYS_futex, reinterpret_cast< unsigned* >(word), op, value, timeout, 0, 0);
+}
+
+long long monotonic_ns()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+}
+
+////////////////////////////////////////////////
+
+ShmRing::ShmRing()
+{
+	m_header = 0;
+	m_slots = 0;
+	m_mapped = 0;
+	m_stride = 0;
+	m_mask = 0;
+	m_writer = false;
+}
+
+ShmRing::~ShmRing()
+{
+	close();
+}
+
+bool ShmRing::create(const std::string &name, size_t capacity, size_t slot_size)
+{
+	close();
+	size_t cap = 1;
+	while(cap < capacity)
+		cap <<= 1;
+	slot_size = std::max(slot_size, std::max(sizeof(sc::StructTelemetry), sizeof(sc::StructControls)));
+	size_t stride = round_up(sizeof(RingSlot) + round_up(slot_size, 8), line);
+	size_t size = round_up(sizeof(RingHeader), line) + cap * stride;
+
+	/// the readers of the previous segment keep it until they close
+	shm_unlink(name.c_str());
+	int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+	if(fd < 0)
+		return false;
+	if(ftruncate(fd, static_cast< off_t >(size)) != 0){
+		::close(fd);
+		shm_unlink(name.c_str());
+		return false;
+	}
+	void* mem = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(mem == MAP_FAILED){
+		shm_unlink(name.c_str());
+		return false;
+	}
+
+	/// the pages are zero after ftruncate: every seq is 0 (never written)
+	RingHeader* h = new (mem) RingHeader;
+	h->version = version;
+	h->capacity = cap;
+	h->slot_size = slot_size;
+	h->stride = stride;
+	h->head.store(0, std::memory_order_relaxed);
+	h->futex.store(0, std::memory_order_relaxed);
+	h->waiters.store(0, std::memory_order_relaxed);
+	h->magic.store(magic, std::memory_order_release);
+
+	m_header = h;
+	m_slots = static_cast< char* >(mem) + round_up(sizeof(RingHeader), line);
+	m_mapped = size;
+	m_stride = stride;
+	m_mask = cap - 1;
+	m_writer = true;
+	m_frame.assign(words_of(slot_size), 0);
+	return true;
+}
+
+bool ShmRing::open(const std::string &name)
+{
+	close();
+	int fd = shm_open(name.c_str(), O_RDWR, 0);
+	if(fd < 0)
+		return false;
+	struct stat st;
+	if(fstat(fd, &st) != 0 || static_cast< size_t >(st.st_size) < sizeof(RingHeader)){
+		::close(fd);
+		return false;
+	}
+	size_t size = static_cast< size_t >(st.st_size);
+	/// the readers write only the futex and the count of the waiters
+	void* mem = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(mem == MAP_FAILED)
+		return false;
+
+	RingHeader* h = static_cast< RingHeader* >(mem);
+	size_t header = round_up(sizeof(RingHeader), line);
+	if(h->magic.load(std::memory_order_acquire) != magic || h->version != version
+			|| !h->capacity || (h->capacity & (h->capacity - 1))
+			|| h->stride < sizeof(RingSlot) + round_up(static_cast< size_t >(h->slot_size), 8)
+			|| header + h->capacity * h->stride > size){
+		munmap(mem, size);
+		return false;
+	}
+	m_header = h;
+	m_slots = static_cast< char* >(mem) + header;
+	m_mapped = size;
+	m_stride = static_cast< size_t >(h->stride);
+	m_mask = static_cast< size_t >(h->capacity - 1);
+	m_writer = false;
+	return true;
+}
+
+void ShmRing::close()
+{
+	if(m_header)
+		munmap(m_header, m_mapped);
+	m_header = 0;
+	m_slots = 0;
+	m_mapped = 0;
+	m_writer = false;
+}
+
+bool ShmRing::remove(const std::string &name)
+{
+	return shm_unlink(name.c_str()) == 0;
+}
+
+bool ShmRing::is_open() const
+{
+	return m_header != 0;
+}
+
+size_t ShmRing::capacity() const
+{
+	return m_header? m_mask + 1 : 0;
+}
+
+size_t ShmRing::slot_size() const
+{
+	return m_header? static_cast< size_t >(m_header->slot_size) : 0;
+}
+
+unsigned long long ShmRing::head() const
+{
+	return m_header? m_header->head.load(std::memory_order_acquire) : 0;
+}
+
+char *ShmRing::reserve(size_t size)
+{
+	if(!m_writer || size > m_header->slot_size)
+		return 0;
+	return reinterpret_cast< char* >(&m_frame[0]);
+}
+
+void ShmRing::commit(int type, size_t size)
+{
+	if(!m_writer)
+		return;
+	publish(type, reinterpret_cast< const char* >(&m_frame[0]), std::min< size_t >(size, m_header->slot_size));
+}
+
+bool ShmRing::write(int type, const char *data, size_t size)
+{
+	if(!m_writer || size > m_header->slot_size)
+		return false;
+	publish(type, data, size);
+	return true;
+}
+
+bool ShmRing::write(const sc::StructTelemetry &telemetry)
+{
+	return write(Telemetry, reinterpret_cast< const char* >(&telemetry), sizeof(telemetry));
+}
+
+bool ShmRing::write(const sc::StructControls &controls)
+{
+	return write(Controls, reinterpret_cast< const char* >(&controls), sizeof(controls));
+}
+
+void ShmRing::publish(int type, const char *data, size_t size)
+{
+	unsigned long long index = m_header->head.load(std::memory_order_relaxed);
+	RingSlot* s = slot(index);
+	/// the readers of the old frame in the slot see the odd seq and skip it
+	s->seq.store(2 * index + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	s->type.store(type, std::memory_order_relaxed);
+	s->size.store(static_cast< unsigned >(size), std::memory_order_relaxed);
+	store_words(slot_data(s), data, size);
+	s->seq.store(2 * index + 2, std::memory_order_release);
+	m_header->head.store(index + 1, std::memory_order_release);
+
+	m_header->futex.store(static_cast< unsigned >(index + 1), std::memory_order_seq_cst);
+	if(m_header->waiters.load(std::memory_order_seq_cst))
+		futex(&m_header->futex, FUTEX_WAKE, INT_MAX, 0);
+}
+
+RingSlot *ShmRing::slot(unsigned long long index) const
+{
+	return reinterpret_cast< RingSlot* >(m_slots + (static_cast< size_t >(index) & m_mask) * m_stride);
+}
+
+////////////////////////////////////////////////
+
+ShmCursor::ShmCursor(const ShmRing &ring, bool from_start)
+{
+	m_ring = &ring;
+	m_lost = 0;
+	m_position = ring.head();
+	if(from_start)
+		m_position = m_position > ring.capacity()? m_position - ring.capacity() : 0;
+}
+
+int ShmCursor::peek()
+{
+	int type = NoFrame;
+	return read_slot(NoFrame, 0, 0, &type, 0)? type : NoFrame;
+}
+
+bool ShmCursor::read(sc::StructTelemetry &telemetry)
+{
+	return read_slot(Telemetry, &telemetry, sizeof(telemetry), 0, 0);
+}
+
+bool ShmCursor::read(sc::StructControls &controls)
+{
+	return read_slot(Controls, &controls, sizeof(controls), 0, 0);
+}
+
+bool ShmCursor::read(int &type, std::vector<char> &data)
+{
+	return read_slot(NoFrame, 0, 0, &type, &data);
+}
+
+bool ShmCursor::skip()
+{
+	if(peek() == NoFrame)
+		return false;
+	m_position++;
+	return true;
+}
+
+bool ShmCursor::wait(int timeout_ms)
+{
+	RingHeader* h = m_ring->m_header;
+	if(!h)
+		return false;
+	/// with one core the writer can not run while the reader spins
+	static const int spins = sysconf(_SC_NPROCESSORS_ONLN) > 1? spin_count : 0;
+	for(int i = 0; i < spins; i++){
+		if(h->head.load(std::memory_order_acquire) > m_position)
+			return true;
+		cpu_relax();
+	}
+
+	long long deadline = timeout_ms >= 0? monotonic_ns() + timeout_ms * 1000000LL : 0;
+	bool res = false;
+	h->waiters.fetch_add(1, std::memory_order_seq_cst);
+	for(;;){
+		unsigned word = h->futex.load(std::memory_order_seq_cst);
+		if(h->head.load(std::memory_order_seq_cst) > m_position){
+			res = true;
+			break;
+		}
+		timespec ts, *timeout = 0;
+		if(timeout_ms >= 0){
+			long long left = deadline - monotonic_ns();
+			if(left <= 0)
+				break;
+			ts.tv_sec = left / 1000000000LL;
+			ts.tv_nsec = left % 1000000000LL;
+			timeout = &ts;
+		}
+		futex(&h->futex, FUTEX_WAIT, word, timeout);
+	}
+	h->waiters.fetch_sub(1, std::memory_order_seq_cst);
+	return res;
+}
+
+void ShmCursor::seek_latest()
+{
+	m_position = m_ring->head();
+}
+
+unsigned long long ShmCursor::lost() const
+{
+	return m_lost;
+}
+
+unsigned long long ShmCursor::position() const
+{
+	return m_position;
+}
+
+bool ShmCursor::read_slot(int type, void *out, size_t size, int *read_type, std::vector<char> *data)
+{
+	const RingHeader* h = m_ring->m_header;
+	if(!h)
+		return false;
+	unsigned long long capacity = m_ring->m_mask + 1;
+	for(;;){
+		unsigned long long head = h->head.load(std::memory_order_acquire);
+		if(m_position >= head)
+			return false;
+		if(head - m_position > capacity){
+			m_lost += head - capacity - m_position;
+			m_position = head - capacity;
+		}
+		RingSlot* s = m_ring->slot(m_position);
+		unsigned long long seq = s->seq.load(std::memory_order_acquire);
+		if(seq != 2 * m_position + 2){
+			/// the writer has come round the ring to this slot
+			m_lost++;
+			m_position++;
+			continue;
+		}
+		int t = s->type.load(std::memory_order_relaxed);
+		size_t n = std::min< size_t >(s->size.load(std::memory_order_relaxed), h->slot_size);
+		/// the frame of other type stays for the next read
+		bool consume = out? t == type && n == size : data != 0;
+		if(out && consume){
+			load_words(slot_data(s), static_cast< char* >(out), size);
+		}else if(consume){
+			data->resize(n);
+			if(n)
+				load_words(slot_data(s), &(*data)[0], n);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(s->seq.load(std::memory_order_relaxed) != seq){
+			/// overwritten while copied
+			m_lost++;
+			m_position++;
+			continue;
+		}
+		if(read_type)
+			*read_type = t;
+		if(!consume)
+			return !out;
+		m_position++;
+		return true;
+	}
+}
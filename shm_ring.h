@@ -0,0 +1,170 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <stddef.h>
+
+#include "struct_controls.h"
+
+namespace shm{
+
+/**
+ * @brief The Type enum
+ * types of the frames in the ring
+ */
+enum Type{
+	Telemetry = 0,			/// StructTelemetry copied as is
+	Controls = 1,			/// StructControls copied as is
+	Data = 2,				/// any bytes, e.g. wire::encode
+	NoFrame = -1
+};
+
+struct RingHeader;
+struct RingSlot;
+
+//////////////////////////////////////////////////
+/// \brief The ShmRing class
+/// ring of the fixed size slots in the posix shared memory (linux) for one
+/// writer and any count of the readers in other processes. the writer never
+/// waits for the readers: the oldest frames are overwritten and a slow reader
+/// sees them as lost. every slot is guarded by its sequence number, the
+/// readers sleep on the futex only when the ring is empty.
+/// the structs are copied without serialization, so the processes must be
+/// built for the same architecture and with the same struct_controls.h
+class ShmRing{
+public:
+	ShmRing();
+	~ShmRing();
+
+	/**
+	 * @brief create
+	 * create (or recreate) the segment; the process becomes the writer
+	 * @param name - name of the segment, e.g. "/telemetry"
+	 * @param capacity - count of the slots, rounded up to the power of 2
+	 * @param slot_size - max size of the frame, not less than the structs
+	 * @return
+	 */
+	bool create(const std::string& name, size_t capacity = 1024, size_t slot_size = 0);
+	/**
+	 * @brief open
+	 * attach to the segment made by create()
+	 * @param name
+	 * @return false if the segment does not exist or is not ready
+	 */
+	bool open(const std::string& name);
+	void close();
+	/**
+	 * @brief remove
+	 * unlink the segment; the attached processes keep the mapping
+	 * @param name
+	 * @return
+	 */
+	static bool remove(const std::string& name);
+
+	bool is_open() const;
+	size_t capacity() const;
+	size_t slot_size() const;
+	/**
+	 * @brief head
+	 * @return count of the frames written to the ring
+	 */
+	unsigned long long head() const;
+
+	/**
+	 * @brief reserve
+	 * the place for the frame: the frame is built in the buffer of the writer
+	 * and copied to the next slot by commit()
+	 * @param size
+	 * @return 0 if size is greater than slot_size
+	 */
+	char* reserve(size_t size);
+	void commit(int type, size_t size);
+
+	bool write(int type, const char* data, size_t size);
+	bool write(const sc::StructTelemetry& telemetry);
+	bool write(const sc::StructControls& controls);
+
+private:
+	RingHeader* m_header;
+	char* m_slots;
+	size_t m_mapped;
+	size_t m_stride;
+	size_t m_mask;
+	bool m_writer;
+	std::vector< unsigned long long > m_frame;	/// reserve(), aligned as the words of the slot
+
+	RingSlot* slot(unsigned long long index) const;
+	void publish(int type, const char* data, size_t size);
+
+	friend class ShmCursor;
+};
+
+//////////////////////////////////////////////////
+/// \brief The ShmCursor class
+/// position of one reader in the ring. the cursors are independent,
+/// a process may have any count of them
+class ShmCursor{
+public:
+	/**
+	 * @brief ShmCursor
+	 * @param ring - must stay open while the cursor is used
+	 * @param from_start - read the frames still kept in the ring, otherwise only new ones
+	 */
+	ShmCursor(const ShmRing& ring, bool from_start = false);
+
+	/**
+	 * @brief peek
+	 * @return type of the next frame or NoFrame
+	 */
+	int peek();
+	/**
+	 * @brief read
+	 * the next frame if it has this type
+	 * @param telemetry - may be changed on false if the writer overtook the cursor
+	 * @return false if the ring is empty or the frame has other type
+	 */
+	bool read(sc::StructTelemetry& telemetry);
+	bool read(sc::StructControls& controls);
+	/**
+	 * @brief read
+	 * the next frame of any type
+	 * @param type
+	 * @param data
+	 * @return false if the ring is empty
+	 */
+	bool read(int& type, std::vector< char >& data);
+	bool skip();
+
+	/**
+	 * @brief wait
+	 * sleep until the next frame is written
+	 * @param timeout_ms - -1: infinite
+	 * @return false on the timeout
+	 */
+	bool wait(int timeout_ms = -1);
+
+	/**
+	 * @brief seek_latest
+	 * skip all written frames
+	 */
+	void seek_latest();
+	/**
+	 * @brief lost
+	 * @return count of the frames overwritten before they were read
+	 */
+	unsigned long long lost() const;
+	unsigned long long position() const;
+
+private:
+	const ShmRing* m_ring;
+	unsigned long long m_position;
+	unsigned long long m_lost;
+
+	bool read_slot(int type, void* out, size_t size, int* read_type, std::vector< char >* data);
+};
+
+}
+
+#endif // SHM_RING_H
@@ -0,0 +1,212 @@
+#ifndef SLERP_BATCH_H
+#define SLERP_BATCH_H
+
+#include <stddef.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "common_.h"
+#include "quaternions.h"
+
+namespace quaternions {
+
+//////////////////////////////////////////////////
+/// \brief The SlerpBatch class
+/// interpolator for one pair of quaternions evaluated at many t.
+/// dot, theta and 1/sin(theta) are computed once in set(),
+/// the results are equal to Quaternion::slerp for the same arguments
+class SlerpBatch{
+public:
+	enum Mode{
+		Exact,				/// same as Quaternion::slerp
+		FastNlerp			/// nlerp with corrected t, no trigonometry per sample
+	};
+	/// every reseed_interval samples evaluate_uniform recomputes sin/cos exactly
+	enum{
+		reseed_interval = 32
+	};
+
+	SlerpBatch(){
+		set(Quaternion(), Quaternion());
+	}
+	SlerpBatch(const Quaternion& p0, const Quaternion& p1){
+		set(p0, p1);
+	}
+	/**
+	 * @brief set
+	 * set the pair and precompute the values used by every evaluation
+	 * @param p0
+	 * @param p1
+	 */
+	void set(const Quaternion& p0, const Quaternion& p1){
+		m_p0 = p0;
+		m_p1 = p1;
+		m_dot = Quaternion::dot(p0, p1);
+		m_theta = 0;
+		m_inv_sin = 0;
+		m_trig = false;
+		if((1 - m_dot) > 0.0000001){
+			double theta = acos(m_dot);
+			double sinTheta = sin(theta);
+			if(sinTheta > 0.0000001){
+				m_theta = theta;
+				m_inv_sin = 1.0 / sinTheta;
+				m_trig = true;
+			}
+		}
+		/// coefficients of the t correction for nlerp (fit of the slerp angular velocity)
+		double d = m_dot < 0 ? 0 : (m_dot > 1 ? 1 : m_dot);
+		m_ka = 1.0904 + d * (-3.2452 + d * (3.55645 - d * 1.43519));
+		m_kb = 0.848013 + d * (-1.06021 + d * 0.215638);
+	}
+	const Quaternion& first() const{
+		return m_p0;
+	}
+	const Quaternion& second() const{
+		return m_p1;
+	}
+
+	/**
+	 * @brief operator ()
+	 * slerp at t
+	 * @param t
+	 * @return
+	 */
+	inline Quaternion operator()(double t) const{
+		if(t <= 0)
+			return m_p0;
+		if(t >= 1)
+			return m_p1;
+		if(common_::fIsNull(m_dot))
+			return m_p0;
+		if(m_trig)
+			return combine(sin((1 - t) * m_theta) * m_inv_sin, sin(t * m_theta) * m_inv_sin);
+		return combine(1 - t, t);
+	}
+	/**
+	 * @brief nlerp
+	 * fast approximation of slerp: nlerp with the corrected parameter.
+	 * the maximum error is about 1e-3 rad for pairs in one hemisphere (dot >= 0)
+	 * @param t
+	 * @return
+	 */
+	inline Quaternion nlerp(double t) const{
+		if(t <= 0)
+			return m_p0;
+		if(t >= 1)
+			return m_p1;
+		if(common_::fIsNull(m_dot))
+			return m_p0;
+		double c = t - 0.5;
+		double k = m_ka * c * c + m_kb;
+		double ot = t + t * c * (t - 1) * k;
+		return combine(1 - ot, ot);
+	}
+
+	/**
+	 * @brief evaluate
+	 * interpolation for the array of parameters
+	 * @param t
+	 * @param out
+	 * @param count
+	 * @param mode
+	 */
+	void evaluate(const double* t, Quaternion* out, size_t count, Mode mode = Exact) const{
+		if(mode == FastNlerp){
+			for(size_t i = 0; i < count; i++)
+				out[i] = nlerp(t[i]);
+		}else{
+			for(size_t i = 0; i < count; i++)
+				out[i] = operator()(t[i]);
+		}
+	}
+	/**
+	 * @brief evaluate_uniform
+	 * interpolation for t = t0 + i * step, i = [0, count).
+	 * sin((1 - t) * theta) and sin(t * theta) are advanced by the rotation recurrence
+	 * so there are no trigonometric calls per sample
+	 * @param t0
+	 * @param step
+	 * @param out
+	 * @param count
+	 */
+	void evaluate_uniform(double t0, double step, Quaternion* out, size_t count) const{
+		if(!m_trig || common_::fIsNull(m_dot)){
+			for(size_t i = 0; i < count; i++)
+				out[i] = operator()(t0 + i * step);
+			return;
+		}
+		double delta = step * m_theta;
+		double cd = cos(delta), sd = sin(delta);
+		double s1 = 0, c1 = 0, s2 = 0, c2 = 0;
+		for(size_t i = 0; i < count; i++){
+			double t = t0 + i * step;
+			if(i % reseed_interval == 0){
+				double a1 = (1 - t) * m_theta, a2 = t * m_theta;
+				s1 = sin(a1); c1 = cos(a1);
+				s2 = sin(a2); c2 = cos(a2);
+			}
+			if(t <= 0)
+				out[i] = m_p0;
+			else if(t >= 1)
+				out[i] = m_p1;
+			else
+				out[i] = combine(s1 * m_inv_sin, s2 * m_inv_sin);
+
+			/// (1 - t) * theta decreases by delta, t * theta increases by delta
+			double ns1 = s1 * cd - c1 * sd;
+			c1 = c1 * cd + s1 * sd;
+			s1 = ns1;
+			double ns2 = s2 * cd + c2 * sd;
+			c2 = c2 * cd - s2 * sd;
+			s2 = ns2;
+		}
+	}
+
+private:
+	Quaternion m_p0;
+	Quaternion m_p1;
+	double m_dot;
+	double m_theta;
+	double m_inv_sin;
+	double m_ka;
+	double m_kb;
+	bool m_trig;
+
+	/**
+	 * @brief combine
+	 * (p0 * f1 + p1 * f2).normalized()
+	 * @param f1
+	 * @param f2
+	 * @return
+	 */
+	inline Quaternion combine(double f1, double f2) const{
+		Quaternion res;
+#ifdef __SSE2__
+		__m128d a1 = _mm_mul_pd(_mm_loadu_pd(&m_p0.v.data[0]), _mm_set1_pd(f1));
+		__m128d a2 = _mm_mul_pd(_mm_set_pd(m_p0.w, m_p0.v.data[2]), _mm_set1_pd(f1));
+		a1 = _mm_add_pd(a1, _mm_mul_pd(_mm_loadu_pd(&m_p1.v.data[0]), _mm_set1_pd(f2)));
+		a2 = _mm_add_pd(a2, _mm_mul_pd(_mm_set_pd(m_p1.w, m_p1.v.data[2]), _mm_set1_pd(f2)));
+		__m128d sq = _mm_add_pd(_mm_mul_pd(a1, a1), _mm_mul_pd(a2, a2));
+		double len = _mm_cvtsd_f64(_mm_add_sd(sq, _mm_unpackhi_pd(sq, sq)));
+		if(!(common_::fIsNull(len) || common_::fIsNull(len - 1.0))){
+			__m128d inv = _mm_set1_pd(1.0 / sqrt(len));
+			a1 = _mm_mul_pd(a1, inv);
+			a2 = _mm_mul_pd(a2, inv);
+		}
+		_mm_storeu_pd(&res.v.data[0], a1);
+		_mm_store_sd(&res.v.data[2], a2);
+		res.w = _mm_cvtsd_f64(_mm_unpackhi_pd(a2, a2));
+#else
+		res = m_p0 * f1 + m_p1 * f2;
+		res.normalize();
+#endif
+		return res;
+	}
+};
+
+}
+
+#endif // SLERP_BATCH_H
@@ -0,0 +1,86 @@
+#include "slim_telemetry.h"
+
+#include <string.h>
+
+using namespace slim;
+
+namespace {
+
+inline short to_short(int value, unsigned char& flags)
+{
+	if(value > 32767){
+		flags |= HotTelemetry::Saturated;
+		return 32767;
+	}
+	if(value < -32768){
+		flags |= HotTelemetry::Saturated;
+		return -32768;
+	}
+	return static_cast< short >(value);
+}
+
+}
+
+////////////////////////////////////////////////
+
+void slim::to_slim(const sc::StructTelemetry &telemetry, HotTelemetry &hot, ColdTelemetry *cold)
+{
+	const sc::StructGyroscope& g = telemetry.gyroscope;
+	hot.tick = g.tick;
+	hot.tangaj = telemetry.tangaj;
+	hot.bank = telemetry.bank;
+	hot.course = telemetry.course;
+	hot.height = telemetry.height;
+	FOREACH(i, sc::cnt_engines, hot.power[i] = telemetry.power[i]);
+	hot.flags = 0;
+	FOREACH(i, 3, hot.gyro[i] = to_short(g.gyro.data[i], hot.flags));
+	FOREACH(i, 3, hot.accel[i] = to_short(g.accel.data[i], hot.flags));
+	hot.power_on = telemetry.power_on;
+	hot.afs_sel = g.afs_sel;
+	hot.fs_sel = g.fs_sel;
+	hot.freq = g.freq;
+	hot.temp = g.temp;
+
+	if(!cold)
+		return;
+	cold->compass_tick = telemetry.compass.tick;
+	cold->barometer_tick = telemetry.barometer.tick;
+	FOREACH(i, 3, cold->compass[i] = telemetry.compass.data.data[i]);
+	cold->barometer = telemetry.barometer.data;
+	cold->barometer_temp = telemetry.barometer.temp;
+	cold->compass_mode = telemetry.compass.mode;
+	memcpy(cold->raw, g.raw, sizeof(cold->raw));
+	memset(cold->reserved, 0, sizeof(cold->reserved));
+}
+
+void slim::from_slim(const HotTelemetry &hot, const ColdTelemetry *cold, sc::StructTelemetry &telemetry)
+{
+	sc::StructGyroscope& g = telemetry.gyroscope;
+	g.tick = hot.tick;
+	telemetry.tangaj = hot.tangaj;
+	telemetry.bank = hot.bank;
+	telemetry.course = hot.course;
+	telemetry.height = hot.height;
+	FOREACH(i, sc::cnt_engines, telemetry.power[i] = hot.power[i]);
+	FOREACH(i, 3, g.gyro.data[i] = hot.gyro[i]);
+	FOREACH(i, 3, g.accel.data[i] = hot.accel[i]);
+	telemetry.power_on = hot.power_on != 0;
+	g.afs_sel = hot.afs_sel;
+	g.fs_sel = hot.fs_sel;
+	g.freq = hot.freq;
+	g.temp = hot.temp;
+
+	if(!cold){
+		telemetry.compass = sc::StructCompass();
+		telemetry.barometer = sc::StructBarometer();
+		memset(g.raw, 0, sizeof(g.raw));
+		return;
+	}
+	telemetry.compass.tick = cold->compass_tick;
+	telemetry.barometer.tick = cold->barometer_tick;
+	FOREACH(i, 3, telemetry.compass.data.data[i] = cold->compass[i]);
+	telemetry.barometer.data = cold->barometer;
+	telemetry.barometer.temp = cold->barometer_temp;
+	telemetry.compass.mode = cold->compass_mode;
+	memcpy(g.raw, cold->raw, sizeof(g.raw));
+}
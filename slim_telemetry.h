@@ -0,0 +1,155 @@
+#ifndef SLIM_TELEMETRY_H
+#define SLIM_TELEMETRY_H
+
+#include <vector>
+#include <stddef.h>
+
+#include "struct_controls.h"
+
+namespace slim{
+
+/**
+ * @brief The HotTelemetry struct
+ * fields of StructTelemetry used by the queries, one cache line per sample.
+ * gyro and accel are the 16 bit registers of mpu6050
+ */
+struct HotTelemetry{
+	enum{
+		Saturated = 1		/// gyro or accel did not fit to 16 bit and was clamped
+	};
+
+	long long tick;			/// tick of the gyroscope
+	float tangaj;
+	float bank;
+	float course;
+	float height;
+	float power[sc::cnt_engines];
+	short gyro[3];
+	short accel[3];
+	unsigned char power_on;
+	unsigned char afs_sel;
+	unsigned char fs_sel;
+	unsigned char flags;
+	float freq;
+	float temp;
+};
+
+/**
+ * @brief The ColdTelemetry struct
+ * the rest of StructTelemetry: compass, barometer and the raw dump of mpu6050.
+ * the padding is explicit, so the layout does not depend on the alignment
+ * of long long (4 on i386, 8 on x86_64 and arm)
+ */
+struct ColdTelemetry{
+	long long compass_tick;
+	long long barometer_tick;
+	int compass[3];
+	int barometer;
+	int barometer_temp;
+	unsigned char compass_mode;
+	unsigned char raw[sc::raw_count];
+	unsigned char reserved[(8 - (37 + sc::raw_count) % 8) % 8];		/// zero
+};
+
+static_assert(sc::cnt_engines != 4 || sizeof(HotTelemetry) == 64, "HotTelemetry must fill one cache line");
+static_assert(offsetof(HotTelemetry, gyro) == 8 + 4 * (4 + sc::cnt_engines) &&
+			  offsetof(HotTelemetry, power_on) == offsetof(HotTelemetry, gyro) + 12,
+			  "unexpected padding of HotTelemetry");
+static_assert(offsetof(ColdTelemetry, compass) == 16 && offsetof(ColdTelemetry, compass_mode) == 36 &&
+			  offsetof(ColdTelemetry, raw) == 37 && sizeof(ColdTelemetry) % 8 == 0 &&
+			  sizeof(ColdTelemetry) == offsetof(ColdTelemetry, reserved) + sizeof(ColdTelemetry::reserved),
+			  "unexpected padding of ColdTelemetry");
+static_assert(sizeof(HotTelemetry) < sizeof(sc::StructTelemetry), "HotTelemetry is not smaller");
+
+/**
+ * @brief to_slim
+ * split the telemetry
+ * @param telemetry
+ * @param hot
+ * @param cold - may be null
+ */
+void to_slim(const sc::StructTelemetry& telemetry, HotTelemetry& hot, ColdTelemetry* cold);
+/**
+ * @brief from_slim
+ * restore the telemetry; without cold part the compass, barometer and raw are zero
+ * @param hot
+ * @param cold - may be null
+ * @param telemetry
+ */
+void from_slim(const HotTelemetry& hot, const ColdTelemetry* cold, sc::StructTelemetry& telemetry);
+
+//////////////////////////////////////////////////
+/// \brief The TelemetryHistory_ class
+/// in-memory history of the telemetry. the hot parts are stored contiguously,
+/// the cold parts in the separate array only if keep_cold
+template< bool keep_cold >
+class TelemetryHistory_{
+public:
+	void reserve(size_t count){
+		m_hot.reserve(count);
+		if(keep_cold)
+			m_cold.reserve(count);
+	}
+	void clear(){
+		m_hot.clear();
+		m_cold.clear();
+	}
+	size_t size() const{
+		return m_hot.size();
+	}
+	void push(const sc::StructTelemetry& telemetry){
+		m_hot.push_back(HotTelemetry());
+		if(keep_cold){
+			m_cold.push_back(ColdTelemetry());
+			to_slim(telemetry, m_hot.back(), &m_cold.back());
+		}else{
+			to_slim(telemetry, m_hot.back(), 0);
+		}
+	}
+	void push(const sc::StructTelemetry* telemetry, size_t count){
+		reserve(size() + count);
+		for(size_t i = 0; i < count; i++)
+			push(telemetry[i]);
+	}
+	/**
+	 * @brief get
+	 * the full structure of the sample
+	 * @param index
+	 * @param telemetry
+	 */
+	void get(size_t index, sc::StructTelemetry& telemetry) const{
+		from_slim(m_hot[index], cold(index), telemetry);
+	}
+	const HotTelemetry& hot(size_t index) const{
+		return m_hot[index];
+	}
+	const HotTelemetry* hot_data() const{
+		return m_hot.empty()? 0 : &m_hot[0];
+	}
+	/**
+	 * @brief cold
+	 * @param index
+	 * @return null if the cold parts are not kept
+	 */
+	const ColdTelemetry* cold(size_t index) const{
+		return keep_cold? &m_cold[index] : 0;
+	}
+	/**
+	 * @brief memory
+	 * @return bytes used by the samples
+	 */
+	size_t memory() const{
+		return m_hot.capacity() * sizeof(HotTelemetry) + m_cold.capacity() * sizeof(ColdTelemetry);
+	}
+
+private:
+	std::vector< HotTelemetry > m_hot;
+	std::vector< ColdTelemetry > m_cold;
+};
+
+typedef TelemetryHistory_< false > SlimHistory;
+typedef TelemetryHistory_< true > SplitHistory;
+
+}
+
+#endif // SLIM_TELEMETRY_H
@@ -91,18 +91,6 @@ StructGyroscope::StructGyroscope()
 	FOREACH(i, raw_count, raw[i] = 0);
 }
 
-StructGyroscope::StructGyroscope(const StructGyroscope& st)
-{
-	gyro = st.gyro;
-	accel = st.accel;
-	afs_sel = st.afs_sel;
-	fs_sel = st.fs_sel;
-	freq = st.freq;
-	tick = st.tick;
-	std::copy(st.raw, st.raw + raw_count, raw);
-	temp = st.temp;
-}
-
 void StructGyroscope::write_to(QDataStream& stream)
 {
 	stream << temp;
@@ -220,23 +208,6 @@ StructTelemetry::StructTelemetry()
 	course = tangaj = bank = 0;
 }
 
-/**
- * @brief StructTelemetry
- * @param st
- */
-StructTelemetry::StructTelemetry(const StructTelemetry& st)
-{
-	power_on = st.power_on;
-	FOREACH(i, cnt_engines, power[i] = st.power[i];);
-	tangaj = st.tangaj;
-	bank = st.bank;
-	course = st.course;
-	height = st.height;
-	gyroscope = st.gyroscope;
-	compass = st.compass;
-	barometer = st.barometer;
-}
-
 /**
  * @brief write_to
  * serialize to byte array
@@ -75,7 +75,7 @@ const float default_freq = 100;
 struct StructGyroscope{
 
 	StructGyroscope();
-	StructGyroscope(const StructGyroscope& st);
+	/// copy constructor and assignment are left implicit so the type stays trivially copyable
 
 	void write_to(QDataStream& stream);
 	/**
@@ -139,11 +139,6 @@ struct StructTelemetry
 	 * @brief StructTelemetry
 	 */
 	StructTelemetry();
-	/**
-	 * @brief StructTelemetry
-	 * @param st
-	 */
-	StructTelemetry(const StructTelemetry& st);
 	/**
 	 * @brief write_to
 	 * serialize to byte array
@@ -1,8 +1,44 @@
 INCLUDEPATH += $$PWD
+CONFIG += c++14
+unix: LIBS += -lrt
 
 HEADERS += $$PWD/common_.h \
+			$$PWD/aggregation.h \
+			$$PWD/ahrs.h \
+			$$PWD/compass_heading.h \
+			$$PWD/fleet_simulator.h \
+			$$PWD/gyro_bias.h \
+			$$PWD/height_estimator.h \
+			$$PWD/ingest.h \
+			$$PWD/load_generator.h \
+			$$PWD/mixer.h \
+			$$PWD/precision.h \
 			$$PWD/quaternions.h \
+			$$PWD/replay.h \
+			$$PWD/resampler.h \
+			$$PWD/servo_scheduler.h \
+			$$PWD/shm_ring.h \
+			$$PWD/slerp_batch.h \
+			$$PWD/slim_telemetry.h \
 			$$PWD/struct_controls.h \
-			$$PWD/vector3_.h
+			$$PWD/trace.h \
+			$$PWD/vector3_.h \
+			$$PWD/vibration.h \
+			$$PWD/wire.h \
+			$$PWD/zone_map.h
 SOURCES += $$PWD/struct_controls.cpp \
-    $$PWD/datastream.cpp
+    $$PWD/aggregation.cpp \
+    $$PWD/compass_heading.cpp \
+    $$PWD/datastream.cpp \
+    $$PWD/fleet_simulator.cpp \
+    $$PWD/gyro_bias.cpp \
+    $$PWD/height_estimator.cpp \
+    $$PWD/ingest.cpp \
+    $$PWD/load_generator.cpp \
+    $$PWD/replay.cpp \
+    $$PWD/resampler.cpp \
+    $$PWD/servo_scheduler.cpp \
+    $$PWD/shm_ring.cpp \
+    $$PWD/slim_telemetry.cpp \
+    $$PWD/trace.cpp \
+    $$PWD/zone_map.cpp
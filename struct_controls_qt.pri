@@ -1,7 +1,11 @@
-INCLUDEPATH += $PWD
+INCLUDEPATH += $$PWD
+CONFIG += c++14
 
 HEADERS += \
-    $$PWD/struct_controls.h
+    $$PWD/struct_controls.h \
+    $$PWD/trace.h \
+    $$PWD/wire.h
 
 SOURCES += \
-    $$PWD/struct_controls.cpp
+    $$PWD/struct_controls.cpp \
+    $$PWD/trace.cpp
@@ -0,0 +1,6 @@
+TARGET = test_aggregation
+
+include(../tests.pri)
+
+SOURCES += \
+    test_aggregation.cpp
@@ -0,0 +1,172 @@
+#include <math.h>
+#include <map>
+#include <vector>
+
+#include "aggregation.h"
+#include "test_common.h"
+
+using namespace aggregation;
+
+namespace{
+
+sc::StructTelemetry telemetry(long long tick, int i){
+	sc::StructTelemetry res;
+	res.gyroscope.tick = tick;
+	res.tangaj = static_cast< float >(10 * sin(i * 0.01));
+	res.bank = static_cast< float >(5 * cos(i * 0.013));
+	res.course = static_cast< float >(i % 360);
+	res.height = static_cast< float >(0.01 * i);
+	FOREACH(e, sc::cnt_engines, res.power[e] = static_cast< float >((i * (e + 3)) % 100) / 100);
+	res.gyroscope.gyro = vector3_::Vector3i(i % 17 - 8, (i * 7) % 23 - 11, -(i % 5));
+	res.gyroscope.accel = vector3_::Vector3i(i % 31, 16384 - i % 13, (i * 3) % 29);
+	return res;
+}
+
+/// floor of tick / width
+long long floor_div(long long tick, long long width){
+	return tick >= 0? tick / width : -((-tick + width - 1) / width);
+}
+
+/**
+ * @brief direct
+ * the windows of the level straight from the samples
+ */
+std::vector< Aggregate > direct(const std::vector< sc::StructTelemetry >& data, long long width){
+	std::map< long long, Aggregate > windows;
+	std::map< long long, std::vector< double > > sums;
+	for(const sc::StructTelemetry& t: data){
+		float v[fields];
+		values(t, v);
+		long long start = floor_div(t.gyroscope.tick, width) * width;
+		Aggregate& a = windows[start];
+		std::vector< double >& sum = sums[start];
+		if(!a.count){
+			a.start = start;
+			a.width = width;
+			FOREACH(i, fields, a.min[i] = a.max[i] = v[i]);
+			sum.assign(fields, 0);
+		}
+		a.count++;
+		FOREACH(i, fields, {
+			a.min[i] = fmin(a.min[i], v[i]);
+			a.max[i] = fmax(a.max[i], v[i]);
+			a.last[i] = v[i];
+			sum[i] += v[i];
+		});
+	}
+	std::vector< Aggregate > res;
+	for(auto& w: windows){
+		FOREACH(i, fields, w.second.mean[i] = static_cast< float >(sums[w.first][i] / w.second.count));
+		res.push_back(w.second);
+	}
+	return res;
+}
+
+bool same(const Aggregate& a, const Aggregate& b){
+	if(a.start != b.start || a.width != b.width || a.count != b.count)
+		return false;
+	for(int i = 0; i < fields; i++){
+		if(a.min[i] != b.min[i] || a.max[i] != b.max[i] || a.last[i] != b.last[i] ||
+				fabs(a.mean[i] - b.mean[i]) > 1e-5 * (1 + fabs(b.mean[i])))
+			return false;
+	}
+	return true;
+}
+
+void check_negative_ticks(){
+	Aggregator aggregator(std::vector< long long >(1, 10));
+	std::vector< Aggregate > out;
+	aggregator.set_sink([&out](int, const Aggregate& a){ out.push_back(a); });
+	for(long long tick = -25; tick < 25; tick++)
+		aggregator.push(telemetry(tick, static_cast< int >(tick + 100)));
+	aggregator.flush();
+
+	const long long starts[] = {-30, -20, -10, 0, 10, 20};
+	const long long counts[] = {5, 10, 10, 10, 10, 5};
+	CHECK(out.size() == 6);
+	for(size_t i = 0; i < out.size() && i < 6; i++)
+		CHECK(out[i].start == starts[i] && out[i].count == counts[i] && out[i].width == 10);
+
+	/// the window ends before its next multiple: -21 is in [-30; -20), -20 starts the next
+	CHECK(out.size() > 1 && out[0].last[Course] == telemetry(-21, 79).course);
+	CHECK(out.size() > 1 && out[1].min[Height] == telemetry(-20, 80).height);
+}
+
+void check_pyramid(){
+	/// gaps: some windows of every level have no samples
+	std::vector< sc::StructTelemetry > data;
+	long long tick = -4321;
+	for(int i = 0; i < 30000; i++){
+		data.push_back(telemetry(tick, i));
+		tick += 1 + i % 3;
+		if(i % 997 == 0)
+			tick += 250;
+		if(i % 7919 == 0)
+			tick += 3000;
+	}
+
+	std::vector< long long > widths;
+	widths.push_back(10);
+	widths.push_back(100);
+	widths.push_back(1000);
+	std::vector< std::vector< Aggregate > > pyramid = Aggregator::aggregate(data.data(), data.size(), widths);
+	CHECK(pyramid.size() == 3);
+	for(size_t level = 0; level < pyramid.size(); level++){
+		std::vector< Aggregate > expected = direct(data, widths[level]);
+		CHECK(pyramid[level].size() == expected.size());
+		long long total = 0;
+		for(size_t i = 0; i < pyramid[level].size() && i < expected.size(); i++){
+			CHECK(same(pyramid[level][i], expected[i]));
+			total += pyramid[level][i].count;
+		}
+		CHECK(total == static_cast< long long >(data.size()));
+	}
+
+	/// the widths are rounded up to the multiple of the previous level
+	Aggregator rounded(std::vector< long long >{10, 25, 20});
+	CHECK(rounded.width(0) == 10 && rounded.width(1) == 30 && rounded.width(2) == 30);
+}
+
+void check_flush(){
+	Aggregator aggregator;
+	std::vector< std::pair< int, Aggregate > > out;
+	aggregator.set_sink([&out](int level, const Aggregate& a){ out.push_back(std::make_pair(level, a)); });
+	for(int i = 0; i < 1234; i++)
+		aggregator.push(telemetry(i, i));
+
+	/// the open windows: [1230; 1240), [1200; 1300), [1000; 2000)
+	Aggregate open;
+	CHECK(aggregator.current(0, open) && open.start == 1230 && open.count == 4);
+	CHECK(aggregator.current(1, open) && open.start == 1200 && open.count == 30);
+	CHECK(aggregator.current(2, open) && open.start == 1000 && open.count == 200);
+	size_t closed = out.size();
+	CHECK(closed == 123 + 12 + 1);
+
+	aggregator.flush();
+	CHECK(out.size() == closed + 3);
+	long long level_counts[3] = {0, 0, 0};
+	for(size_t i = 0; i < out.size(); i++)
+		level_counts[out[i].first] += out[i].second.count;
+	CHECK(level_counts[0] == 1234 && level_counts[1] == 1234 && level_counts[2] == 1234);
+	CHECK(out[closed].first == 0 && out[closed].second.start == 1230);
+	CHECK(out[closed + 1].first == 1 && out[closed + 1].second.count == 34);
+	CHECK(out[closed + 2].first == 2 && out[closed + 2].second.count == 234);
+	FOREACH(level, 3, CHECK(!aggregator.current(level, open)));
+
+	/// nothing more to close; the next sample opens the finest window, the coarser
+	/// ones get it when it is closed
+	aggregator.flush();
+	CHECK(out.size() == closed + 3);
+	aggregator.push(telemetry(5000, 0));
+	CHECK(aggregator.current(0, open) && open.start == 5000 && open.count == 1);
+	CHECK(!aggregator.current(2, open));
+}
+
+}
+
+int main(int, char**){
+	check_negative_ticks();
+	check_pyramid();
+	check_flush();
+	return test_common::result("aggregation");
+}
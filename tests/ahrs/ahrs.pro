@@ -0,0 +1,6 @@
+TARGET = test_ahrs
+
+include(../tests.pri)
+
+SOURCES += \
+    test_ahrs.cpp
@@ -0,0 +1,128 @@
+#include <math.h>
+
+#include "ahrs.h"
+#include "test_common.h"
+
+using quaternions::Quaternion;
+using vector3_::Vector3d;
+
+namespace{
+
+const double freq = 1000;
+const int steps = 30000;			/// 30 s at 1 kHz
+const double tolerance = 0.5;		/// degrees
+
+/// the earth field: north along x with the dip 60 degrees down
+const Vector3d gravity(0, 0, 1);
+const Vector3d field(0.5, 0, -0.8660254037844386);
+
+struct Attitude{
+	double tangaj;
+	double bank;
+	double course;
+};
+
+/// vector of the earth frame in the body frame of the attitude q
+Vector3d to_body(const Quaternion& q, const Vector3d& v){
+	Quaternion r = q.conj() * Quaternion(v.x(), v.y(), v.z(), 0) * q;
+	return r.v;
+}
+
+/// difference of the angles in degrees in [-180; 180]
+double angle_diff(double a, double b){
+	double d = fmod(a - b, 360);
+	if(d > 180)
+		d -= 360;
+	if(d < -180)
+		d += 360;
+	return fabs(d);
+}
+
+/**
+ * @brief check_converge
+ * the filter from the identity with the static sensors of the attitude comes to it
+ * @param ahrs - the gains are set by the caller
+ * @param attitude
+ */
+template< typename Ahrs >
+void check_converge(Ahrs ahrs, const Attitude& attitude){
+	typedef typename Ahrs::Vector Vector;
+
+	/// attitude = z(course) * y(tangaj) * x(bank)
+	Quaternion q = Quaternion::fromAxisAndAngle(0, 0, 1, attitude.course)
+			* Quaternion::fromAxisAndAngle(0, 1, 0, attitude.tangaj)
+			* Quaternion::fromAxisAndAngle(1, 0, 0, attitude.bank);
+	/// the sensors in their own units: only the direction is used
+	Vector accel(to_body(q, gravity) * 16384.);
+	Vector mag(to_body(q, field) * 500.);
+	Vector gyro;
+
+	ahrs.set_freq(freq);
+	for(int i = 0; i < steps; i++)
+		ahrs.update(gyro, accel, mag);
+
+	CHECK_LE(angle_diff(ahrs.tangaj(), attitude.tangaj), tolerance);
+	CHECK_LE(angle_diff(ahrs.bank(), attitude.bank), tolerance);
+	CHECK_LE(angle_diff(ahrs.course(), attitude.course), tolerance);
+
+	/// without the compass the course is free, tangaj and bank converge
+	ahrs.reset();
+	for(int i = 0; i < steps; i++)
+		ahrs.update(gyro, accel);
+	CHECK_LE(angle_diff(ahrs.tangaj(), attitude.tangaj), tolerance);
+	CHECK_LE(angle_diff(ahrs.bank(), attitude.bank), tolerance);
+}
+
+template< typename Madgwick, typename Mahony >
+void check_filters(const Attitude& attitude){
+	Madgwick madgwick;
+	madgwick.set_beta(1);
+	check_converge(madgwick, attitude);
+
+	Mahony mahony;
+	mahony.set_gains(5, 0);
+	check_converge(mahony, attitude);
+}
+
+}
+
+int main(int, char**){
+	const Attitude attitudes[] = {
+		{0, 0, 0},
+		{10, -20, 30},
+		{-30, 15, -120},
+		{45, 5, 170},
+		{-5, 60, -90},
+	};
+
+	for(const Attitude& attitude: attitudes){
+		check_filters< ahrs::MadgwickAhrs, ahrs::MahonyAhrs >(attitude);
+		check_filters< ahrs::MadgwickAhrsf, ahrs::MahonyAhrsf >(attitude);
+		check_filters< ahrs::Ahrs_< float, ahrs::Madgwick, precision::Fast >,
+				ahrs::Ahrs_< float, ahrs::Mahony, precision::Fast > >(attitude);
+	}
+
+	/// the integral of Mahony removes the bias of the gyroscope at rest
+	{
+		Quaternion q = Quaternion::fromAxisAndAngle(0, 0, 1, 40) * Quaternion::fromAxisAndAngle(0, 1, 0, -15);
+		ahrs::MahonyAhrs::Vector accel(to_body(q, gravity)), mag(to_body(q, field)), bias(0.02, -0.01, 0.03);
+		ahrs::MahonyAhrs mahony(freq);
+		mahony.set_gains(2, 1);
+		for(int i = 0; i < 2 * steps; i++)
+			mahony.update(bias, accel, mag);
+		CHECK_LE(angle_diff(mahony.tangaj(), -15), tolerance);
+		CHECK_LE(angle_diff(mahony.bank(), 0), tolerance);
+		CHECK_LE(angle_diff(mahony.course(), 40), tolerance);
+	}
+
+	/// the gyroscope alone: one turn around z at 90 deg/s for 1 s
+	ahrs::MadgwickAhrs gyro_only;
+	gyro_only.set_freq(freq);
+	ahrs::MadgwickAhrs::Vector rate(0, 0, common_::angle2rad(90.)), none;
+	for(int i = 0; i < freq; i++)
+		gyro_only.update(rate, none);
+	CHECK_LE(angle_diff(gyro_only.course(), 90), 1e-3);
+	CHECK_LE(fabs(gyro_only.tangaj()) + fabs(gyro_only.bank()), 1e-6);
+
+	return test_common::result("ahrs");
+}
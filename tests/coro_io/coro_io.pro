@@ -0,0 +1,7 @@
+TARGET = test_coro_io
+
+include(../tests.pri)
+include(../../coro_io.pri)
+
+SOURCES += \
+    test_coro_io.cpp
@@ -0,0 +1,173 @@
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "coro_io.h"
+#include "test_common.h"
+
+using namespace coro;
+
+namespace{
+
+const int streams = 64;
+const int frames = 2000;
+
+struct Counters{
+	long long sent;
+	long long received;
+	long long wrong;
+	long long controls;
+};
+
+/// telemetry frames with the control frame after every tenth
+Task writer(Executor& executor, int fd, Counters& counters){
+	FrameStream stream(executor, fd);
+	sc::StructTelemetry telemetry;
+	sc::StructControls controls;
+	for(int i = 0; i < frames; i++){
+		telemetry.gyroscope.tick = i;
+		telemetry.height = static_cast< float >(fd + i);
+		if(!co_await stream.write_frame(telemetry))
+			break;
+		counters.sent++;
+		if(i % 10 == 9){
+			controls.throttle = static_cast< float >(i);
+			if(!co_await stream.write_frame(controls))
+				break;
+		}
+	}
+	executor.forget(fd);
+	shutdown(fd, SHUT_WR);
+}
+
+Task reader(Executor& executor, int fd, int peer, Counters& counters){
+	FrameStream stream(executor, fd);
+	sc::StructTelemetry telemetry;
+	sc::StructControls controls;
+	for(int i = 0; ; i++){
+		if(!co_await stream.read_frame(telemetry))
+			break;
+		counters.received++;
+		if(telemetry.gyroscope.tick != i || telemetry.height != static_cast< float >(peer + i))
+			counters.wrong++;
+		if(i % 10 == 9){
+			if(!co_await stream.read_frame(controls) || controls.throttle != static_cast< float >(i))
+				counters.wrong++;
+			else
+				counters.controls++;
+		}
+	}
+	executor.forget(fd);
+}
+
+/// the overloads with the stamps give the same frames; the stamps are checked with WITH_TRACE
+Task traced_writer(Executor& executor, int fd){
+	FrameStream stream(executor, fd);
+	sc::StructTelemetry telemetry;
+	trace::TraceStamps stamps;
+	for(int i = 0; i < frames; i++){
+		telemetry.gyroscope.tick = i;
+		stamps = trace::TraceStamps();
+		stamps.mark(trace::Sample);
+		if(!co_await stream.write_frame(telemetry, stamps))
+			break;
+	}
+	executor.forget(fd);
+	shutdown(fd, SHUT_WR);
+}
+
+Task traced_reader(Executor& executor, int fd, Counters& counters){
+	FrameStream stream(executor, fd);
+	sc::StructTelemetry telemetry;
+	trace::TraceStamps stamps;
+	for(int i = 0; co_await stream.read_frame(telemetry, stamps); i++){
+		counters.received++;
+		if(telemetry.gyroscope.tick != i)
+			counters.wrong++;
+		const trace::Stage marked[] = {trace::Sample, trace::Encode, trace::Send, trace::Receive, trace::Decode};
+		for(trace::Stage stage: marked){
+			if(trace::enabled && !stamps.has(stage))
+				counters.wrong++;
+		}
+	}
+	executor.forget(fd);
+}
+
+/// the stream must stop on the damaged input
+Task broken_reader(Executor& executor, int fd, bool& result){
+	FrameStream stream(executor, fd);
+	sc::StructTelemetry telemetry;
+	result = co_await stream.read_frame(telemetry);
+	executor.forget(fd);
+}
+
+bool read_broken(const char* data, size_t size){
+	int sv[2];
+	if(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) < 0)
+		return true;
+	bool res = true;
+	if(write(sv[0], data, size) != static_cast< ssize_t >(size))
+		return true;
+	shutdown(sv[0], SHUT_WR);
+	Executor executor;
+	executor.spawn(broken_reader(executor, sv[1], res));
+	executor.run();
+	close(sv[0]);
+	close(sv[1]);
+	return res;
+}
+
+}
+
+int main(int, char**){
+	std::vector< int > a(streams), b(streams);
+	bool opened = true;
+	for(int i = 0; i < streams; i++){
+		int sv[2];
+		opened = opened && socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0;
+		a[i] = sv[0];
+		b[i] = sv[1];
+	}
+	CHECK(opened);
+	if(!opened)
+		return test_common::result("coro_io");
+
+	/// every pair is one writer and one reader coroutine on the single thread
+	Counters counters = {0, 0, 0, 0};
+	Executor executor;
+	for(int i = 0; i < streams; i++){
+		executor.spawn(writer(executor, a[i], counters));
+		executor.spawn(reader(executor, b[i], a[i], counters));
+	}
+	executor.run();
+	CHECK(executor.active() == 0);
+	CHECK(executor.errors() == 0);
+	CHECK(counters.sent == static_cast< long long >(streams) * frames);
+	CHECK(counters.received == counters.sent);
+	CHECK(counters.controls == counters.sent / 10);
+	CHECK(counters.wrong == 0);
+	for(int i = 0; i < streams; i++){
+		close(a[i]);
+		close(b[i]);
+	}
+
+	int sv[2];
+	CHECK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+	Counters traced = {0, 0, 0, 0};
+	Executor traced_executor;
+	traced_executor.spawn(traced_writer(traced_executor, sv[0]));
+	traced_executor.spawn(traced_reader(traced_executor, sv[1], traced));
+	traced_executor.run();
+	CHECK(traced.received == frames);
+	CHECK(traced.wrong == 0);
+	close(sv[0]);
+	close(sv[1]);
+
+	/// the size over the limit, and the end of the stream inside the frame
+	const char too_big[] = {0x7f, 0, 0, 0, 1, 2, 3};
+	const char truncated[] = {0, 0, 0, 100, 1, 2, 3};
+	CHECK(!read_broken(too_big, sizeof(too_big)));
+	CHECK(!read_broken(truncated, sizeof(truncated)));
+
+	return test_common::result("coro_io");
+}
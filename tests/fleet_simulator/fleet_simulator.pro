@@ -0,0 +1,6 @@
+TARGET = test_fleet_simulator
+
+include(../tests.pri)
+
+SOURCES += \
+    test_fleet_simulator.cpp
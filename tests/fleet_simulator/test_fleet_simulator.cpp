@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <vector>
+
+#include "fleet_simulator.h"
+#include "wire.h"
+#include "test_common.h"
+
+using namespace sim;
+
+namespace{
+
+const size_t vehicles = 37;			/// not a multiple of the lanes
+
+sc::StructControls command(size_t vehicle){
+	sc::StructControls res;
+	res.power_on = true;
+	res.throttle = 0.45f + 0.01f * (vehicle % 10);
+	res.tangaj = 0.02f * (static_cast< int >(vehicle % 5) - 2);
+	res.bank = 0.015f * (static_cast< int >(vehicle % 3) - 1);
+	res.yaw = 0.01f * (static_cast< int >(vehicle % 7) - 3);
+	return res;
+}
+
+/**
+ * @brief run
+ * the encoded telemetry of all vehicles after the same steps and commands
+ * @param threads
+ * @return
+ */
+std::vector< char > run(int threads){
+	FleetSimulator fleet(vehicles, 0.001, threads, 7);
+	std::vector< sc::StructControls > controls(vehicles);
+	for(size_t i = 0; i < vehicles; i++){
+		fleet.reset(i, vector3_::Vector3d(static_cast< double >(i), 0, 5));
+		controls[i] = command(i);
+	}
+	fleet.set_controls(&controls[0]);
+	std::vector< char > res, frame;
+	sc::StructTelemetry telemetry;
+	for(int n = 0; n < 40; n++){
+		/// the pool is reused by the calls of different counts
+		fleet.step(n % 3 == 0? 1 : 25);
+		if(n == 20){
+			FOREACH(i, static_cast< int >(vehicles), controls[i].yaw = -controls[i].yaw);
+			fleet.set_controls(&controls[0]);
+		}
+		for(size_t i = 0; i < vehicles; i++){
+			fleet.telemetry(i, telemetry);
+			wire::encode(telemetry, frame);
+			res.insert(res.end(), frame.begin(), frame.end());
+		}
+	}
+	return res;
+}
+
+/**
+ * @brief respond
+ * the telemetry of the vehicle hovering at 10 m after 0.2 s of the command
+ * @param tangaj
+ * @param bank
+ * @param yaw
+ * @return
+ */
+sc::StructTelemetry respond(float tangaj, float bank, float yaw){
+	FleetSimulator fleet(1, 0.001, 1);
+	fleet.reset(0, vector3_::Vector3d(0, 0, 10));
+	sc::StructControls controls;
+	controls.power_on = true;
+	controls.throttle = 0.5f;
+	controls.tangaj = tangaj;
+	controls.bank = bank;
+	controls.yaw = yaw;
+	fleet.set_controls(0, controls);
+	fleet.step(200);
+	sc::StructTelemetry res;
+	fleet.telemetry(0, res);
+	return res;
+}
+
+}
+
+int main(int, char**){
+	/// bit exact for any count of the threads
+	std::vector< char > single = run(1);
+	CHECK(!single.empty());
+	const int threads[] = { 2, 3, 4, 16 };
+	for(int t: threads)
+		CHECK(run(t) == single);
+
+	/// the commands move the attitude of the telemetry in their direction
+	sc::StructTelemetry level = respond(0, 0, 0);
+	CHECK(fabs(level.tangaj) < 0.01f && fabs(level.bank) < 0.01f);
+	CHECK(level.course < 0.01f || level.course > 359.99f);
+
+	sc::StructTelemetry t = respond(0.05f, 0, 0);
+	CHECK(t.tangaj > 1);
+	CHECK(fabs(t.bank) < 0.1f);
+	t = respond(-0.05f, 0, 0);
+	CHECK(t.tangaj < -1);
+
+	t = respond(0, 0.05f, 0);
+	CHECK(t.bank > 1);
+	CHECK(fabs(t.tangaj) < 0.1f);
+	t = respond(0, -0.05f, 0);
+	CHECK(t.bank < -1);
+
+	t = respond(0, 0, 0.05f);
+	CHECK(t.course > 0.2f && t.course < 180);
+	t = respond(0, 0, -0.05f);
+	CHECK(t.course < 359.8f && t.course > 180);
+
+	/// the gyroscope agrees with the sign of the rotation
+	FleetSimulator fleet(1, 0.001, 1);
+	fleet.reset(0, vector3_::Vector3d(0, 0, 10));
+	sc::StructControls controls;
+	controls.power_on = true;
+	controls.throttle = 0.5f;
+	controls.tangaj = 0.05f;
+	fleet.set_controls(0, controls);
+	fleet.step(100);
+	CHECK(fleet.angular_velocity(0).y() > 0);
+	fleet.telemetry(0, t);
+	CHECK(t.gyroscope.gyro[1] > 0);
+
+	return test_common::result("fleet_simulator");
+}
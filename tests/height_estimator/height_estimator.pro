@@ -0,0 +1,6 @@
+TARGET = test_height_estimator
+
+include(../tests.pri)
+
+SOURCES += \
+    test_height_estimator.cpp
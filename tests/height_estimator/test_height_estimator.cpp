@@ -0,0 +1,119 @@
+#include <math.h>
+
+#include "height_estimator.h"
+#include "test_common.h"
+
+using namespace height;
+
+namespace{
+
+const double freq = 1000;				/// Hz of the accelerometer
+const int baro_div = 20;				/// 50 Hz barometer
+const double baro_noise = 0.5;			/// m
+const double accel_noise = 0.3;			/// m/s^2
+const double accel_bias = 0.15;			/// m/s^2
+const double lsb = 16384;				/// per g, afs_sel 0
+
+/// deterministic gaussian noise
+class Noise{
+public:
+	Noise(unsigned long long seed): m_state(seed){}
+	double operator()(){
+		double u1 = uniform(), u2 = uniform();
+		return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+	}
+private:
+	unsigned long long m_state;
+	double uniform(){
+		m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+		return (static_cast< double >(m_state >> 11) + 0.5) / 9007199254740992.0;
+	}
+};
+
+/// vertical acceleration of the climb: hover, accelerate, climb 3 m/s, brake, hover
+double profile_accel(double t){
+	if(t < 5) return 0;
+	if(t < 8) return 1;
+	if(t < 13) return 0;
+	if(t < 16) return -1;
+	return 0;
+}
+
+double pressure(double h){
+	return sea_level_pressure * pow(1 - h / 44330.0, 5.255);
+}
+
+}
+
+int main(int, char**){
+	/// the table against the formula
+	AltitudeTable table;
+	double err = 0;
+	for(int i = 0; i <= 1000; i++){
+		double p = sea_level_pressure * (0.3 + 0.8 * i / 1000);
+		err = fmax(err, fabs(table.altitude(p) - AltitudeTable::altitude_exact(p)));
+	}
+	CHECK_LE(err, 5e-3);
+
+	HeightEstimator estimator(sea_level_pressure);
+	estimator.set_noise(accel_noise, baro_noise, 0.01);
+	Noise noise(3);
+
+	sc::StructGyroscope gyroscope;
+	gyroscope.freq = static_cast< float >(freq);
+	gyroscope.afs_sel = 0;
+	sc::StructBarometer barometer;
+
+	const double dt = 1 / freq;
+	const int steps = static_cast< int >(30 * freq);
+	double h = 0, v = 0;
+	double sum_h = 0, sum_v = 0, sum_baro = 0;
+	int count = 0;
+	for(int i = 0; i < steps; i++){
+		double t = i * dt;
+		double a = profile_accel(t);
+		h += v * dt + 0.5 * a * dt * dt;
+		v += a * dt;
+
+		if(i % baro_div == 0){
+			double measured = h + baro_noise * noise();
+			barometer.tick = i;
+			barometer.data = static_cast< int >(lround(pressure(measured)));
+			estimator.update(barometer);
+			if(t > 3)
+				sum_baro += (measured - h) * (measured - h);
+		}
+		if(estimator.initialized()){
+			double accel = (a + accel_bias + accel_noise * noise()) / gravity + 1;
+			gyroscope.tick = i;
+			gyroscope.accel = vector3_::Vector3i(0, 0, static_cast< int >(lround(accel * lsb)));
+			estimator.update(gyroscope);
+		}
+
+		/// after the convergence
+		if(t > 3){
+			sum_h += (estimator.height() - h) * (estimator.height() - h);
+			sum_v += (estimator.vertical_speed() - v) * (estimator.vertical_speed() - v);
+			count++;
+		}
+	}
+	double rms_h = sqrt(sum_h / count), rms_v = sqrt(sum_v / count);
+	double rms_baro = sqrt(sum_baro / (count / baro_div));
+
+	CHECK_LE(fabs(h - 24), 1e-6);					/// 4.5 + 15 + 4.5 m of the profile
+	CHECK_LE(rms_h, 0.5 * rms_baro);				/// better than the barometer alone
+	CHECK_LE(rms_v, 0.2);
+	CHECK_LE(fabs(estimator.height() - h), 0.5);
+	CHECK_LE(fabs(estimator.accel_bias() - accel_bias), 0.05);
+
+	/// the tilted sensor: the vertical part of the accelerometer
+	sc::StructGyroscope tilted;
+	tilted.afs_sel = 0;
+	quaternions::Quaternion q = HeightEstimator::attitude(30, -20);
+	vector3_::Vector3d body = q.conj().rotatedVector(vector3_::Vector3d(0, 0, lsb * 1.1));
+	tilted.accel = vector3_::Vector3i(static_cast< int >(lround(body.x())), static_cast< int >(lround(body.y())),
+									  static_cast< int >(lround(body.z())));
+	CHECK_LE(fabs(HeightEstimator::vertical_accel(tilted, q) - 0.1 * gravity), 2e-3);
+
+	return test_common::result("height_estimator");
+}
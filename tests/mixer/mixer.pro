@@ -0,0 +1,6 @@
+TARGET = test_mixer
+
+include(../tests.pri)
+
+SOURCES += \
+    test_mixer.cpp
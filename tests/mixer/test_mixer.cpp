@@ -0,0 +1,134 @@
+#include <math.h>
+#include <vector>
+
+#include "mixer.h"
+#include "test_common.h"
+
+using namespace mixer;
+
+namespace{
+
+const float eps = 1e-6f;
+const int commands = 100000;
+
+/// the outputs are in the range of the mixer
+template< typename Mixer >
+bool in_range(const Mixer& mixer, const float* power){
+	for(int i = 0; i < Mixer::count; i++){
+		if(power[i] < mixer.min_power() || power[i] > mixer.max_power())
+			return false;
+	}
+	return true;
+}
+
+/// the part of the outputs made by the command through the column of the matrix
+template< int engines >
+float projection(const float* power, const float* column){
+	float dot = 0, norm = 0;
+	for(int i = 0; i < engines; i++){
+		dot += power[i] * column[i];
+		norm += column[i] * column[i];
+	}
+	return dot / norm;
+}
+
+template< typename Mixer >
+void check_mixer(){
+	typedef typename Mixer::Matrix Matrix;
+	const Matrix& m = Mixer::matrix;
+	enum{ engines = Mixer::count };
+	Mixer mixer;
+	float power[engines];
+
+	/// in the range: the commands are added by the matrix, the mean is the throttle
+	CHECK(!mixer.mix(0.5f, 0.1f, -0.2f, 0.05f, power));
+	float sum = 0;
+	for(int i = 0; i < engines; i++){
+		CHECK_LE(fabs(power[i] - (0.5f + 0.1f * m.tangaj[i] - 0.2f * m.bank[i] + 0.05f * m.yaw[i])), eps);
+		sum += power[i];
+	}
+	CHECK_LE(fabs(sum / engines - 0.5f), eps);
+
+	/// the signs: the engines with the positive factor get more power
+	mixer.mix(0.5f, 0.2f, 0, 0, power);
+	for(int i = 0; i < engines; i++)
+		CHECK(m.tangaj[i] == 0 || (power[i] > 0.5f) == (m.tangaj[i] > 0));
+	mixer.mix(0.5f, 0, 0.2f, 0, power);
+	for(int i = 0; i < engines; i++)
+		CHECK(m.bank[i] == 0 || (power[i] > 0.5f) == (m.bank[i] > 0));
+	mixer.mix(0.5f, 0, 0, 0.2f, power);
+	for(int i = 0; i < engines; i++)
+		CHECK((power[i] > 0.5f) == (m.yaw[i] > 0));
+
+	/// too much yaw: the yaw is reduced first, roll and pitch are kept
+	CHECK(mixer.mix(0.5f, 0, 0.4f, 1, power));
+	CHECK(in_range(mixer, power));
+	CHECK_LE(fabs(projection< engines >(power, m.bank) - 0.4f), 1e-5);
+	float yaw = projection< engines >(power, m.yaw);
+	CHECK(yaw > 0 && yaw < 1);
+
+	/// too much roll: it is scaled to the range, the yaw is removed
+	CHECK(mixer.mix(0.5f, 0, 3, 0.5f, power));
+	CHECK(in_range(mixer, power));
+	CHECK_LE(fabs(projection< engines >(power, m.yaw)), 1e-5);
+	float lo = power[0], hi = power[0];
+	for(int i = 1; i < engines; i++){
+		lo = fmin(lo, power[i]);
+		hi = fmax(hi, power[i]);
+	}
+	CHECK_LE(fabs(hi - lo - (mixer.max_power() - mixer.min_power())), 1e-5);
+
+	/// the throttle near the top is shifted down, the differential is kept
+	CHECK(mixer.mix(0.95f, 0.2f, 0, 0, power));
+	CHECK(in_range(mixer, power));
+	CHECK_LE(fabs(projection< engines >(power, m.tangaj) - 0.2f), 1e-5);
+
+	/// engines are off without power_on
+	sc::StructControls off;
+	off.power_on = false;
+	off.throttle = 1;
+	CHECK(!mixer.mix(off, power));
+	for(int i = 0; i < engines; i++)
+		CHECK(power[i] == mixer.min_power());
+
+	/// the batch (sse for 4 and 8 engines) gives the same as the scalar mix
+	std::vector< sc::StructControls > controls(commands);
+	unsigned state = 12345;
+	for(sc::StructControls& c: controls){
+		float v[4];
+		FOREACH(i, 4, (state = state * 1664525u + 1013904223u, v[i] = static_cast< float >(state >> 8) / (1 << 24)));
+		c.power_on = (state & 0xff) != 0;
+		c.throttle = v[0] * 1.2f - 0.1f;
+		c.tangaj = v[1] * 3 - 1.5f;
+		c.bank = v[2] * 3 - 1.5f;
+		c.yaw = v[3] * 3 - 1.5f;
+	}
+	std::vector< float > batch(commands * engines);
+	size_t saturated = mixer.mix(controls.data(), batch.data(), commands);
+	size_t scalar_saturated = 0;
+	float err = 0;
+	for(int i = 0; i < commands; i++){
+		scalar_saturated += mixer.mix(controls[i], power);
+		FOREACH(j, engines, err = fmax(err, fabs(power[j] - batch[i * engines + j])));
+		CHECK(in_range(mixer, &batch[i * engines]));
+	}
+	CHECK(saturated == scalar_saturated);
+	CHECK_LE(err, eps);
+}
+
+}
+
+int main(int, char**){
+	check_mixer< MixerQuadX >();
+	check_mixer< MixerQuadPlus >();
+	check_mixer< MixerHexa >();
+	check_mixer< MixerOcto >();
+
+	/// the other range of the power
+	Mixer_< 4 > narrow(0.1f, 0.9f);
+	float power[4];
+	CHECK(narrow.mix(0.1f, 0.5f, 0.5f, 0.5f, power));
+	CHECK(in_range(narrow, power));
+
+	return test_common::result("mixer");
+}
@@ -0,0 +1,6 @@
+TARGET = test_precision
+
+include(../tests.pri)
+
+SOURCES += \
+    test_precision.cpp
@@ -0,0 +1,101 @@
+#include <math.h>
+
+#include "precision.h"
+#include "quaternions.h"
+#include "test_common.h"
+
+using namespace precision;
+
+namespace{
+
+const int steps = 200000;
+
+/// the value at i of steps evenly spaced in [from; to]
+inline double grid(double from, double to, int i){
+	return from + (to - from) * i / (steps - 1);
+}
+
+}
+
+int main(int, char**){
+	double err = 0;
+
+	/// relative error of rsqrt and sqrt over the float range
+	for(int i = 0; i < steps; i++){
+		double value = pow(10, grid(-30, 30, i));
+		err = fmax(err, fabs(Fast::rsqrt(value) * Exact::sqrt(value) - 1));
+	}
+	CHECK_LE(err, 2.5e-7);
+
+	err = 0;
+	for(int i = 0; i < steps; i++){
+		double value = pow(10, grid(-30, 30, i));
+		err = fmax(err, fabs(Fast::sqrt(value) / Exact::sqrt(value) - 1));
+	}
+	CHECK_LE(err, 2.5e-7);
+	CHECK(Fast::sqrt(0) == 0 && Fast::sqrt(-1) == 0);
+
+	/// absolute error of sin and cos, several periods in both directions
+	err = 0;
+	for(int i = 0; i < steps; i++){
+		double rad = grid(-8 * M_PI, 8 * M_PI, i);
+		err = fmax(err, fabs(Fast::sin(rad) - ::sin(rad)));
+		err = fmax(err, fabs(Fast::cos(rad) - ::cos(rad)));
+	}
+	CHECK_LE(err, 6e-8);
+
+	/// acos over [-1; 1] with the ends
+	err = 0;
+	for(int i = 0; i < steps; i++){
+		double value = grid(-1, 1, i);
+		err = fmax(err, fabs(Fast::acos(value) - Exact::acos(value)));
+	}
+	CHECK_LE(err, 7e-8);
+	CHECK_LE(fabs(Fast::acos(1)), 7e-8);
+	CHECK_LE(fabs(Fast::acos(-1) - M_PI), 7e-8);
+
+	/// atan2 over all directions and several radii, the axes included
+	err = 0;
+	const double radii[] = {1e-6, 1, 1e6};
+	for(double r: radii){
+		for(int i = 0; i < steps; i++){
+			double a = grid(-M_PI, M_PI, i);
+			double y = r * ::sin(a), x = r * ::cos(a);
+			err = fmax(err, fabs(Fast::atan2(y, x) - Exact::atan2(y, x)));
+		}
+	}
+	CHECK_LE(err, 3e-8);
+	CHECK(Fast::atan2(0, 0) == 0);
+	CHECK_LE(fabs(Fast::atan2(1, 0) - M_PI_2), 3e-8);
+	CHECK_LE(fabs(Fast::atan2(0, -1) - M_PI), 3e-8);
+
+	/// the policies give the same quaternions within the bounds
+	err = 0;
+	for(int i = 0; i < 3600; i++){
+		double angle = i * 0.1;
+		quaternions::Quaternion e = quaternions::Quaternion::fromAxisAndAngle(1, 2, 3, angle);
+		quaternions::Quaternion f = quaternions::Quaternion::fromAxisAndAngle< Fast >(1, 2, 3, angle);
+		err = fmax(err, fabs(e.w - f.w));
+		FOREACH(j, 3, err = fmax(err, fabs(e.v.data[j] - f.v.data[j])));
+	}
+	CHECK_LE(err, 1e-6);
+
+	/// at runtime the constexpr functions are the library ones
+	for(int i = 0; i < steps; i += 97){
+		double rad = grid(-1e6, 1e6, i);
+		CHECK(common_::cx_sin(rad) == ::sin(rad) && common_::cx_cos(rad) == ::cos(rad));
+		CHECK(common_::cx_sqrt(fabs(rad)) == ::sqrt(fabs(rad)));
+	}
+
+	/// in constant expressions: the series, the huge arguments are reduced without overflow
+	constexpr double cx_sin1 = common_::cx_sin(1);
+	constexpr double cx_sin_far = common_::cx_sin(1e3 * M_PI + 0.5);
+	constexpr double cx_sin_huge = common_::cx_sin(1e300);
+	constexpr double cx_root = common_::cx_sqrt(2);
+	CHECK_LE(fabs(cx_sin1 - ::sin(1)), 1e-15);
+	CHECK_LE(fabs(cx_sin_far - ::sin(0.5)), 1e-12);
+	CHECK(cx_sin_huge == 0);
+	CHECK_LE(fabs(cx_root - M_SQRT2), 1e-15);
+
+	return test_common::result("precision");
+}
@@ -0,0 +1,6 @@
+TARGET = test_replay
+
+include(../tests.pri)
+
+SOURCES += \
+    test_replay.cpp
@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <string>
+#include <fstream>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "replay.h"
+#include "test_common.h"
+
+using namespace replay;
+
+namespace{
+
+const int frames = 100;
+
+void fill(ReplayEngine& engine, int count, long long first_tick){
+	sc::StructTelemetry telemetry;
+	for(int i = 0; i < count; i++){
+		telemetry.gyroscope.tick = first_tick + i;
+		engine.add(telemetry);
+	}
+}
+
+/**
+ * @brief check_closed_peer
+ * the run to the descriptor with the closed reader ends at the first write
+ * without SIGPIPE killing the test
+ * @param fds - [0] is read, [1] is written
+ */
+void check_closed_peer(int fds[2]){
+	ReplayEngine engine;
+	fill(engine, frames, 0);
+	engine.set_speed(0);
+	close(fds[0]);
+	ReplayStats stats = engine.run(fds[1], 10);
+	CHECK(stats.aborted);
+	CHECK(stats.errors == 1);
+	CHECK(stats.frames == 0);
+	close(fds[1]);
+}
+
+}
+
+int main(int, char**){
+	const std::string path = "test_replay.rec";
+
+	/// load replaces the frames
+	ReplayEngine source;
+	fill(source, frames, 1000);
+	CHECK(source.save(path));
+
+	ReplayEngine engine;
+	fill(engine, 7, 0);
+	CHECK(engine.load(path));
+	CHECK(engine.count() == frames);
+	CHECK(engine.frames().front().tick == 1000);
+	CHECK(engine.load(path));
+	CHECK(engine.count() == frames);
+
+	/// the truncated recording: no frames are left
+	{
+		std::ifstream in(path.c_str(), std::ios::binary);
+		std::string data((std::istreambuf_iterator< char >(in)), std::istreambuf_iterator< char >());
+		std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+		out.write(data.data(), data.size() - 5);
+	}
+	CHECK(!engine.load(path));
+	CHECK(engine.count() == 0);
+	CHECK(!engine.load(path + ".missing"));
+	CHECK(engine.count() == 0);
+	unlink(path.c_str());
+
+	/// the callback errors are counted, the run goes on
+	ReplayEngine counted;
+	fill(counted, frames, 0);
+	counted.set_speed(0);
+	int calls = 0;
+	ReplayStats stats = counted.run([&calls](const char*, size_t){ return ++calls % 2 == 0; }, 2);
+	CHECK(calls == 2 * frames);
+	CHECK(stats.errors == frames && stats.frames == frames && !stats.aborted);
+
+	/// the closed socket and the closed pipe
+	int fds[2];
+	CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+	check_closed_peer(fds);
+	CHECK(pipe(fds) == 0);
+	check_closed_peer(fds);
+
+	/// the open socket receives all frames
+	CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+	ReplayEngine sender;
+	fill(sender, 10, 0);
+	sender.set_speed(0);
+	stats = sender.run(fds[1]);
+	CHECK(stats.frames == 10 && stats.errors == 0 && !stats.aborted);
+	close(fds[0]);
+	close(fds[1]);
+
+	return test_common::result("replay");
+}
@@ -0,0 +1,6 @@
+TARGET = test_resampler
+
+include(../tests.pri)
+
+SOURCES += \
+    test_resampler.cpp
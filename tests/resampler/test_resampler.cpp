@@ -0,0 +1,133 @@
+#include <math.h>
+#include <vector>
+
+#include "resampler.h"
+#include "test_common.h"
+
+using namespace resampler;
+
+namespace{
+
+/// ms ticks: 1 kHz gyroscope, 10 Hz barometer, the grid of 5 ms
+const long long gyro_step = 1;
+const long long baro_step = 100;
+const long long period = 5;
+const long long duration = 2000;
+
+sc::StructGyroscope gyroscope(long long tick){
+	sc::StructGyroscope res;
+	res.tick = tick;
+	res.gyro = vector3_::Vector3i(static_cast< int >(tick), static_cast< int >(2 * tick), -static_cast< int >(tick));
+	res.accel = vector3_::Vector3i(0, 0, 16384);
+	res.temp = 20;
+	return res;
+}
+
+sc::StructBarometer barometer(long long tick){
+	sc::StructBarometer res;
+	res.tick = tick;
+	res.data = static_cast< int >(100000 + 3 * tick);
+	res.temp = 250;
+	return res;
+}
+
+/// the sample is made of the linear sensors at its tick
+bool exact(const AlignedSample& s){
+	double t = static_cast< double >(s.tick);
+	return fabs(s.gyro.x() - t) < 1e-9 && fabs(s.gyro.y() - 2 * t) < 1e-9 && fabs(s.gyro.z() + t) < 1e-9 &&
+			fabs(s.pressure - (100000 + 3 * t)) < 1e-9;
+}
+
+/**
+ * @brief stream
+ * push the sensors in the real order and take every ready sample
+ * @param window
+ * @param out
+ * @return the resampler after the run
+ */
+SensorResampler stream(size_t window, std::vector< AlignedSample >& out){
+	SensorResampler res(period, SensorResampler::GyroscopeStream | SensorResampler::BarometerStream, window);
+	AlignedSample sample;
+	for(long long tick = 0; tick <= duration; tick += gyro_step){
+		res.push(gyroscope(tick));
+		if(tick % baro_step == 0)
+			res.push(barometer(tick));
+		while(res.next(sample))
+			out.push_back(sample);
+	}
+	return res;
+}
+
+void check_track(){
+	Track_< double > track(4);
+	double value = -1;
+	CHECK(!track.at(0, value) && value == -1);
+
+	track.push(10, 1);
+	track.push(20, 3);
+	track.push(20, 100);					/// not after the last: ignored
+	CHECK(track.size() == 2);
+	CHECK(track.at(5, value) && value == 1);	/// before the first sample: the first value
+	CHECK(track.at(15, value) && value == 2);
+	CHECK(track.at(25, value) && value == 3);	/// after the last sample: the last value
+	CHECK(track.dropped() == 0);
+
+	/// overflow: 10 and 20 are dropped, the ticks before 30 are not covered
+	Track_< double > full(4);
+	FOREACH(i, 6, full.push(10 * (i + 1), i));
+	CHECK(full.dropped() == 2);
+	CHECK(full.first_tick() == 30 && full.last_tick() == 60);
+	CHECK(!full.covers(25));
+	value = -1;
+	CHECK(!full.at(25, value) && value == -1);
+	CHECK(full.at(30, value) && value == 2);
+	CHECK(full.at(45, value) && value == 3.5);
+
+	full.clear();
+	CHECK(full.dropped() == 0 && full.empty());
+}
+
+}
+
+int main(int, char**){
+	check_track();
+
+	/// the window holds the gyroscope between the samples of the barometer: all ticks, exact values
+	std::vector< AlignedSample > wide;
+	SensorResampler wide_res = stream(256, wide);
+	CHECK(wide_res.dropped() == 0 && wide_res.skipped() == 0);
+	CHECK(wide.size() == duration / period + 1);
+	for(size_t i = 0; i < wide.size(); i++){
+		CHECK(wide[i].tick == static_cast< long long >(i) * period);
+		CHECK(exact(wide[i]));
+	}
+
+	/// the batch mode gives the same samples
+	std::vector< sc::StructGyroscope > gyros;
+	std::vector< sc::StructBarometer > baros;
+	for(long long tick = 0; tick <= duration; tick += gyro_step){
+		gyros.push_back(gyroscope(tick));
+		if(tick % baro_step == 0)
+			baros.push_back(barometer(tick));
+	}
+	std::vector< AlignedSample > batch;
+	CHECK(SensorResampler::resample(gyros.data(), gyros.size(), 0, 0, baros.data(), baros.size(),
+									period, batch) == wide.size());
+	for(size_t i = 0; i < batch.size() && i < wide.size(); i++)
+		CHECK(batch[i].tick == wide[i].tick && exact(batch[i]));
+
+	/// the window of 64 overflows while the barometer is waited for: the dropped
+	/// samples are counted, their ticks are skipped, the produced ones are exact
+	std::vector< AlignedSample > narrow;
+	SensorResampler narrow_res = stream(64, narrow);
+	CHECK(narrow_res.dropped() > 0);
+	CHECK(narrow_res.skipped() > 0);
+	CHECK(static_cast< long long >(narrow.size()) + narrow_res.skipped() == duration / period + 1);
+	for(size_t i = 0; i < narrow.size(); i++){
+		CHECK(exact(narrow[i]));
+		if(i)
+			CHECK(narrow[i].tick > narrow[i - 1].tick);
+	}
+
+	return test_common::result("resampler");
+}
@@ -0,0 +1,6 @@
+TARGET = test_servo_scheduler
+
+include(../tests.pri)
+
+SOURCES += \
+    test_servo_scheduler.cpp
@@ -0,0 +1,125 @@
+#include <math.h>
+#include <vector>
+
+#include "servo_scheduler.h"
+#include "test_common.h"
+
+using namespace servo;
+
+namespace{
+
+const int pins = 400;
+const long long step_us = 250;
+const long long end_us = 300000;
+
+enum Kind{
+	Hold,				/// angle at once for 50 ms
+	Ramp,				/// 0 -> 90 with 1000 deg/s, 200 ms
+	Meander,			/// 30 / rest with 100 Hz for 100 ms
+	EndlessMeander		/// meander without timework_ms: rejected
+};
+
+sc::StructServo command(int pin, int kind){
+	sc::StructServo res;
+	res.pin = pin;
+	res.flag_start = true;
+	switch (kind) {
+		case Hold:
+			res.angle = 45;
+			res.timework_ms = 50;
+			break;
+		case Ramp:
+			res.angle = 90;
+			res.speed_of_change = 1000;
+			res.timework_ms = 200;
+			break;
+		default:
+			res.angle = 30;
+			res.freq_meandr = 100;
+			res.timework_ms = kind == Meander? 100 : 0;
+			break;
+	}
+	return res;
+}
+
+/**
+ * @brief expected
+ * the value and the state of the pin after elapsed microseconds from the start
+ */
+void expected(int kind, long long elapsed, float& value, bool& active){
+	switch (kind) {
+		case Hold:
+			value = 45;
+			active = elapsed < 50000;
+			break;
+		case Ramp:
+			value = static_cast< float >(fmin(elapsed / 1000.0, 90));
+			active = elapsed < 200000;
+			break;
+		case Meander:
+			active = elapsed < 100000;
+			value = active && (elapsed / 5000) % 2 == 0? 30 : 0;
+			break;
+		default:
+			value = 0;
+			active = false;
+			break;
+	}
+}
+
+}
+
+int main(int, char**){
+	ServoScheduler scheduler(pins);
+	std::vector< long long > starts(pins);
+	std::vector< bool > started(pins, false);
+
+	for(int i = 0; i < pins; i++){
+		scheduler.add_pin(i, 0);
+		starts[i] = i * 37;
+	}
+
+	int wrong_value = 0, wrong_state = 0, wrong_start = 0;
+	sc::StructServo idle;
+	for(long long now = 0; now <= end_us; now += step_us){
+		for(int i = 0; i < pins; i++){
+			if(started[i] || starts[i] > now)
+				continue;
+			started[i] = true;
+			starts[i] = now;
+			/// the previous command without flag_start, so update() sees the edge
+			idle.pin = i;
+			scheduler.update(idle, now);
+			bool res = scheduler.update(command(i, i % 4), now);
+			if(res != (i % 4 != EndlessMeander))
+				wrong_start++;
+		}
+		scheduler.advance(now);
+		for(int i = 0; i < pins; i++){
+			if(!started[i])
+				continue;
+			int slot = scheduler.slot(i);
+			float value;
+			bool active;
+			expected(i % 4, now - starts[i], value, active);
+			if(fabs(scheduler.target(slot) - value) > 1e-2)
+				wrong_value++;
+			if(scheduler.active(slot) != active)
+				wrong_state++;
+		}
+	}
+	CHECK(wrong_start == 0);
+	CHECK(wrong_value == 0);
+	CHECK(wrong_state == 0);
+	CHECK(scheduler.count() == static_cast< size_t >(pins));
+	/// every move is over, no edge is left behind
+	CHECK(scheduler.pending() == 0);
+
+	/// start() rejects the endless meander as well and keeps the pin as it was
+	sc::StructServo endless = command(1, EndlessMeander);
+	CHECK(!scheduler.start(endless, end_us));
+	CHECK(!scheduler.active(scheduler.slot(1)));
+	CHECK(scheduler.pending() == 0);
+
+	return test_common::result("servo_scheduler");
+}
@@ -0,0 +1,6 @@
+TARGET = test_slerp_batch
+
+include(../tests.pri)
+
+SOURCES += \
+    test_slerp_batch.cpp
@@ -0,0 +1,93 @@
+#include <math.h>
+#include <vector>
+
+#include "slerp_batch.h"
+#include "test_common.h"
+
+using namespace quaternions;
+
+namespace{
+
+const int samples = 257;
+
+/// rotation angle of a^-1 * b in rad
+double angle_between(const Quaternion& a, const Quaternion& b){
+	Quaternion d = a.conj() * b;
+	return 2 * atan2(d.v.length(), fabs(d.w));
+}
+
+double max_component(const Quaternion& a, const Quaternion& b){
+	double res = fabs(a.w - b.w);
+	FOREACH(i, 3, res = fmax(res, fabs(a.v.data[i] - b.v.data[i])));
+	return res;
+}
+
+/**
+ * @brief check_pair
+ * all modes of SlerpBatch against Quaternion::slerp for one pair
+ * @param p0
+ * @param p1
+ */
+void check_pair(const Quaternion& p0, const Quaternion& p1){
+	SlerpBatch batch(p0, p1);
+	std::vector< double > t(samples);
+	std::vector< Quaternion > exact(samples), fast(samples), uniform(samples);
+
+	FOREACH(i, samples, t[i] = static_cast< double >(i) / (samples - 1));
+	batch.evaluate(t.data(), exact.data(), samples, SlerpBatch::Exact);
+	batch.evaluate(t.data(), fast.data(), samples, SlerpBatch::FastNlerp);
+	batch.evaluate_uniform(0, 1.0 / (samples - 1), uniform.data(), samples);
+
+	double exact_error = 0, uniform_error = 0, fast_error = 0;
+	for(int i = 0; i < samples; i++){
+		Quaternion ref = Quaternion::slerp(p0, p1, t[i]);
+		exact_error = fmax(exact_error, max_component(exact[i], ref));
+		uniform_error = fmax(uniform_error, angle_between(uniform[i], ref));
+		fast_error = fmax(fast_error, angle_between(fast[i], ref));
+	}
+	CHECK_LE(exact_error, 1e-12);
+	CHECK_LE(uniform_error, 1e-9);
+	/// the bound of nlerp is documented for the pairs in one hemisphere
+	if(Quaternion::dot(p0, p1) >= 0)
+		CHECK_LE(fast_error, 1e-3);
+
+	/// the ends are exact in every mode
+	CHECK(max_component(fast.front(), p0) == 0 && max_component(fast.back(), p1) == 0);
+	CHECK(max_component(uniform.front(), p0) == 0 && max_component(uniform.back(), p1) == 0);
+}
+
+}
+
+int main(int, char**){
+	/// rotation angles between the pair in degrees, near 0 and near 180 included
+	const double angles[] = {
+		1e-5, 1e-3, 0.01, 0.1, 1, 5, 10, 30, 45, 60, 90, 120, 150,
+		170, 175, 179, 179.9, 179.99, 181, 200, 270, 350, 359.9
+	};
+	const vector3_::Vector3d axes[] = {
+		vector3_::Vector3d(0, 0, 1),
+		vector3_::Vector3d(1, 0, 0),
+		vector3_::Vector3d(1, -2, 0.5).normalized(),
+	};
+	const Quaternion starts[] = {
+		Quaternion(),
+		Quaternion::fromAxisAndAngle(0.3, 0.4, -0.5, 73),
+	};
+
+	for(const Quaternion& p0: starts){
+		for(const vector3_::Vector3d& axis: axes){
+			for(double angle: angles){
+				Quaternion p1 = p0 * Quaternion::fromAxisAndAngle(axis, angle);
+				check_pair(p0, p1);
+			}
+		}
+	}
+
+	/// the same quaternion: the interpolation stays at it
+	Quaternion q = Quaternion::fromAxisAndAngle(0, 1, 0, 30);
+	SlerpBatch same(q, q);
+	CHECK_LE(angle_between(same(0.3), q), 1e-12);
+	CHECK_LE(angle_between(same.nlerp(0.3), q), 1e-12);
+
+	return test_common::result("slerp_batch");
+}
@@ -0,0 +1,6 @@
+TARGET = test_slim_telemetry
+
+include(../tests.pri)
+
+SOURCES += \
+    test_slim_telemetry.cpp
@@ -0,0 +1,115 @@
+#include <string.h>
+#include <vector>
+
+#include "slim_telemetry.h"
+#include "wire.h"
+#include "test_common.h"
+
+using namespace slim;
+
+namespace{
+
+sc::StructTelemetry sample(int i){
+	sc::StructTelemetry res;
+	res.power_on = i % 2 == 0;
+	FOREACH(e, sc::cnt_engines, res.power[e] = 0.1f * e + 0.001f * i);
+	res.tangaj = 1.5f * i;
+	res.bank = -0.25f * i;
+	res.course = 359.5f - i;
+	res.height = 12.75f + i;
+
+	sc::StructGyroscope& g = res.gyroscope;
+	g.gyro = vector3_::Vector3i(i - 50, 32767 - i, -32768 + i);
+	g.accel = vector3_::Vector3i(16384, -i * 100, i);
+	g.afs_sel = static_cast< unsigned char >(i & 3);
+	g.fs_sel = static_cast< unsigned char >((i >> 2) & 3);
+	g.temp = 36.6f + i;
+	g.freq = 1000;
+	g.tick = 1000000000000LL + i;
+	FOREACH(r, sc::raw_count, g.raw[r] = static_cast< unsigned char >(r * 5 + i));
+
+	res.compass.mode = static_cast< unsigned char >(i);
+	res.compass.tick = -7 * i;
+	res.compass.data = vector3_::Vector3i(100000 + i, -200000, i * i);
+	res.barometer.tick = 3LL * i;
+	res.barometer.data = 101325 - i;
+	res.barometer.temp = -400 + i;
+	return res;
+}
+
+/// all fields, by the bytes of the wire layout
+bool same(const sc::StructTelemetry& a, const sc::StructTelemetry& b){
+	std::vector< char > da, db;
+	wire::encode(a, da);
+	wire::encode(b, db);
+	return da == db;
+}
+
+}
+
+int main(int, char**){
+	/// with the cold part the round trip is exact
+	for(int i = 0; i < 100; i++){
+		sc::StructTelemetry t = sample(i), back;
+		HotTelemetry hot;
+		ColdTelemetry cold;
+		memset(&cold, 0xff, sizeof(cold));
+		to_slim(t, hot, &cold);
+		CHECK(hot.flags == 0);
+		FOREACH(r, static_cast< int >(sizeof(cold.reserved)), CHECK(cold.reserved[r] == 0));
+		from_slim(hot, &cold, back);
+		CHECK(same(t, back));
+	}
+
+	/// without it the hot fields are kept, the compass, the barometer and raw are zero
+	{
+		sc::StructTelemetry t = sample(3), back = sample(4), expected = t;
+		HotTelemetry hot;
+		to_slim(t, hot, 0);
+		from_slim(hot, 0, back);
+		expected.compass = sc::StructCompass();
+		expected.barometer = sc::StructBarometer();
+		memset(expected.gyroscope.raw, 0, sizeof(expected.gyroscope.raw));
+		CHECK(same(back, expected));
+	}
+
+	/// the values out of 16 bit are clamped and flagged, the limits are not
+	{
+		sc::StructTelemetry t = sample(0), back;
+		t.gyroscope.gyro = vector3_::Vector3i(40000, -40000, 32767);
+		t.gyroscope.accel = vector3_::Vector3i(-32768, 0, 0);
+		HotTelemetry hot;
+		to_slim(t, hot, 0);
+		CHECK(hot.flags & HotTelemetry::Saturated);
+		CHECK(hot.gyro[0] == 32767 && hot.gyro[1] == -32768 && hot.gyro[2] == 32767);
+		from_slim(hot, 0, back);
+		CHECK(back.gyroscope.gyro[0] == 32767 && back.gyroscope.gyro[1] == -32768);
+		CHECK(back.gyroscope.accel[0] == -32768);
+
+		t.gyroscope.gyro = vector3_::Vector3i(32767, -32768, 0);
+		to_slim(t, hot, 0);
+		CHECK(hot.flags == 0);
+		t.gyroscope.accel = vector3_::Vector3i(0, 0, 32768);
+		to_slim(t, hot, 0);
+		CHECK(hot.flags == HotTelemetry::Saturated && hot.accel[2] == 32767);
+	}
+
+	/// the histories
+	SplitHistory split;
+	SlimHistory slim;
+	std::vector< sc::StructTelemetry > data;
+	FOREACH(i, 50, data.push_back(sample(i)));
+	split.push(data.data(), data.size());
+	slim.push(data.data(), data.size());
+	CHECK(split.size() == 50 && slim.size() == 50);
+	CHECK(slim.cold(0) == 0 && split.cold(0) != 0);
+	CHECK(slim.memory() < split.memory());
+	for(size_t i = 0; i < data.size(); i++){
+		sc::StructTelemetry back;
+		split.get(i, back);
+		CHECK(same(back, data[i]));
+		CHECK(slim.hot(i).tick == data[i].gyroscope.tick && slim.hot_data()[i].height == data[i].height);
+	}
+
+	return test_common::result("slim_telemetry");
+}
@@ -0,0 +1,62 @@
+#ifndef TEST_COMMON_H
+#define TEST_COMMON_H
+
+#include <stdio.h>
+#include <chrono>
+
+namespace test_common{
+
+/**
+ * @brief failures
+ * count of the failed checks of the test
+ * @return
+ */
+static inline int& failures(){
+	static int value = 0;
+	return value;
+}
+
+/**
+ * @brief result
+ * print the summary, the value of main()
+ * @param name
+ * @return
+ */
+static inline int result(const char* name){
+	if(failures())
+		printf("%s: %d checks failed\n", name, failures());
+	else
+		printf("%s: passed\n", name);
+	return failures() ? 1 : 0;
+}
+
+/**
+ * @brief now_ns
+ * monotonic time for the benchmarks
+ * @return
+ */
+static inline long long now_ns(){
+	return std::chrono::duration_cast< std::chrono::nanoseconds >(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+/// the check is counted and reported, the test goes on
+#define CHECK(cond) do{ \
+	if(!(cond)){ \
+		printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+		test_common::failures()++; \
+	} \
+}while(0)
+
+/// the check of the bound prints the value that exceeds it
+#define CHECK_LE(value, bound) do{ \
+	double v_ = (value), b_ = (bound); \
+	if(!(v_ <= b_)){ \
+		printf("%s:%d: check failed: %s = %g > %g\n", __FILE__, __LINE__, #value, v_, b_); \
+		test_common::failures()++; \
+	} \
+}while(0)
+
+#endif // TEST_COMMON_H
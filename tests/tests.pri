@@ -0,0 +1,9 @@
+TEMPLATE = app
+QT = core
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+include($$PWD/../struct_controls.pri)
+
+INCLUDEPATH += $$PWD
+HEADERS += $$PWD/test_common.h
@@ -0,0 +1,20 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    aggregation \
+    ahrs \
+    coro_io \
+    fleet_simulator \
+    height_estimator \
+    mixer \
+    precision \
+    replay \
+    resampler \
+    servo_scheduler \
+    slerp_batch \
+    slim_telemetry \
+    trace \
+    vibration \
+    wire \
+    wire_decode \
+    zone_map
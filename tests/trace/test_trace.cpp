@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "trace.h"
+#include "ingest.h"
+#include "load_generator.h"
+#include "replay.h"
+#include "test_common.h"
+
+/// loopback of the whole path in one process: LoadGenerator and ReplayEngine
+/// send over tcp to IngestServer, the stamps come back in IngestRecord
+
+namespace{
+
+const long long frames = 20000;
+const int replay_frames = 200;
+
+int connect_to(unsigned short port){
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+	if(fd >= 0 && connect(fd, reinterpret_cast< sockaddr* >(&addr), sizeof(addr)) < 0){
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+bool wait_frames(const ingest::IngestServer& server, long long count){
+	for(int i = 0; i < 1000 && server.stats().frames < count; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	return server.stats().frames >= count;
+}
+
+void print(const char* title, const trace::LatencyCollector& collector){
+	printf("%s\n", title);
+	for(int s = 0; s <= trace::LatencyCollector::total; s++){
+		if(!collector.count(s))
+			continue;
+		printf("  %-8s n %6lld  mean %9.0f  p50 %8lld  p99 %8lld  max %9lld ns\n",
+			   trace::LatencyCollector::name(s), collector.count(s), collector.mean(s),
+			   collector.percentile(s, 0.5), collector.percentile(s, 0.99), collector.max(s));
+	}
+}
+
+}
+
+int main(int, char**){
+	CHECK(trace::enabled);
+
+	/// the receiver keeps its own stamps, the sender's are merged
+	trace::TraceStamps sent, received;
+	sent.set(trace::Sample, 100);
+	sent.set(trace::Receive, 1);
+	std::vector< char > frame(10, 0);
+	trace::append(frame, sent);
+	received.set(trace::Receive, 200);
+	size_t size = frame.size();
+	CHECK(trace::strip(&frame[0], size, received));
+	CHECK(size == 10);
+	CHECK(received.stamp[trace::Sample] == 100 && received.stamp[trace::Receive] == 200);
+
+	std::mutex mutex;
+	trace::LatencyCollector collector;
+	ingest::IngestServer server(1);
+	server.set_consumer([&](int, const ingest::IngestRecord* records, size_t count){
+		std::lock_guard< std::mutex > lock(mutex);
+		for(size_t i = 0; i < count; i++)
+			collector.add(records[i].stamps);
+	});
+	CHECK(server.start(0, "127.0.0.1"));
+
+	/// generator: Sample, Encode, Enqueue -> Receive, Decode
+	int fd = connect_to(server.port());
+	CHECK(fd >= 0);
+	loadgen::LoadGenerator generator(1);
+	generator.set_chunk(16);
+	CHECK(loadgen::LoadGenerator::send_hello(fd, 1));
+	generator.run(frames, loadgen::LoadGenerator::fd_sink(std::vector< int >(1, fd)));
+	CHECK(wait_frames(server, frames));
+	{
+		std::lock_guard< std::mutex > lock(mutex);
+		print("load generator -> ingest", collector);
+		CHECK(collector.count(trace::Sample) == 0);
+		CHECK(collector.count(trace::Encode) == frames);
+		CHECK(collector.count(trace::Enqueue) == frames);
+		CHECK(collector.count(trace::Send) == 0);
+		CHECK(collector.count(trace::Receive) == frames);
+		CHECK(collector.count(trace::Decode) == frames);
+		CHECK(collector.count(trace::LatencyCollector::total) == frames);
+		CHECK(collector.percentile(trace::LatencyCollector::total, 0.5) > 0);
+		collector.reset();
+	}
+	close(fd);
+
+	/// replay: Sample (the scheduled time), Send -> Receive, Decode
+	replay::ReplayEngine engine;
+	sc::StructTelemetry telemetry;
+	for(int i = 0; i < replay_frames; i++){
+		telemetry.gyroscope.tick = i * 1000;
+		engine.add(telemetry);
+	}
+	engine.set_ticks_per_second(1e6);
+	engine.set_speed(10);
+	engine.set_framing(true);
+	fd = connect_to(server.port());
+	CHECK(fd >= 0);
+	CHECK(loadgen::LoadGenerator::send_hello(fd, 2));
+	replay::ReplayStats stats = engine.run(fd);
+	CHECK(stats.frames == replay_frames);
+	CHECK(wait_frames(server, frames + replay_frames));
+	{
+		std::lock_guard< std::mutex > lock(mutex);
+		print("replay -> ingest", collector);
+		CHECK(collector.count(trace::Send) == replay_frames);
+		CHECK(collector.count(trace::Receive) == replay_frames);
+		CHECK(collector.count(trace::Decode) == replay_frames);
+		CHECK(collector.count(trace::LatencyCollector::total) == replay_frames);
+	}
+	close(fd);
+	server.stop();
+	CHECK(server.stats().errors == 0);
+
+	return test_common::result("trace");
+}
@@ -0,0 +1,8 @@
+TARGET = test_trace
+
+include(../tests.pri)
+
+DEFINES += WITH_TRACE
+
+SOURCES += \
+    test_trace.cpp
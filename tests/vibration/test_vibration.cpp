@@ -0,0 +1,102 @@
+#include <math.h>
+#include <vector>
+
+#include "vibration.h"
+#include "test_common.h"
+
+using namespace vibration;
+
+namespace{
+
+const float sample_rate = 1000;
+
+/**
+ * @brief check_fft
+ * Fft_ against the direct dft in double on the pseudo random signal
+ */
+template< int N >
+void check_fft(){
+	std::vector< float > x(N);
+	unsigned state = 7 + N;
+	double norm = 0;
+	for(int n = 0; n < N; n++){
+		state = state * 1664525u + 1013904223u;
+		x[n] = static_cast< float >(state >> 8) / (1 << 24) * 2 - 1;
+		norm += fabs(x[n]);
+	}
+
+	Fft_< N > fft;
+	float re[Fft_< N >::bins], im[Fft_< N >::bins], power[Fft_< N >::bins];
+	fft.forward(x.data(), re, im);
+	fft.power(x.data(), power);
+
+	double err = 0, power_err = 0;
+	for(int k = 0; k < Fft_< N >::bins; k++){
+		double dr = 0, di = 0;
+		for(int n = 0; n < N; n++){
+			double a = -2 * M_PI * static_cast< double >(k) * n / N;
+			dr += x[n] * cos(a);
+			di += x[n] * sin(a);
+		}
+		err = fmax(err, fmax(fabs(re[k] - dr), fabs(im[k] - di)));
+		power_err = fmax(power_err, fabs(power[k] - (dr * dr + di * di)));
+	}
+	/// relative to the bound of |X[k]|
+	CHECK_LE(err / norm, 1e-6);
+	CHECK_LE(power_err / (norm * norm), 1e-6);
+}
+
+vector3_::Vector3i sample(double amplitude, double frequency, int n, int axis){
+	vector3_::Vector3i res;
+	res[axis] = static_cast< int >(lround(amplitude * sin(2 * M_PI * frequency * n / sample_rate)));
+	return res;
+}
+
+}
+
+int main(int, char**){
+	check_fft< 8 >();
+	check_fft< 16 >();
+	check_fft< 64 >();
+	check_fft< 256 >();
+	check_fft< 1024 >();
+
+	/// sines on the accelerometer x and the gyroscope z, between the bins
+	const double accel_frequency = 87.3, accel_amplitude = 500;
+	const double gyro_frequency = 212.6, gyro_amplitude = 120;
+	VibrationAnalyzer analyzer(sample_rate);
+	CHECK(analyzer.peak(AccelX).amplitude == 0);
+	for(int n = 0; n < 8192; n++){
+		vector3_::Vector3i accel = sample(accel_amplitude, accel_frequency, n, 0);
+		accel[2] = 16384;								/// gravity is removed with the mean
+		analyzer.push(accel, sample(gyro_amplitude, gyro_frequency, n, 2));
+	}
+	CHECK(analyzer.spectra() == (8192 - VibrationAnalyzer::size) / (VibrationAnalyzer::size / 2) + 1);
+
+	const float bin = sample_rate / VibrationAnalyzer::size;
+	/// between the bins the amplitude is of the bin: the scalloping loss of hann is up to 15%
+	const double scalloping = 0.16;
+	Peak accel = analyzer.peak(AccelX);
+	CHECK_LE(fabs(accel.frequency - accel_frequency), 0.2 * bin);
+	CHECK_LE(fabs(accel.amplitude / accel_amplitude - 1), scalloping);
+	Peak gyro = analyzer.peak(GyroZ, 50);
+	CHECK_LE(fabs(gyro.frequency - gyro_frequency), 0.2 * bin);
+	CHECK_LE(fabs(gyro.amplitude / gyro_amplitude - 1), scalloping);
+
+	/// the mean square of the sine is amplitude^2 / 2, it is in the band around the peak
+	float energy = analyzer.band_energy(AccelX, accel_frequency - 4 * bin, accel_frequency + 4 * bin);
+	CHECK_LE(fabs(energy / (accel_amplitude * accel_amplitude / 2) - 1), 0.02);
+	CHECK_LE(analyzer.band_energy(AccelZ, 0, sample_rate / 2), 1);
+	CHECK_LE(analyzer.band_energy(GyroX, 0, sample_rate / 2), 1);
+
+	/// at the bin the amplitude is exact
+	VibrationAnalyzer exact(sample_rate);
+	const double on_bin = 64 * bin;
+	for(int n = 0; n < 4096; n++)
+		exact.push(sample(1000, on_bin, n, 1), vector3_::Vector3i());
+	Peak y = exact.peak(AccelY);
+	CHECK_LE(fabs(y.frequency - on_bin), 1e-3 * bin);
+	CHECK_LE(fabs(y.amplitude / 1000 - 1), 1e-3);
+
+	return test_common::result("vibration");
+}
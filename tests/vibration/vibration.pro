@@ -0,0 +1,6 @@
+TARGET = test_vibration
+
+include(../tests.pri)
+
+SOURCES += \
+    test_vibration.cpp
@@ -0,0 +1,60 @@
+#include <string.h>
+#include <vector>
+
+#include "wire.h"
+#include "load_generator.h"
+#include "test_common.h"
+#include "wire_fixtures.h"
+
+namespace{
+
+const int frames = 1000;
+
+/// the bytes are the golden frame
+bool same(const std::vector< char >& data, const unsigned char* golden, size_t size){
+	return data.size() == size && memcmp(data.data(), golden, size) == 0;
+}
+
+bool same(const std::vector< char >& a, const std::vector< char >& b){
+	return a.size() == b.size() && memcmp(a.data(), b.data(), a.size()) == 0;
+}
+
+}
+
+int main(int, char**){
+	CHECK(sizeof(wire_fixtures::telemetry) == wire::telemetry_size);
+	CHECK(sizeof(wire_fixtures::controls) == wire::controls_size);
+
+	/// the native encoder and write_to give the golden bytes
+	std::vector< char > data;
+	const sc::StructTelemetry telemetry = wire_fixtures::make_telemetry();
+	wire::encode(telemetry, data);
+	CHECK(same(data, wire_fixtures::telemetry, sizeof(wire_fixtures::telemetry)));
+	wire::stream_encode(telemetry, data);
+	CHECK(same(data, wire_fixtures::telemetry, sizeof(wire_fixtures::telemetry)));
+
+	const sc::StructControls controls = wire_fixtures::make_controls();
+	wire::encode(controls, data);
+	CHECK(same(data, wire_fixtures::controls, sizeof(wire_fixtures::controls)));
+	wire::stream_encode(controls, data);
+	CHECK(same(data, wire_fixtures::controls, sizeof(wire_fixtures::controls)));
+
+	/// the same bytes for the frames of the generator
+	loadgen::SensorGenerator generator(7);
+	sc::StructTelemetry generated;
+	sc::StructControls commands;
+	std::vector< char > native, stream;
+	for(int i = 0; i < frames; i++){
+		generator.next(generated);
+		wire::encode(generated, native);
+		wire::stream_encode(generated, stream);
+		CHECK(same(native, stream));
+
+		generator.controls(commands);
+		wire::encode(commands, native);
+		wire::stream_encode(commands, stream);
+		CHECK(same(native, stream));
+	}
+
+	return test_common::result("wire");
+}
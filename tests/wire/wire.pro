@@ -0,0 +1,9 @@
+TARGET = test_wire
+
+include(../tests.pri)
+
+HEADERS += \
+    wire_fixtures.h
+
+SOURCES += \
+    test_wire.cpp
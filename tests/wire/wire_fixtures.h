@@ -0,0 +1,112 @@
+#ifndef WIRE_FIXTURES_H
+#define WIRE_FIXTURES_H
+
+#include "struct_controls.h"
+
+/**
+ * the golden frames of write_to in QDataStream::Qt_4_8, BigEndian, SinglePrecision.
+ * the bytes are written by the layout of the fields (float ">f", int ">i",
+ * long long ">q", bool and unsigned char one byte), not by the encoders under test
+ */
+namespace wire_fixtures{
+
+const unsigned char telemetry[] = {
+	/// gyroscope: temp 1.5, gyro (1, -1, 256), accel (-16384, 0, 16384)
+	0x3f, 0xc0, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x01, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x01, 0x00,
+	0xff, 0xff, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00,
+	/// afs_sel 1, fs_sel 3, freq 1000, tick 0x0102030405060708
+	0x01, 0x03,
+	0x44, 0x7a, 0x00, 0x00,
+	0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+	/// raw 0..45
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+	0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+	0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23,
+	0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d,
+	/// compass: mode 0x10, tick -2, data (100, -200, 300)
+	0x10,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe,
+	0x00, 0x00, 0x00, 0x64, 0xff, 0xff, 0xff, 0x38, 0x00, 0x00, 0x01, 0x2c,
+	/// barometer: tick 123456789, data 101325, temp -250
+	0x00, 0x00, 0x00, 0x00, 0x07, 0x5b, 0xcd, 0x15,
+	0x00, 0x01, 0x8b, 0xcd,
+	0xff, 0xff, 0xff, 0x06,
+	/// power_on true, power (0.25, 0.5, 0.75, 1)
+	0x01,
+	0x3e, 0x80, 0x00, 0x00, 0x3f, 0x00, 0x00, 0x00, 0x3f, 0x40, 0x00, 0x00, 0x3f, 0x80, 0x00, 0x00,
+	/// tangaj -0.125, bank 3, course 90.5, height 12.5
+	0xbe, 0x00, 0x00, 0x00, 0x40, 0x40, 0x00, 0x00, 0x42, 0xb5, 0x00, 0x00, 0x41, 0x48, 0x00, 0x00
+};
+
+const unsigned char controls[] = {
+	/// power_on true, throttle 0.5, tangaj -1, bank 2, yaw 0.25
+	0x01,
+	0x3f, 0x00, 0x00, 0x00, 0xbf, 0x80, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00, 0x3e, 0x80, 0x00, 0x00,
+	/// servo: freq_meandr 50, angle 90, speed_of_change 1, timework_ms 10
+	0x42, 0x48, 0x00, 0x00, 0x42, 0xb4, 0x00, 0x00, 0x3f, 0x80, 0x00, 0x00, 0x41, 0x20, 0x00, 0x00,
+	/// flag_start true, pin -2
+	0x01,
+	0xff, 0xff, 0xff, 0xfe
+};
+
+/// position of servo_ctrl.flag_start in controls
+const int controls_flag_start = 1 + 4 * 4 + 4 * 4;
+
+/**
+ * @brief make_telemetry
+ * the values of the golden telemetry frame
+ * @return
+ */
+inline sc::StructTelemetry make_telemetry(){
+	sc::StructTelemetry res;
+	res.gyroscope.temp = 1.5f;
+	res.gyroscope.gyro = vector3_::Vector3i(1, -1, 256);
+	res.gyroscope.accel = vector3_::Vector3i(-16384, 0, 16384);
+	res.gyroscope.afs_sel = 1;
+	res.gyroscope.fs_sel = 3;
+	res.gyroscope.freq = 1000;
+	res.gyroscope.tick = 0x0102030405060708LL;
+	FOREACH(i, sc::raw_count, res.gyroscope.raw[i] = static_cast< unsigned char >(i));
+
+	res.compass.mode = 0x10;
+	res.compass.tick = -2;
+	res.compass.data = vector3_::Vector3i(100, -200, 300);
+
+	res.barometer.tick = 123456789;
+	res.barometer.data = 101325;
+	res.barometer.temp = -250;
+
+	res.power_on = true;
+	FOREACH(i, sc::cnt_engines, res.power[i] = 0.25f * (i + 1));
+	res.tangaj = -0.125f;
+	res.bank = 3;
+	res.course = 90.5f;
+	res.height = 12.5f;
+	return res;
+}
+
+/**
+ * @brief make_controls
+ * the values of the golden controls frame
+ * @return
+ */
+inline sc::StructControls make_controls(){
+	sc::StructControls res;
+	res.power_on = true;
+	res.throttle = 0.5f;
+	res.tangaj = -1;
+	res.bank = 2;
+	res.yaw = 0.25f;
+	res.servo_ctrl.freq_meandr = 50;
+	res.servo_ctrl.angle = 90;
+	res.servo_ctrl.speed_of_change = 1;
+	res.servo_ctrl.timework_ms = 10;
+	res.servo_ctrl.flag_start = true;
+	res.servo_ctrl.pin = -2;
+	return res;
+}
+
+}
+
+#endif // WIRE_FIXTURES_H
@@ -0,0 +1,120 @@
+#include <string.h>
+#include <vector>
+
+#include "wire.h"
+#include "test_common.h"
+#include "wire_fixtures.h"
+
+namespace{
+
+/**
+ * @brief check_telemetry
+ * the fields of the golden telemetry frame
+ * @param value
+ */
+void check_telemetry(const sc::StructTelemetry& value){
+	const sc::StructGyroscope& gyroscope = value.gyroscope;
+	CHECK(gyroscope.temp == 1.5f);
+	CHECK(gyroscope.gyro[0] == 1 && gyroscope.gyro[1] == -1 && gyroscope.gyro[2] == 256);
+	CHECK(gyroscope.accel[0] == -16384 && gyroscope.accel[1] == 0 && gyroscope.accel[2] == 16384);
+	CHECK(gyroscope.afs_sel == 1);
+	CHECK(gyroscope.fs_sel == 3);
+	CHECK(gyroscope.freq == 1000);
+	CHECK(gyroscope.tick == 0x0102030405060708LL);
+	for(int i = 0; i < sc::raw_count; i++)
+		CHECK(gyroscope.raw[i] == i);
+
+	CHECK(value.compass.mode == 0x10);
+	CHECK(value.compass.tick == -2);
+	CHECK(value.compass.data[0] == 100 && value.compass.data[1] == -200 && value.compass.data[2] == 300);
+
+	CHECK(value.barometer.tick == 123456789);
+	CHECK(value.barometer.data == 101325);
+	CHECK(value.barometer.temp == -250);
+
+	CHECK(value.power_on);
+	CHECK(value.power[0] == 0.25f && value.power[1] == 0.5f && value.power[2] == 0.75f && value.power[3] == 1);
+	CHECK(value.tangaj == -0.125f);
+	CHECK(value.bank == 3);
+	CHECK(value.course == 90.5f);
+	CHECK(value.height == 12.5f);
+}
+
+/**
+ * @brief check_controls
+ * the fields of the golden controls frame
+ * @param value
+ */
+void check_controls(const sc::StructControls& value){
+	CHECK(value.power_on);
+	CHECK(value.throttle == 0.5f);
+	CHECK(value.tangaj == -1);
+	CHECK(value.bank == 2);
+	CHECK(value.yaw == 0.25f);
+	CHECK(value.servo_ctrl.freq_meandr == 50);
+	CHECK(value.servo_ctrl.angle == 90);
+	CHECK(value.servo_ctrl.speed_of_change == 1);
+	CHECK(value.servo_ctrl.timework_ms == 10);
+	CHECK(value.servo_ctrl.flag_start);
+	CHECK(value.servo_ctrl.pin == -2);
+}
+
+const char* bytes(const unsigned char* data){
+	return reinterpret_cast< const char* >(data);
+}
+
+}
+
+int main(int, char**){
+	const char* telemetry = bytes(wire_fixtures::telemetry);
+	const char* controls = bytes(wire_fixtures::controls);
+
+	/// the native decoder and read_from give the fields of the golden frames
+	sc::StructTelemetry t;
+	CHECK(wire::decode(telemetry, wire::telemetry_size, t));
+	check_telemetry(t);
+	sc::StructTelemetry ts;
+	CHECK(wire::stream_decode(telemetry, wire::telemetry_size, ts));
+	check_telemetry(ts);
+
+	sc::StructControls c;
+	CHECK(wire::decode(controls, wire::controls_size, c));
+	check_controls(c);
+	sc::StructControls cs;
+	CHECK(wire::stream_decode(controls, wire::controls_size, cs));
+	check_controls(cs);
+
+	/// as QDataStream any non zero byte of bool is true, zero is false
+	std::vector< char > flag(controls, controls + wire::controls_size);
+	flag[wire_fixtures::controls_flag_start] = 0x05;
+	sc::StructControls nonzero;
+	nonzero.servo_ctrl.flag_start = false;
+	CHECK(wire::decode(flag.data(), flag.size(), nonzero));
+	CHECK(nonzero.servo_ctrl.flag_start);
+	nonzero.servo_ctrl.flag_start = false;
+	CHECK(wire::stream_decode(flag.data(), flag.size(), nonzero));
+	CHECK(nonzero.servo_ctrl.flag_start);
+
+	flag[wire_fixtures::controls_flag_start] = 0;
+	sc::StructControls zero;
+	CHECK(wire::decode(flag.data(), flag.size(), zero));
+	CHECK(!zero.servo_ctrl.flag_start);
+	CHECK(zero.servo_ctrl.pin == -2);
+
+	/// the frame shorter than the layout is rejected, the value is not changed
+	sc::StructTelemetry short_t = t;
+	CHECK(!wire::decode(telemetry, wire::telemetry_size - 1, short_t));
+	check_telemetry(short_t);
+	sc::StructControls short_c = c;
+	CHECK(!wire::decode(controls, wire::controls_size - 1, short_c));
+	check_controls(short_c);
+
+	/// the bytes after the frame are not read
+	std::vector< char > longer(telemetry, telemetry + wire::telemetry_size);
+	longer.resize(longer.size() + 16, 0x7f);
+	sc::StructTelemetry long_t;
+	CHECK(wire::decode(longer.data(), longer.size(), long_t));
+	check_telemetry(long_t);
+
+	return test_common::result("wire_decode");
+}
@@ -0,0 +1,10 @@
+TARGET = test_wire_decode
+
+include(../tests.pri)
+
+INCLUDEPATH += $$PWD/../wire
+HEADERS += \
+    ../wire/wire_fixtures.h
+
+SOURCES += \
+    test_wire_decode.cpp
@@ -0,0 +1,186 @@
+#include <math.h>
+#include <unistd.h>
+#include <vector>
+#include <string>
+
+#include "zone_map.h"
+#include "test_common.h"
+
+using namespace zonemap;
+
+/// the queries of ZoneMapReader against the full decode of the same recording
+
+namespace{
+
+const size_t block_frames = 64;
+
+unsigned rand_state = 12345;
+
+unsigned next_rand(){
+	rand_state = rand_state * 1103515245u + 12345u;
+	return rand_state >> 8;
+}
+
+sc::StructTelemetry make(long long tick){
+	sc::StructTelemetry res;
+	res.gyroscope.tick = tick;
+	res.tangaj = static_cast< float >(next_rand() % 2000) * 0.01f - 10;
+	res.height = static_cast< float >(tick % 997) * 0.5f;
+	res.gyroscope.gyro = vector3_::Vector3i(static_cast< int >(next_rand() % 20000) - 10000, 0, 0);
+	return res;
+}
+
+RangeResult direct(const std::vector< sc::StructTelemetry >& all, int field, long long from, long long to){
+	RangeResult res;
+	float v[aggregation::fields];
+	for(size_t i = 0; i < all.size(); i++){
+		long long tick = all[i].gyroscope.tick;
+		if(tick < from || tick > to)
+			continue;
+		aggregation::values(all[i], v);
+		res.min = res.count? std::min(res.min, v[field]) : v[field];
+		res.max = res.count? std::max(res.max, v[field]) : v[field];
+		res.sum += v[field];
+		res.count++;
+	}
+	return res;
+}
+
+bool direct_above(const std::vector< sc::StructTelemetry >& all, int field, float threshold, long long& tick, long long from){
+	float v[aggregation::fields];
+	for(size_t i = 0; i < all.size(); i++){
+		if(all[i].gyroscope.tick < from)
+			continue;
+		aggregation::values(all[i], v);
+		if(v[field] > threshold){
+			tick = all[i].gyroscope.tick;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool same(const RangeResult& a, const RangeResult& b){
+	return a.count == b.count && a.min == b.min && a.max == b.max
+			&& fabs(a.sum - b.sum) <= 1e-9 * (1 + fabs(b.sum));
+}
+
+/**
+ * @brief compare
+ * ranges on the edges of the blocks and random ones
+ * @param reader
+ * @param all
+ */
+void compare(ZoneMapReader& reader, const std::vector< sc::StructTelemetry >& all){
+	const int fields[] = { aggregation::Tangaj, aggregation::Height, aggregation::GyroX };
+	std::vector< long long > edges;
+	for(size_t i = 0; i < reader.blocks(); i++){
+		const BlockSummary& b = reader.block(i);
+		if(!b.frames)
+			continue;
+		edges.push_back(b.min_tick);
+		edges.push_back(b.max_tick);
+		edges.push_back(b.min_tick - 1);
+		edges.push_back(b.max_tick + 1);
+	}
+	for(int f: fields){
+		for(size_t i = 0; i < edges.size(); i += 3){
+			for(size_t j = i; j < edges.size(); j += 5){
+				long long from = std::min(edges[i], edges[j]), to = std::max(edges[i], edges[j]);
+				CHECK(same(reader.aggregate(f, from, to), direct(all, f, from, to)));
+			}
+		}
+		for(int i = 0; i < 200; i++){
+			long long from = next_rand() % 3200, to = from + next_rand() % 1500;
+			CHECK(same(reader.aggregate(f, from, to), direct(all, f, from, to)));
+
+			float threshold = f == aggregation::GyroX? static_cast< float >(next_rand() % 10000) : 9.9f;
+			long long tick = -1, expected = -1;
+			bool found = reader.first_above(f, threshold, tick, from);
+			CHECK(found == direct_above(all, f, threshold, expected, from));
+			CHECK(!found || tick == expected);
+		}
+	}
+}
+
+}
+
+int main(int, char**){
+	const std::string path = "test_zone_map.rec";
+	std::vector< sc::StructTelemetry > all;
+	ZoneMapWriter writer(block_frames);
+	CHECK(writer.open(path));
+
+	sc::StructControls controls;
+	/// ticks 0..999, the restarted clock 500..799, a gap, 2000..3003:
+	/// 36 full blocks of telemetry
+	for(long long tick = 0; tick < 3004; tick++){
+		if(tick >= 1300 && tick < 2000)
+			continue;
+		long long t = tick < 1000? tick : tick < 1300? tick - 500 : tick;
+		all.push_back(make(t));
+		/// the spike at the second frame with tick 600
+		if(tick == 1100){
+			all.back().tangaj = 100;
+			all.back().height = 1000;
+		}
+		CHECK(writer.write(all.back()));
+		if(tick % 7 == 0)
+			CHECK(writer.write(controls, t));
+		/// a long run of controls inside one block
+		if(tick == 2100)
+			FOREACH(i, 300, CHECK(writer.write(controls, t)));
+	}
+	/// the trailing block without telemetry
+	FOREACH(i, 100, CHECK(writer.write(controls, 3004 + i)));
+	CHECK(writer.close());
+
+	ZoneMapReader reader;
+	CHECK(reader.open(path));
+	CHECK(reader.blocks() == (all.size() + block_frames - 1) / block_frames + 1);
+	CHECK(reader.block(reader.blocks() - 1).frames == 0);
+
+	/// the summaries and the blocks
+	long long frames = 0;
+	std::vector< sc::StructTelemetry > telemetry;
+	for(size_t i = 0; i < reader.blocks(); i++){
+		const BlockSummary& b = reader.block(i);
+		CHECK(reader.read_block(i, telemetry));
+		CHECK(static_cast< long long >(telemetry.size()) == b.frames);
+		for(size_t j = 0; j < telemetry.size(); j++){
+			CHECK(telemetry[j].gyroscope.tick == all[frames + j].gyroscope.tick);
+			CHECK(telemetry[j].gyroscope.tick >= b.min_tick && telemetry[j].gyroscope.tick <= b.max_tick);
+		}
+		frames += b.frames;
+	}
+	CHECK(frames == static_cast< long long >(all.size()));
+
+	compare(reader, all);
+
+	/// inside the monotonic part only the two boundary blocks are decoded
+	long long decoded = reader.decoded_blocks();
+	RangeResult inner = reader.aggregate(aggregation::Height, 2100, 2900);
+	CHECK(reader.decoded_blocks() - decoded == 2);
+	CHECK(same(inner, direct(all, aggregation::Height, 2100, 2900)));
+
+	/// the spike is found after the earlier frame with the same tick
+	long long tick = -1;
+	CHECK(reader.first_above(aggregation::Tangaj, 50, tick, 0) && tick == 600);
+	CHECK(reader.first_above(aggregation::Tangaj, 50, tick, 600) && tick == 600);
+	CHECK(!reader.first_above(aggregation::Tangaj, 50, tick, 601));
+	CHECK(!reader.first_above(aggregation::Tangaj, 100, tick, 0));
+	RangeResult spike = reader.aggregate(aggregation::Height, 600, 600);
+	CHECK(spike.count == 2 && spike.max == 1000);
+	CHECK(reader.aggregate(aggregation::Tangaj, 3004, 4000).count == 0);
+
+	/// the index made for the existing recording gives the same answers
+	unlink(index_path(path).c_str());
+	CHECK(!reader.open(path));
+	CHECK(ZoneMapWriter::build(path, block_frames));
+	CHECK(reader.open(path));
+	compare(reader, all);
+
+	unlink(path.c_str());
+	unlink(index_path(path).c_str());
+	return test_common::result("zone_map");
+}
@@ -0,0 +1,6 @@
+TARGET = test_zone_map
+
+include(../tests.pri)
+
+SOURCES += \
+    test_zone_map.cpp
@@ -0,0 +1,188 @@
+#include "trace.h"
+
+#include <time.h>
+
+#include "common_.h"
+
+using namespace trace;
+
+namespace {
+
+const unsigned magic = 0x54524331;		/// "TRC1"
+
+inline void put_be(char* out, unsigned long long value, int bytes)
+{
+	for(int i = 0; i < bytes; i++)
+		out[i] = static_cast< char >((value >> (8 * (bytes - 1 - i))) & 0xff);
+}
+
+inline unsigned long long get_be(const char* data, int bytes)
+{
+	const unsigned char* d = reinterpret_cast< const unsigned char* >(data);
+	unsigned long long res = 0;
+	for(int i = 0; i < bytes; i++)
+		res = (res << 8) | d[i];
+	return res;
+}
+
+inline int bucket_of(long long ns)
+{
+	if(ns < LatencyCollector::sub_buckets)
+		return ns < 0? 0 : static_cast< int >(ns);
+	int e = 63 - __builtin_clzll(static_cast< unsigned long long >(ns));
+	int sub = static_cast< int >((ns >> (e - 3)) & 7);
+	int res = (e - 2) * LatencyCollector::sub_buckets + sub;
+	return res < LatencyCollector::buckets? res : LatencyCollector::buckets - 1;
+}
+
+inline long long bucket_upper(int bucket)
+{
+	if(bucket < LatencyCollector::sub_buckets)
+		return bucket;
+	int e = bucket / LatencyCollector::sub_buckets + 2;
+	int sub = bucket % LatencyCollector::sub_buckets;
+	return ((8LL + sub + 1) << (e - 3)) - 1;
+}
+
+}
+
+long long trace::now_ns()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast< long long >(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+////////////////////////////////////////////////
+
+TraceStamps::TraceStamps()
+{
+	FOREACH(i, stages, stamp[i] = 0);
+	mask = 0;
+}
+
+void trace::append(std::vector<char> &frame, const TraceStamps &stamps)
+{
+#ifdef WITH_TRACE
+	size_t pos = frame.size();
+	frame.resize(pos + trailer_size);
+	char* out = &frame[pos];
+	FOREACH(i, stages, put_be(out + 8 * i, static_cast< unsigned long long >(stamps.stamp[i]), 8));
+	out[stages * 8] = static_cast< char >(stamps.mask);
+	put_be(out + stages * 8 + 1, magic, 4);
+#else
+	(void)frame;
+	(void)stamps;
+#endif
+}
+
+bool trace::strip(const char *data, size_t &size, TraceStamps &stamps)
+{
+#ifdef WITH_TRACE
+	if(size < trailer_size || get_be(data + size - 4, 4) != magic)
+		return false;
+	const char* in = data + size - trailer_size;
+	unsigned mask = static_cast< unsigned char >(in[stages * 8]) & ~stamps.mask;
+	FOREACH(i, stages, {
+		if((mask >> i) & 1)
+			stamps.stamp[i] = static_cast< long long >(get_be(in + 8 * i, 8));
+	});
+	stamps.mask |= mask;
+	size -= trailer_size;
+	return true;
+#else
+	(void)data;
+	(void)size;
+	(void)stamps;
+	return false;
+#endif
+}
+
+////////////////////////////////////////////////
+
+LatencyCollector::LatencyCollector()
+{
+	reset();
+}
+
+void LatencyCollector::reset()
+{
+	FOREACH(s, stages + 1, {
+		FOREACH(b, buckets, m_histogram[s][b] = 0);
+		m_count[s] = 0;
+		m_max[s] = 0;
+		m_sum[s] = 0;
+	});
+}
+
+void LatencyCollector::add(const TraceStamps &stamps)
+{
+#ifdef WITH_TRACE
+	int first = -1, prev = -1;
+	for(int s = 0; s < stages; s++){
+		if(!stamps.has(static_cast< Stage >(s)))
+			continue;
+		if(prev >= 0)
+			add_value(s, stamps.stamp[s] - stamps.stamp[prev]);
+		else
+			first = s;
+		prev = s;
+	}
+	if(first == Sample && prev > first)
+		add_value(total, stamps.stamp[prev] - stamps.stamp[first]);
+#else
+	(void)stamps;
+#endif
+}
+
+long long LatencyCollector::count(int stage) const
+{
+	return m_count[stage];
+}
+
+double LatencyCollector::mean(int stage) const
+{
+	return m_count[stage]? m_sum[stage] / m_count[stage] : 0;
+}
+
+long long LatencyCollector::max(int stage) const
+{
+	return m_max[stage];
+}
+
+long long LatencyCollector::percentile(int stage, double p) const
+{
+	if(!m_count[stage])
+		return 0;
+	long long need = static_cast< long long >(p * m_count[stage]);
+	if(need < 1)
+		need = 1;
+	long long acc = 0;
+	for(int b = 0; b < buckets; b++){
+		acc += m_histogram[stage][b];
+		if(acc >= need){
+			long long res = bucket_upper(b);
+			return res < m_max[stage]? res : m_max[stage];
+		}
+	}
+	return m_max[stage];
+}
+
+const char *LatencyCollector::name(int stage)
+{
+	static const char* names[stages + 1] = {
+		"sample", "encode", "enqueue", "send", "receive", "decode", "total"
+	};
+	return stage >= 0 && stage <= stages? names[stage] : "";
+}
+
+void LatencyCollector::add_value(int stage, long long ns)
+{
+	if(ns < 0)
+		ns = 0;
+	m_histogram[stage][bucket_of(ns)]++;
+	m_count[stage]++;
+	m_sum[stage] += ns;
+	if(ns > m_max[stage])
+		m_max[stage] = ns;
+}
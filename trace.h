@@ -0,0 +1,151 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <vector>
+#include <stddef.h>
+
+/// the stamps are recorded only with WITH_TRACE (DEFINES += WITH_TRACE),
+/// otherwise all calls are empty and the frames are not changed.
+/// the stages are marked by LoadGenerator (Sample, Encode, Enqueue),
+/// ReplayEngine (Sample - the scheduled time, Send), FrameStream (Encode, Send,
+/// Receive, Decode), IngestServer (Receive, Decode - IngestRecord::stamps)
+/// and wire::encode/decode with the stamps
+
+namespace trace{
+
+#ifdef WITH_TRACE
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+/**
+ * @brief The Stage enum
+ * stages of the pipeline from the sensor to the decoded frame
+ */
+enum Stage{
+	Sample,			/// data read from mpu6050
+	Encode,			/// write_to finished
+	Enqueue,		/// frame put to the send queue
+	Send,			/// frame passed to the socket
+	Receive,		/// frame read from the socket
+	Decode,			/// read_from finished
+	stages
+};
+
+/**
+ * @brief now_ns
+ * monotonic clock, common for the processes of one host
+ * @return
+ */
+long long now_ns();
+
+/**
+ * @brief The TraceStamps struct
+ * times of the stages of one frame
+ */
+struct TraceStamps{
+	TraceStamps();
+
+	inline void mark(Stage stage){
+#ifdef WITH_TRACE
+		stamp[stage] = now_ns();
+		mask |= 1 << stage;
+#else
+		(void)stage;
+#endif
+	}
+	/**
+	 * @brief set
+	 * the stage happened at ns (trace::now_ns clock)
+	 * @param stage
+	 * @param ns
+	 */
+	inline void set(Stage stage, long long ns){
+#ifdef WITH_TRACE
+		stamp[stage] = ns;
+		mask |= 1 << stage;
+#else
+		(void)stage;
+		(void)ns;
+#endif
+	}
+	inline bool has(Stage stage) const{
+		return (mask >> stage) & 1;
+	}
+
+	long long stamp[stages];
+	unsigned mask;
+};
+
+enum{
+	trailer_size = stages * 8 + 1 + 4		/// stamps, mask, magic
+};
+
+/**
+ * @brief append
+ * add the stamps to the end of the encoded frame. read_from ignores the
+ * trailing bytes, so the receivers without tracing still decode the frame
+ * @param frame
+ * @param stamps
+ */
+void append(std::vector< char >& frame, const TraceStamps& stamps);
+/**
+ * @brief strip
+ * take the stamps from the end of the received frame. the stages already
+ * marked by the receiver (Receive) are kept
+ * @param data
+ * @param size - reduced by the trailer if it is found
+ * @param stamps
+ * @return false if the frame has no stamps
+ */
+bool strip(const char* data, size_t& size, TraceStamps& stamps);
+
+//////////////////////////////////////////////////
+/// \brief The LatencyCollector class
+/// distributions of the time spent in every stage (from the previous marked
+/// stage) and of the whole path from Sample to the last stage.
+/// histograms have 8 buckets per power of two (error < 12.5%)
+class LatencyCollector{
+public:
+	enum{
+		sub_buckets = 8,
+		buckets = 62 * sub_buckets,
+		total = stages				/// index of the whole path
+	};
+
+	LatencyCollector();
+
+	void reset();
+	void add(const TraceStamps& stamps);
+
+	/**
+	 * @brief count
+	 * @param stage - Stage or total
+	 * @return
+	 */
+	long long count(int stage) const;
+	double mean(int stage) const;
+	long long max(int stage) const;
+	/**
+	 * @brief percentile
+	 * @param stage - Stage or total
+	 * @param p - [0; 1]
+	 * @return ns, upper bound of the bucket
+	 */
+	long long percentile(int stage, double p) const;
+
+	static const char* name(int stage);
+
+private:
+	long long m_histogram[stages + 1][buckets];
+	long long m_count[stages + 1];
+	long long m_max[stages + 1];
+	double m_sum[stages + 1];
+
+	void add_value(int stage, long long ns);
+};
+
+}
+
+#endif // TRACE_H
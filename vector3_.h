@@ -1,7 +1,10 @@
 #ifndef VECTOR3_
 #define VECTOR3_
 
+#include <type_traits>
+
 #include "common_.h"
+#include "precision.h"
 
 #ifdef WITHOUT_QT
 #include <string>
@@ -17,86 +20,86 @@ struct Vector3_{
 	enum{
 		count = 3
 	};
-	Vector3_(){
-		FOREACH(i, count, data[i] = 0);
+	constexpr Vector3_(): data{0, 0, 0}{
 	}
-	Vector3_(T x, T y, T z){
-		data[0] = x;
-		data[1] = y;
-		data[2] = z;
-	}
-	Vector3_(const Vector3_& v){
-		FOREACH(i, count, data[i] = v.data[i];);
+	constexpr Vector3_(T x, T y, T z): data{x, y, z}{
 	}
+	/// copy constructor and assignment are left implicit so the type stays trivially copyable
 	template< typename P >
-	Vector3_(const Vector3_<P> &v)
+	constexpr Vector3_(const Vector3_<P> &v)
+		: data{static_cast< T >(v.data[0]), static_cast< T >(v.data[1]), static_cast< T >(v.data[2])}
 	{
-		FOREACH(i, count, data[i] = static_cast< T > (v.data[i]));
 	}
 
-	inline const T& x() const { return data[0]; }
-	inline const T& y() const { return data[1]; }
-	inline const T& z() const { return data[2]; }
-	inline T& x() { return data[0]; }
-	inline T& y() { return data[1]; }
-	inline T& z() { return data[2]; }
-	inline void setX(T value) { data[0] = value; }
-	inline void setY(T value) { data[1] = value; }
-	inline void setZ(T value) { data[2] = value; }
+	constexpr inline const T& x() const { return data[0]; }
+	constexpr inline const T& y() const { return data[1]; }
+	constexpr inline const T& z() const { return data[2]; }
+	constexpr inline T& x() { return data[0]; }
+	constexpr inline T& y() { return data[1]; }
+	constexpr inline T& z() { return data[2]; }
+	constexpr inline void setX(T value) { data[0] = value; }
+	constexpr inline void setY(T value) { data[1] = value; }
+	constexpr inline void setZ(T value) { data[2] = value; }
 
-	inline bool isNull() const{
+	constexpr inline bool isNull() const{
 		T res = 0;
 		FOREACH(i, count, res += data[i] * data[i]);
 		return res < common_::epsilon;
 	}
-	inline Vector3_& operator*= (T value){
+	constexpr inline Vector3_& operator*= (T value){
 		FOREACH(i, count, data[i] *= value);
 		return *this;
 	}
-	inline Vector3_& operator+= (const Vector3_& v){
+	constexpr inline Vector3_& operator+= (const Vector3_& v){
 		FOREACH(i, count, data[i] += v.data[i]);
 		return *this;
 	}
-	inline Vector3_& operator-= (const Vector3_& v){
+	constexpr inline Vector3_& operator-= (const Vector3_& v){
 		FOREACH(i, count, data[i] -= v.data[i]);
 		return *this;
 	}
-	inline T& operator[] (int index){
+	constexpr inline T& operator[] (int index){
 		ASSERT_EC(index >=0 && index < count, "index out of range");
 		return data[index];
 	}
-	inline void clear(){
+	constexpr inline void clear(){
 		FOREACH(i, count, data[i] = 0);
 	}
-	inline T& operator[] (int index) const{
+	constexpr inline const T& operator[] (int index) const{
 		ASSERT_EC(index >=0 && index < count, "index out of range");
 		return data[index];
 	}
-	inline double length() const{
+	constexpr inline double length() const{
 		double res = 0;
 		FOREACH(i, count, res += data[i] * data[i]);
-		return sqrt(res);
+		return common_::cx_sqrt(res);
 	}
-	inline double length_square() const{
+	constexpr inline double length_square() const{
 		double res = 0;
 		FOREACH(i, count, res += data[i] * data[i]);
 		return res;
 	}
-	inline Vector3_ normalize(){
-		double res = length();
-		double rabs = fabs(res);
-		if(rabs < 1e-7)
+	/**
+	 * @brief normalize
+	 * P - precision policy (precision::Exact or precision::Fast)
+	 * @return
+	 */
+	template< typename P = precision::Exact >
+	constexpr inline Vector3_ normalize(){
+		double res = length_square();
+		if(res < 1e-14)
 			return *this;
-		res = 1.0 / res;
+		res = P::rsqrt(res);
 		FOREACH(i, count, data[i] *= res);
 		return *this;
 	}
-	inline Vector3_ normalized() const{
+	template< typename P = precision::Exact >
+	constexpr inline Vector3_ normalized() const{
 		Vector3_ res(*this);
-		res.normalize();
+		res.template normalize< P >();
 		return res;
 	}
-	inline Vector3_ inv() const{
+	constexpr inline Vector3_ inv() const{
 		return Vector3_(-x(), -y(), -z());
 	}
 #ifndef WITHOUT_QT
@@ -110,12 +113,12 @@ struct Vector3_{
 		return stream.str();
 	}
 #endif
-	static double dot(const Vector3_& v1, const Vector3_& v2){
+	static constexpr double dot(const Vector3_& v1, const Vector3_& v2){
 		double res = 0;
 		FOREACH(i, count, res += v1.data[i] * v2.data[i]);
 		return res;
 	}
-	static Vector3_ cross(const Vector3_& v1, const Vector3_& v2){
+	static constexpr Vector3_ cross(const Vector3_& v1, const Vector3_& v2){
 		Vector3_ res;
 		res.setX(v1.y() * v2.z() - v1.z() * v2.y());
 		res.setY(v1.z() * v2.x() - v1.x() * v2.z());
@@ -134,7 +137,7 @@ struct Vector3_{
  * @return
  */
 template< typename T >
-static inline Vector3_< T > operator+ (const Vector3_< T >& v1, const Vector3_< T >& v2){
+static constexpr inline Vector3_< T > operator+ (const Vector3_< T >& v1, const Vector3_< T >& v2){
 	Vector3_< T > res;
 	FOREACH(i, Vector3_< T >::count, res.data[i] = v1.data[i] + v2.data[i]);
 	return res;
@@ -147,7 +150,7 @@ static inline Vector3_< T > operator+ (const Vector3_< T >& v1, const Vector3_<
  * @return
  */
 template< typename T >
-static inline Vector3_< T > operator- (const Vector3_< T >& v1, const Vector3_< T >& v2){
+static constexpr inline Vector3_< T > operator- (const Vector3_< T >& v1, const Vector3_< T >& v2){
 	Vector3_< T > res;
 	FOREACH(i, Vector3_< T >::count, res.data[i] = v1.data[i] - v2.data[i]);
 	return res;
@@ -161,7 +164,7 @@ static inline Vector3_< T > operator- (const Vector3_< T >& v1, const Vector3_<
  * @return
  */
 template< typename T >
-static inline Vector3_< T > operator* (const Vector3_< T >& v, T d){
+static constexpr inline Vector3_< T > operator* (const Vector3_< T >& v, T d){
 	Vector3_< T > res;
 	FOREACH(i, Vector3_< T >::count, res.data[i] = v.data[i] * d);
 	return res;
@@ -175,7 +178,7 @@ static inline Vector3_< T > operator* (const Vector3_< T >& v, T d){
  * @return
  */
 template< typename T >
-static inline Vector3_< T > operator* (const Vector3_< T >& v1, const Vector3_< T >& v2){
+static constexpr inline Vector3_< T > operator* (const Vector3_< T >& v1, const Vector3_< T >& v2){
 	Vector3_< T > res;
 	FOREACH(i, Vector3_< T >::count, res.data[i] = v1.data[i] * v2.data[i]);
 	return res;
@@ -186,6 +189,12 @@ typedef Vector3_< float > Vector3f;
 typedef Vector3_< double > Vector3d;
 typedef Vector3_< int > Vector3i;
 
+static_assert(std::is_trivially_copyable< Vector3f >::value, "Vector3f must be trivially copyable");
+static_assert(std::is_trivially_copyable< Vector3d >::value, "Vector3d must be trivially copyable");
+static_assert(std::is_trivially_copyable< Vector3i >::value, "Vector3i must be trivially copyable");
+static_assert(Vector3d(1, 2, 3).y() == 2, "Vector3d must be usable in constant expressions");
+static_assert(sizeof(Vector3d) == 3 * sizeof(double), "Vector3d must have no padding");
+
 }
 
 #endif // VECTOR3_
@@ -0,0 +1,390 @@
+#ifndef VIBRATION_H
+#define VIBRATION_H
+
+#include <math.h>
+#include <stddef.h>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "common_.h"
+#include "vector3_.h"
+#include "struct_controls.h"
+
+namespace vibration{
+
+//////////////////////////////////////////////////
+/// \brief The Fft_ class
+/// radix-2 fft of the real signal with N samples (power of two).
+/// the signal is packed to the complex fft of N/2 points, which works on
+/// separate arrays of the real and imaginary parts, so the butterflies of
+/// the stages wider than 4 use sse
+template< int N >
+class Fft_{
+public:
+	static_assert(N >= 8 && (N & (N - 1)) == 0, "size of the fft must be a power of two");
+
+	enum{
+		size = N,
+		bins = N / 2 + 1,		/// 0 .. nyquist
+		M = N / 2				/// size of the complex fft
+	};
+
+	Fft_(){
+		int bits = 0;
+		while((1 << bits) < M)
+			bits++;
+		for(int i = 0; i < M; i++){
+			int r = 0;
+			FOREACH(b, bits, r |= ((i >> b) & 1) << (bits - 1 - b));
+			m_rev[i] = r;
+		}
+		/// twiddles of the stage with the half h are at [h; 2h)
+		m_tw_re[0] = 1;
+		m_tw_im[0] = 0;
+		for(int h = 1; h < M; h *= 2){
+			for(int k = 0; k < h; k++){
+				double a = -M_PI * k / h;
+				m_tw_re[h + k] = static_cast< float >(cos(a));
+				m_tw_im[h + k] = static_cast< float >(sin(a));
+			}
+		}
+		for(int k = 0; k < M; k++){
+			double a = -2 * M_PI * k / N;
+			m_split_re[k] = static_cast< float >(cos(a));
+			m_split_im[k] = static_cast< float >(sin(a));
+		}
+	}
+
+	/**
+	 * @brief forward
+	 * spectrum of the real signal
+	 * @param in - N samples
+	 * @param re - bins
+	 * @param im - bins
+	 */
+	void forward(const float* in, float* re, float* im){
+		for(int n = 0; n < M; n++){
+			m_re[m_rev[n]] = in[2 * n];
+			m_im[m_rev[n]] = in[2 * n + 1];
+		}
+		transform();
+		/// X[k] = E[k] + W^k * O[k], E and O are the spectrums of the even and odd samples
+		for(int k = 0; k <= M; k++){
+			int a = k % M, b = (M - k) % M;
+			float er = 0.5f * (m_re[a] + m_re[b]);
+			float ei = 0.5f * (m_im[a] - m_im[b]);
+			float o_r = 0.5f * (m_im[a] + m_im[b]);
+			float oi = -0.5f * (m_re[a] - m_re[b]);
+			float wr = k < M? m_split_re[k] : -1;
+			float wi = k < M? m_split_im[k] : 0;
+			re[k] = er + wr * o_r - wi * oi;
+			im[k] = ei + wr * oi + wi * o_r;
+		}
+	}
+	/**
+	 * @brief power
+	 * |X[k]|^2
+	 * @param in - N samples
+	 * @param out - bins
+	 */
+	void power(const float* in, float* out){
+		float re[bins], im[bins];
+		forward(in, re, im);
+		FOREACH(k, bins, out[k] = re[k] * re[k] + im[k] * im[k]);
+	}
+
+private:
+	alignas(16) float m_re[M];
+	alignas(16) float m_im[M];
+	alignas(16) float m_tw_re[M];
+	alignas(16) float m_tw_im[M];
+	float m_split_re[M];
+	float m_split_im[M];
+	int m_rev[M];
+
+	/**
+	 * @brief transform
+	 * in-place decimation in time on the bit reversed data
+	 */
+	void transform(){
+		for(int h = 1; h < M; h *= 2){
+			const float* wr = m_tw_re + h;
+			const float* wi = m_tw_im + h;
+#ifdef __SSE__
+			if(h >= 4){
+				for(int s = 0; s < M; s += 2 * h){
+					for(int k = 0; k < h; k += 4){
+						float* ar = m_re + s + k;
+						float* ai = m_im + s + k;
+						__m128 vwr = _mm_load_ps(wr + k), vwi = _mm_load_ps(wi + k);
+						__m128 xr = _mm_load_ps(ar + h), xi = _mm_load_ps(ai + h);
+						__m128 tr = _mm_sub_ps(_mm_mul_ps(vwr, xr), _mm_mul_ps(vwi, xi));
+						__m128 ti = _mm_add_ps(_mm_mul_ps(vwr, xi), _mm_mul_ps(vwi, xr));
+						__m128 yr = _mm_load_ps(ar), yi = _mm_load_ps(ai);
+						_mm_store_ps(ar + h, _mm_sub_ps(yr, tr));
+						_mm_store_ps(ai + h, _mm_sub_ps(yi, ti));
+						_mm_store_ps(ar, _mm_add_ps(yr, tr));
+						_mm_store_ps(ai, _mm_add_ps(yi, ti));
+					}
+				}
+				continue;
+			}
+#endif
+			for(int s = 0; s < M; s += 2 * h){
+				for(int k = 0; k < h; k++){
+					float* ar = m_re + s + k;
+					float* ai = m_im + s + k;
+					float tr = wr[k] * ar[h] - wi[k] * ai[h];
+					float ti = wr[k] * ai[h] + wi[k] * ar[h];
+					ar[h] = ar[0] - tr;
+					ai[h] = ai[0] - ti;
+					ar[0] += tr;
+					ai[0] += ti;
+				}
+			}
+		}
+	}
+};
+
+/**
+ * @brief The Channel enum
+ * axes analyzed by VibrationAnalyzer_
+ */
+enum Channel{
+	AccelX,
+	AccelY,
+	AccelZ,
+	GyroX,
+	GyroY,
+	GyroZ,
+	channels
+};
+
+/**
+ * @brief The Peak struct
+ */
+struct Peak{
+	Peak(): frequency(0), amplitude(0){}
+
+	float frequency;			/// Hz, interpolated between the bins
+	float amplitude;			/// raw units of the sensor, of the sine
+};
+
+//////////////////////////////////////////////////
+/// \brief The VibrationAnalyzer_ class
+/// spectrum of the accelerometer and gyroscope axes over sliding hann windows
+/// of N samples with the step hop. samples are written twice to the ring of 2N,
+/// so the last window is always contiguous and nothing is shifted; the fft is
+/// computed once per hop samples and the spectrums are averaged exponentially.
+/// the spectrum is in the mean square units: the sum over the band is the
+/// variance of the signal in the band
+template< int N, int hop = N / 2 >
+class VibrationAnalyzer_{
+public:
+	static_assert(hop > 0 && hop <= N, "hop must be in (0; N]");
+
+	enum{
+		size = N,
+		bins = Fft_< N >::bins
+	};
+
+	/**
+	 * @brief VibrationAnalyzer_
+	 * @param sample_rate - Hz
+	 * @param averaging - weight of the new spectrum, 1 - no averaging
+	 */
+	VibrationAnalyzer_(float sample_rate = sc::default_freq, float averaging = 0.25f){
+		double sum = 0, sum2 = 0;
+		for(int i = 0; i < N; i++){
+			double w = 0.5 - 0.5 * cos(2 * M_PI * i / N);
+			m_window[i] = static_cast< float >(w);
+			sum += w;
+			sum2 += w * w;
+		}
+		m_scale = static_cast< float >(1.0 / (N * sum2));
+		/// amplitude of the sine from the mean square in its bin
+		m_amplitude = static_cast< float >(2 * sqrt(N * sum2 / 2) / sum);
+		set_sample_rate(sample_rate);
+		set_averaging(averaging);
+		reset();
+	}
+
+	void set_sample_rate(float sample_rate){
+		m_sample_rate = sample_rate > 0? sample_rate : sc::default_freq;
+	}
+	float sample_rate() const{
+		return m_sample_rate;
+	}
+	void set_averaging(float averaging){
+		m_averaging = averaging > 0 && averaging <= 1? averaging : 1;
+	}
+	void reset(){
+		m_pos = 0;
+		m_filled = 0;
+		m_since = 0;
+		m_spectra = 0;
+		FOREACH(c, channels, FOREACH(i, 2 * N, m_ring[c][i] = 0));
+		FOREACH(c, channels, FOREACH(k, bins, m_power[c][k] = 0));
+	}
+
+	/**
+	 * @brief push
+	 * add the sample
+	 * @param accel
+	 * @param gyro
+	 * @return true if the spectrum is updated
+	 */
+	bool push(const vector3_::Vector3i& accel, const vector3_::Vector3i& gyro){
+		float v[channels] = {
+			static_cast< float >(accel.x()), static_cast< float >(accel.y()), static_cast< float >(accel.z()),
+			static_cast< float >(gyro.x()), static_cast< float >(gyro.y()), static_cast< float >(gyro.z())
+		};
+		FOREACH(c, channels, m_ring[c][m_pos] = m_ring[c][m_pos + N] = v[c]);
+		m_pos = (m_pos + 1) % N;
+		if(m_filled < N)
+			m_filled++;
+		if(++m_since < hop || m_filled < N)
+			return false;
+		m_since = 0;
+		analyze();
+		return true;
+	}
+	/**
+	 * @brief push
+	 * add the sample; the sample rate is taken from freq of the gyroscope
+	 * @param gyroscope
+	 * @return true if the spectrum is updated
+	 */
+	bool push(const sc::StructGyroscope& gyroscope){
+		if(gyroscope.freq > 0)
+			m_sample_rate = gyroscope.freq;
+		return push(gyroscope.accel, gyroscope.gyro);
+	}
+	/**
+	 * @brief push
+	 * add the recorded samples
+	 * @param data
+	 * @param count
+	 * @return count of the computed spectrums
+	 */
+	size_t push(const sc::StructGyroscope* data, size_t count){
+		size_t res = 0;
+		for(size_t i = 0; i < count; i++)
+			res += push(data[i]);
+		return res;
+	}
+
+	/**
+	 * @brief spectra
+	 * @return count of the computed spectrums
+	 */
+	long long spectra() const{
+		return m_spectra;
+	}
+	float frequency(int bin) const{
+		return bin * m_sample_rate / N;
+	}
+	/**
+	 * @brief power
+	 * averaged spectrum of the channel
+	 * @param channel
+	 * @return bins values, mean square in the raw units
+	 */
+	const float* power(int channel) const{
+		return m_power[channel];
+	}
+	/**
+	 * @brief peak
+	 * the strongest bin above min_frequency with the parabolic interpolation
+	 * @param channel
+	 * @param min_frequency - to skip the low frequency motion
+	 * @return
+	 */
+	Peak peak(int channel, float min_frequency = 0) const{
+		Peak res;
+		const float* p = m_power[channel];
+		int from = static_cast< int >(ceil(min_frequency * N / m_sample_rate));
+		if(from < 1)
+			from = 1;
+		int best = -1;
+		for(int k = from; k < bins; k++){
+			if(best < 0 || p[k] > p[best])
+				best = k;
+		}
+		if(best < 0 || p[best] <= 0)
+			return res;
+		float delta = 0;
+		if(best > 0 && best < bins - 1){
+			float a = sqrtf(p[best - 1]), b = sqrtf(p[best]), c = sqrtf(p[best + 1]);
+			float d = a - 2 * b + c;
+			if(d < 0)
+				delta = 0.5f * (a - c) / d;
+		}
+		res.frequency = (best + delta) * m_sample_rate / N;
+		res.amplitude = m_amplitude * sqrtf(p[best]);
+		return res;
+	}
+	/**
+	 * @brief band_energy
+	 * mean square of the channel in the band [f0; f1)
+	 * @param channel
+	 * @param f0 - Hz
+	 * @param f1 - Hz
+	 * @return raw units^2
+	 */
+	float band_energy(int channel, float f0, float f1) const{
+		int k0 = static_cast< int >(ceil(f0 * N / m_sample_rate));
+		int k1 = static_cast< int >(ceil(f1 * N / m_sample_rate));
+		if(k0 < 0)
+			k0 = 0;
+		if(k1 > bins)
+			k1 = bins;
+		float res = 0;
+		for(int k = k0; k < k1; k++)
+			res += m_power[channel][k];
+		return res;
+	}
+
+private:
+	Fft_< N > m_fft;
+	float m_window[N];
+	float m_ring[channels][2 * N];
+	float m_power[channels][bins];
+	alignas(16) float m_frame[N];
+	float m_scale;
+	float m_amplitude;
+	float m_sample_rate;
+	float m_averaging;
+	int m_pos;
+	int m_filled;
+	int m_since;
+	long long m_spectra;
+
+	void analyze(){
+		float p[bins];
+		for(int c = 0; c < channels; c++){
+			/// the last N samples
+			const float* x = &m_ring[c][m_pos];
+			float mean = 0;
+			FOREACH(i, N, mean += x[i]);
+			mean /= N;
+			FOREACH(i, N, m_frame[i] = (x[i] - mean) * m_window[i]);
+			m_fft.power(m_frame, p);
+			float a = m_spectra? m_averaging : 1;
+			for(int k = 0; k < bins; k++){
+				/// one-sided: the bins except 0 and nyquist are doubled
+				float v = p[k] * m_scale * (k == 0 || k == bins - 1? 1 : 2);
+				m_power[c][k] += a * (v - m_power[c][k]);
+			}
+		}
+		m_spectra++;
+	}
+};
+
+typedef VibrationAnalyzer_< 256 > VibrationAnalyzer;
+
+}
+
+#endif // VIBRATION_H
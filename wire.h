@@ -0,0 +1,410 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <vector>
+#include <stddef.h>
+#include <string.h>
+
+#include "struct_controls.h"
+#include "trace.h"
+
+#ifndef WITHOUT_QT
+#include <QByteArray>
+#endif
+
+namespace wire{
+
+/**
+ * @brief stream_encode
+ * serialize the structure by its write_to (QDataStream or datastream)
+ * @param value - StructTelemetry, StructControls...
+ * @param out - bytes are replaced
+ */
+template< typename T >
+inline void stream_encode(const T& value, std::vector< char >& out)
+{
+	T copy(value);
+	out.clear();
+#ifdef WITHOUT_QT
+	QDataStream stream(&out);
+	copy.write_to(stream);
+#else
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	copy.write_to(stream);
+	out.assign(data.constData(), data.constData() + data.size());
+#endif
+}
+
+/**
+ * @brief encode
+ * serialize the structure by its write_to; the structures below have the native encoder
+ * @param value
+ * @param out - bytes are replaced
+ */
+template< typename T >
+inline void encode(const T& value, std::vector< char >& out)
+{
+	stream_encode(value, out);
+}
+
+/// sizes of the structures in the layout of write_to:
+/// QDataStream::Qt_4_8, BigEndian, SinglePrecision (bool and unsigned char are one byte)
+enum{
+	gyroscope_size = 4 + 3 * 4 + 3 * 4 + 1 + 1 + 4 + 8 + sc::raw_count,
+	compass_size = 1 + 8 + 3 * 4,
+	barometer_size = 8 + 4 + 4,
+	telemetry_size = gyroscope_size + compass_size + barometer_size + 1 + sc::cnt_engines * 4 + 4 * 4,
+	servo_size = 4 * 4 + 1 + 4,
+	controls_size = 1 + 4 * 4 + servo_size
+};
+
+namespace native{
+
+inline unsigned to_be(unsigned value)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return value;
+#else
+	return __builtin_bswap32(value);
+#endif
+}
+
+inline unsigned long long to_be(unsigned long long value)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return value;
+#else
+	return __builtin_bswap64(value);
+#endif
+}
+
+inline void put(char*& out, bool value)
+{
+	*out++ = value? 1 : 0;
+}
+
+inline void put(char*& out, unsigned char value)
+{
+	*out++ = static_cast< char >(value);
+}
+
+inline void put(char*& out, int value)
+{
+	unsigned v = to_be(static_cast< unsigned >(value));
+	memcpy(out, &v, 4);
+	out += 4;
+}
+
+inline void put(char*& out, float value)
+{
+	unsigned v;
+	memcpy(&v, &value, 4);
+	v = to_be(v);
+	memcpy(out, &v, 4);
+	out += 4;
+}
+
+inline void put(char*& out, long long value)
+{
+	unsigned long long v = to_be(static_cast< unsigned long long >(value));
+	memcpy(out, &v, 8);
+	out += 8;
+}
+
+inline void get(const char*& in, bool& value)
+{
+	/// as QDataStream: any non zero byte is true
+	value = *in++ != 0;
+}
+
+inline void get(const char*& in, unsigned char& value)
+{
+	value = static_cast< unsigned char >(*in++);
+}
+
+inline void get(const char*& in, int& value)
+{
+	unsigned v;
+	memcpy(&v, in, 4);
+	value = static_cast< int >(to_be(v));
+	in += 4;
+}
+
+inline void get(const char*& in, float& value)
+{
+	unsigned v;
+	memcpy(&v, in, 4);
+	v = to_be(v);
+	memcpy(&value, &v, 4);
+	in += 4;
+}
+
+inline void get(const char*& in, long long& value)
+{
+	unsigned long long v;
+	memcpy(&v, in, 8);
+	value = static_cast< long long >(to_be(v));
+	in += 8;
+}
+
+}
+
+/**
+ * @brief write
+ * the same bytes as write_to without the stream
+ * @param value
+ * @param out - at least gyroscope_size bytes
+ * @return the position after the structure
+ */
+inline char* write(const sc::StructGyroscope& value, char* out)
+{
+	native::put(out, value.temp);
+	FOREACH(i, vector3_::Vector3i::count, native::put(out, value.gyro[i]));
+	FOREACH(i, vector3_::Vector3i::count, native::put(out, value.accel[i]));
+	native::put(out, value.afs_sel);
+	native::put(out, value.fs_sel);
+	native::put(out, value.freq);
+	native::put(out, value.tick);
+	memcpy(out, value.raw, sc::raw_count);
+	return out + sc::raw_count;
+}
+
+inline char* write(const sc::StructCompass& value, char* out)
+{
+	native::put(out, value.mode);
+	native::put(out, value.tick);
+	FOREACH(i, vector3_::Vector3i::count, native::put(out, value.data[i]));
+	return out;
+}
+
+inline char* write(const sc::StructBarometer& value, char* out)
+{
+	native::put(out, value.tick);
+	native::put(out, value.data);
+	native::put(out, value.temp);
+	return out;
+}
+
+inline char* write(const sc::StructTelemetry& value, char* out)
+{
+	out = write(value.gyroscope, out);
+	out = write(value.compass, out);
+	out = write(value.barometer, out);
+	native::put(out, value.power_on);
+	FOREACH(i, sc::cnt_engines, native::put(out, value.power[i]));
+	native::put(out, value.tangaj);
+	native::put(out, value.bank);
+	native::put(out, value.course);
+	native::put(out, value.height);
+	return out;
+}
+
+inline char* write(const sc::StructServo& value, char* out)
+{
+	native::put(out, value.freq_meandr);
+	native::put(out, value.angle);
+	native::put(out, value.speed_of_change);
+	native::put(out, value.timework_ms);
+	native::put(out, value.flag_start);
+	native::put(out, value.pin);
+	return out;
+}
+
+inline char* write(const sc::StructControls& value, char* out)
+{
+	native::put(out, value.power_on);
+	native::put(out, value.throttle);
+	native::put(out, value.tangaj);
+	native::put(out, value.bank);
+	native::put(out, value.yaw);
+	return write(value.servo_ctrl, out);
+}
+
+/**
+ * @brief encode
+ * native encoder of StructTelemetry: no stream, no copy of the structure
+ * @param value
+ * @param out - bytes are replaced
+ */
+inline void encode(const sc::StructTelemetry& value, std::vector< char >& out)
+{
+	out.resize(telemetry_size);
+	write(value, &out[0]);
+}
+
+inline void encode(const sc::StructControls& value, std::vector< char >& out)
+{
+	out.resize(controls_size);
+	write(value, &out[0]);
+}
+
+/**
+ * @brief stream_decode
+ * deserialize the structure by its read_from
+ * @param data
+ * @param size
+ * @param value
+ * @return false if the data is not enough (Qt build)
+ */
+template< typename T >
+inline bool stream_decode(const char* data, size_t size, T& value)
+{
+#ifdef WITHOUT_QT
+	QDataStream stream(std::vector< char >(data, data + size));
+	value.read_from(stream);
+	return true;
+#else
+	QByteArray bytes = QByteArray::fromRawData(data, static_cast< int >(size));
+	QDataStream stream(bytes);
+	value.read_from(stream);
+	return stream.status() == QDataStream::Ok;
+#endif
+}
+
+/**
+ * @brief decode
+ * deserialize the structure by its read_from; the structures below have the native decoder
+ * @param data
+ * @param size
+ * @param value
+ * @return false if the data is not enough (Qt build)
+ */
+template< typename T >
+inline bool decode(const char* data, size_t size, T& value)
+{
+	return stream_decode(data, size, value);
+}
+
+/**
+ * @brief read
+ * the fields in the layout of write_to without the stream; the size is not checked
+ * @param in - at least gyroscope_size bytes
+ * @param value
+ * @return the position after the structure
+ */
+inline const char* read(const char* in, sc::StructGyroscope& value)
+{
+	native::get(in, value.temp);
+	FOREACH(i, vector3_::Vector3i::count, native::get(in, value.gyro[i]));
+	FOREACH(i, vector3_::Vector3i::count, native::get(in, value.accel[i]));
+	native::get(in, value.afs_sel);
+	native::get(in, value.fs_sel);
+	native::get(in, value.freq);
+	native::get(in, value.tick);
+	memcpy(value.raw, in, sc::raw_count);
+	return in + sc::raw_count;
+}
+
+inline const char* read(const char* in, sc::StructCompass& value)
+{
+	native::get(in, value.mode);
+	native::get(in, value.tick);
+	FOREACH(i, vector3_::Vector3i::count, native::get(in, value.data[i]));
+	return in;
+}
+
+inline const char* read(const char* in, sc::StructBarometer& value)
+{
+	native::get(in, value.tick);
+	native::get(in, value.data);
+	native::get(in, value.temp);
+	return in;
+}
+
+inline const char* read(const char* in, sc::StructTelemetry& value)
+{
+	in = read(in, value.gyroscope);
+	in = read(in, value.compass);
+	in = read(in, value.barometer);
+	native::get(in, value.power_on);
+	FOREACH(i, sc::cnt_engines, native::get(in, value.power[i]));
+	native::get(in, value.tangaj);
+	native::get(in, value.bank);
+	native::get(in, value.course);
+	native::get(in, value.height);
+	return in;
+}
+
+inline const char* read(const char* in, sc::StructServo& value)
+{
+	native::get(in, value.freq_meandr);
+	native::get(in, value.angle);
+	native::get(in, value.speed_of_change);
+	native::get(in, value.timework_ms);
+	native::get(in, value.flag_start);
+	native::get(in, value.pin);
+	return in;
+}
+
+inline const char* read(const char* in, sc::StructControls& value)
+{
+	native::get(in, value.power_on);
+	native::get(in, value.throttle);
+	native::get(in, value.tangaj);
+	native::get(in, value.bank);
+	native::get(in, value.yaw);
+	return read(in, value.servo_ctrl);
+}
+
+/**
+ * @brief decode
+ * native decoder of StructTelemetry from the bytes of write_to (Qt or native)
+ * @param data
+ * @param size
+ * @param value
+ * @return false if size is less than telemetry_size, value is not changed
+ */
+inline bool decode(const char* data, size_t size, sc::StructTelemetry& value)
+{
+	if(size < telemetry_size)
+		return false;
+	read(data, value);
+	return true;
+}
+
+inline bool decode(const char* data, size_t size, sc::StructControls& value)
+{
+	if(size < controls_size)
+		return false;
+	read(data, value);
+	return true;
+}
+
+/**
+ * @brief encode
+ * encode and mark trace::Encode; the stamps are appended by the sender
+ * (trace::append) when the frame is queued or sent
+ * @param value
+ * @param out - bytes are replaced
+ * @param stamps
+ */
+template< typename T >
+inline void encode(const T& value, std::vector< char >& out, trace::TraceStamps& stamps)
+{
+	encode(value, out);
+	stamps.mark(trace::Encode);
+}
+
+/**
+ * @brief decode
+ * take the stamps of the sender from the end of the frame, decode and mark trace::Decode.
+ * without WITH_TRACE it is decode(data, size, value)
+ * @param data
+ * @param size
+ * @param value
+ * @param stamps - trace::Receive is marked by the caller before
+ * @return
+ */
+template< typename T >
+inline bool decode(const char* data, size_t size, T& value, trace::TraceStamps& stamps)
+{
+	trace::strip(data, size, stamps);
+	bool res = decode(data, size, value);
+	stamps.mark(trace::Decode);
+	return res;
+}
+
+}
+
+#endif // WIRE_H
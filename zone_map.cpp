@@ -0,0 +1,408 @@
+#include "zone_map.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include "wire.h"
+
+using namespace zonemap;
+
+namespace {
+
+const unsigned magic = 0x5a4d4150;		/// "ZMAP"
+const unsigned version = 2;			/// 2: min/max tick of the block instead of first/last
+const size_t frame_header = 16;			/// tick int64, type int32, size uint32
+
+inline void put_be(std::vector< char >& out, unsigned long long value, int bytes)
+{
+	for(int i = bytes - 1; i >= 0; i--)
+		out.push_back(static_cast< char >((value >> (8 * i)) & 0xff));
+}
+
+inline unsigned long long get_be(const char* data, int bytes)
+{
+	const unsigned char* d = reinterpret_cast< const unsigned char* >(data);
+	unsigned long long res = 0;
+	for(int i = 0; i < bytes; i++)
+		res = (res << 8) | d[i];
+	return res;
+}
+
+inline unsigned float_bits(float value)
+{
+	unsigned res;
+	memcpy(&res, &value, sizeof(res));
+	return res;
+}
+
+inline float bits_float(unsigned value)
+{
+	float res;
+	memcpy(&res, &value, sizeof(res));
+	return res;
+}
+
+inline unsigned long long double_bits(double value)
+{
+	unsigned long long res;
+	memcpy(&res, &value, sizeof(res));
+	return res;
+}
+
+inline double bits_double(unsigned long long value)
+{
+	double res;
+	memcpy(&res, &value, sizeof(res));
+	return res;
+}
+
+}
+
+////////////////////////////////////////////////
+
+BlockSummary::BlockSummary()
+{
+	offset = bytes = frames = 0;
+	min_tick = max_tick = 0;
+	FOREACH(i, aggregation::fields, min[i] = max[i] = 0; sum[i] = 0);
+}
+
+RangeResult::RangeResult()
+{
+	count = 0;
+	min = max = 0;
+	sum = 0;
+}
+
+double RangeResult::mean() const
+{
+	return count? sum / count : 0;
+}
+
+std::string zonemap::index_path(const std::string &path)
+{
+	return path + ".zm";
+}
+
+////////////////////////////////////////////////
+
+ZoneMapWriter::ZoneMapWriter(size_t block_frames)
+{
+	m_block_frames = block_frames? block_frames : 1;
+	m_offset = 0;
+	m_error = false;
+}
+
+ZoneMapWriter::~ZoneMapWriter()
+{
+	if(m_file.is_open())
+		close();
+}
+
+bool ZoneMapWriter::open(const std::string &path)
+{
+	m_file.open(path.c_str(), std::ios::binary | std::ios::trunc);
+	m_path = path;
+	m_offset = 0;
+	m_error = !m_file;
+	m_block.clear();
+	m_blocks.clear();
+	m_summary = BlockSummary();
+	return !m_error;
+}
+
+bool ZoneMapWriter::write(const sc::StructTelemetry &telemetry)
+{
+	wire::encode(telemetry, m_data);
+	add_frame(telemetry.gyroscope.tick, replay::RecordedFrame::Telemetry, m_data);
+	add_summary(telemetry);
+	return !m_error;
+}
+
+bool ZoneMapWriter::write(const sc::StructControls &controls, long long tick)
+{
+	wire::encode(controls, m_data);
+	add_frame(tick, replay::RecordedFrame::Controls, m_data);
+	return !m_error;
+}
+
+bool ZoneMapWriter::write(const replay::RecordedFrame &frame)
+{
+	add_frame(frame.tick, frame.type, frame.data);
+	if(frame.type == replay::RecordedFrame::Telemetry){
+		sc::StructTelemetry telemetry;
+		if(frame.data.empty() || !wire::decode(&frame.data[0], frame.data.size(), telemetry))
+			return !m_error;
+		add_summary(telemetry);
+	}
+	return !m_error;
+}
+
+bool ZoneMapWriter::close()
+{
+	flush_block();
+	if(m_file.is_open()){
+		m_file.close();
+		m_error |= m_file.fail();
+	}
+
+	std::vector< char > out;
+	put_be(out, magic, 4);
+	put_be(out, version, 4);
+	put_be(out, aggregation::fields, 4);
+	put_be(out, m_blocks.size(), 8);
+	for(size_t i = 0; i < m_blocks.size(); i++){
+		const BlockSummary& b = m_blocks[i];
+		put_be(out, static_cast< unsigned long long >(b.offset), 8);
+		put_be(out, static_cast< unsigned long long >(b.bytes), 8);
+		put_be(out, static_cast< unsigned long long >(b.frames), 8);
+		put_be(out, static_cast< unsigned long long >(b.min_tick), 8);
+		put_be(out, static_cast< unsigned long long >(b.max_tick), 8);
+		FOREACH(f, aggregation::fields, {
+			put_be(out, float_bits(b.min[f]), 4);
+			put_be(out, float_bits(b.max[f]), 4);
+			put_be(out, double_bits(b.sum[f]), 8);
+		});
+	}
+	std::ofstream index(index_path(m_path).c_str(), std::ios::binary | std::ios::trunc);
+	index.write(&out[0], out.size());
+	m_error |= !index;
+	m_blocks.clear();
+	return !m_error;
+}
+
+bool ZoneMapWriter::build(const std::string &path, size_t block_frames)
+{
+	std::ifstream file(path.c_str(), std::ios::binary);
+	if(!file)
+		return false;
+	/// the recording is not rewritten: only the summaries and offsets are made
+	ZoneMapWriter writer(block_frames);
+	writer.m_path = path;
+
+	char header[frame_header];
+	replay::RecordedFrame frame;
+	while(file.read(header, frame_header)){
+		frame.tick = static_cast< long long >(get_be(header, 8));
+		frame.type = static_cast< int >(get_be(header + 8, 4));
+		size_t size = static_cast< size_t >(get_be(header + 12, 4));
+		if(size > replay::RecordedFrame::max_size)
+			return false;
+		frame.data.resize(size);
+		if(!frame.data.empty() && !file.read(&frame.data[0], frame.data.size()))
+			return false;
+		writer.write(frame);
+	}
+	return writer.close();
+}
+
+void ZoneMapWriter::add_frame(long long tick, int type, const std::vector<char> &data)
+{
+	put_be(m_block, static_cast< unsigned long long >(tick), 8);
+	put_be(m_block, static_cast< unsigned long long >(type), 4);
+	put_be(m_block, data.size(), 4);
+	m_block.insert(m_block.end(), data.begin(), data.end());
+}
+
+void ZoneMapWriter::add_summary(const sc::StructTelemetry &telemetry)
+{
+	float v[aggregation::fields];
+	aggregation::values(telemetry, v);
+	BlockSummary& s = m_summary;
+	long long tick = telemetry.gyroscope.tick;
+	if(!s.frames){
+		s.min_tick = s.max_tick = tick;
+		FOREACH(i, aggregation::fields, s.min[i] = s.max[i] = v[i]; s.sum[i] = 0);
+	}
+	if(tick < s.min_tick)
+		s.min_tick = tick;
+	if(tick > s.max_tick)
+		s.max_tick = tick;
+	for(int i = 0; i < aggregation::fields; i++){
+		if(v[i] < s.min[i])
+			s.min[i] = v[i];
+		if(v[i] > s.max[i])
+			s.max[i] = v[i];
+		s.sum[i] += v[i];
+	}
+	if(++s.frames >= static_cast< long long >(m_block_frames))
+		flush_block();
+}
+
+void ZoneMapWriter::flush_block()
+{
+	if(m_block.empty())
+		return;
+	m_summary.offset = m_offset;
+	m_summary.bytes = static_cast< long long >(m_block.size());
+	if(m_file.is_open()){
+		m_file.write(&m_block[0], m_block.size());
+		m_error |= !m_file;
+	}
+	m_offset += m_summary.bytes;
+	m_blocks.push_back(m_summary);
+	m_summary = BlockSummary();
+	m_block.clear();
+}
+
+////////////////////////////////////////////////
+
+ZoneMapReader::ZoneMapReader()
+{
+	m_decoded = 0;
+}
+
+bool ZoneMapReader::open(const std::string &path)
+{
+	m_blocks.clear();
+	m_decoded = 0;
+	if(m_file.is_open())
+		m_file.close();
+	m_file.clear();
+	m_file.open(path.c_str(), std::ios::binary | std::ios::ate);
+	if(!m_file)
+		return false;
+	long long file_size = static_cast< long long >(m_file.tellg());
+
+	std::ifstream index(index_path(path).c_str(), std::ios::binary | std::ios::ate);
+	long long index_size = static_cast< long long >(index.tellg());
+	index.seekg(0);
+	char header[20];
+	if(!index.read(header, sizeof(header)))
+		return false;
+	if(get_be(header, 4) != magic || get_be(header + 4, 4) != version
+			|| get_be(header + 8, 4) != static_cast< unsigned >(aggregation::fields))
+		return false;
+	unsigned long long count = get_be(header + 12, 8);
+
+	/// the values of the index are not trusted: nothing is allocated beyond the sizes of the files
+	const size_t record = 5 * 8 + aggregation::fields * 16;
+	if(count > static_cast< unsigned long long >(index_size - sizeof(header)) / record)
+		return false;
+	std::vector< char > data(record);
+	m_blocks.resize(static_cast< size_t >(count));
+	for(size_t i = 0; i < count; i++){
+		if(!index.read(&data[0], record)){
+			m_blocks.clear();
+			return false;
+		}
+		BlockSummary& b = m_blocks[i];
+		const char* d = &data[0];
+		b.offset = static_cast< long long >(get_be(d, 8));
+		b.bytes = static_cast< long long >(get_be(d + 8, 8));
+		b.frames = static_cast< long long >(get_be(d + 16, 8));
+		b.min_tick = static_cast< long long >(get_be(d + 24, 8));
+		b.max_tick = static_cast< long long >(get_be(d + 32, 8));
+		/// the block is inside the recording and every frame has its header
+		if(b.offset < 0 || b.bytes < 0 || b.bytes > file_size || b.offset > file_size - b.bytes
+				|| b.frames < 0 || b.frames > b.bytes / static_cast< long long >(frame_header)
+				|| b.min_tick > b.max_tick){
+			m_blocks.clear();
+			return false;
+		}
+		d += 40;
+		FOREACH(f, aggregation::fields, {
+			b.min[f] = bits_float(static_cast< unsigned >(get_be(d, 4)));
+			b.max[f] = bits_float(static_cast< unsigned >(get_be(d + 4, 4)));
+			b.sum[f] = bits_double(get_be(d + 8, 8));
+			d += 16;
+		});
+	}
+	return true;
+}
+
+size_t ZoneMapReader::blocks() const
+{
+	return m_blocks.size();
+}
+
+const BlockSummary &ZoneMapReader::block(size_t index) const
+{
+	return m_blocks[index];
+}
+
+bool ZoneMapReader::read_block(size_t index, std::vector<sc::StructTelemetry> &telemetry)
+{
+	const BlockSummary& b = m_blocks[index];
+	telemetry.resize(static_cast< size_t >(b.frames));
+	m_buffer.resize(static_cast< size_t >(b.bytes));
+	m_file.clear();
+	m_file.seekg(b.offset);
+	if(b.bytes && !m_file.read(&m_buffer[0], b.bytes))
+		return false;
+	m_decoded++;
+
+	size_t pos = 0, n = 0;
+	while(pos + frame_header <= m_buffer.size()){
+		const char* h = &m_buffer[pos];
+		int type = static_cast< int >(get_be(h + 8, 4));
+		size_t size = static_cast< size_t >(get_be(h + 12, 4));
+		if(pos + frame_header + size > m_buffer.size())
+			return false;
+		/// the frames not decoded by the writer are not in the summary either
+		if(type == replay::RecordedFrame::Telemetry && n < telemetry.size()
+				&& wire::decode(h + frame_header, size, telemetry[n]))
+			n++;
+		pos += frame_header + size;
+	}
+	telemetry.resize(n);
+	return true;
+}
+
+RangeResult ZoneMapReader::aggregate(int field, long long tick_from, long long tick_to)
+{
+	RangeResult res;
+	float v[aggregation::fields];
+	for(size_t i = 0; i < m_blocks.size(); i++){
+		const BlockSummary& b = m_blocks[i];
+		if(!b.frames || b.max_tick < tick_from || b.min_tick > tick_to)
+			continue;
+		if(b.min_tick >= tick_from && b.max_tick <= tick_to){
+			res.min = res.count? std::min(res.min, b.min[field]) : b.min[field];
+			res.max = res.count? std::max(res.max, b.max[field]) : b.max[field];
+			res.sum += b.sum[field];
+			res.count += b.frames;
+			continue;
+		}
+		if(!read_block(i, m_telemetry))
+			continue;
+		for(size_t j = 0; j < m_telemetry.size(); j++){
+			long long tick = m_telemetry[j].gyroscope.tick;
+			if(tick < tick_from || tick > tick_to)
+				continue;
+			aggregation::values(m_telemetry[j], v);
+			res.min = res.count? std::min(res.min, v[field]) : v[field];
+			res.max = res.count? std::max(res.max, v[field]) : v[field];
+			res.sum += v[field];
+			res.count++;
+		}
+	}
+	return res;
+}
+
+bool ZoneMapReader::first_above(int field, float threshold, long long &tick, long long tick_from)
+{
+	float v[aggregation::fields];
+	for(size_t i = 0; i < m_blocks.size(); i++){
+		const BlockSummary& b = m_blocks[i];
+		if(!b.frames || b.max_tick < tick_from || b.max[field] <= threshold)
+			continue;
+		if(!read_block(i, m_telemetry))
+			continue;
+		for(size_t j = 0; j < m_telemetry.size(); j++){
+			if(m_telemetry[j].gyroscope.tick < tick_from)
+				continue;
+			aggregation::values(m_telemetry[j], v);
+			if(v[field] > threshold){
+				tick = m_telemetry[j].gyroscope.tick;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+long long ZoneMapReader::decoded_blocks() const
+{
+	return m_decoded;
+}
@@ -0,0 +1,173 @@
+#ifndef ZONE_MAP_H
+#define ZONE_MAP_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <stddef.h>
+
+#include "struct_controls.h"
+#include "aggregation.h"
+#include "replay.h"
+
+namespace zonemap{
+
+/**
+ * @brief The BlockSummary struct
+ * summary of the telemetry frames of one block of the recording
+ */
+struct BlockSummary{
+	BlockSummary();
+
+	long long offset;					/// position of the block in the recording
+	long long bytes;
+	long long frames;					/// telemetry frames in the block
+	long long min_tick;					/// of the telemetry, the ticks may go back in the block
+	long long max_tick;
+	float min[aggregation::fields];
+	float max[aggregation::fields];
+	double sum[aggregation::fields];
+};
+
+/**
+ * @brief The RangeResult struct
+ * result of the aggregation over the range of ticks
+ */
+struct RangeResult{
+	RangeResult();
+
+	double mean() const;
+
+	long long count;
+	float min;
+	float max;
+	double sum;
+};
+
+/**
+ * @brief index_path
+ * the summaries are stored near the recording: path + ".zm"
+ * @param path
+ * @return
+ */
+std::string index_path(const std::string& path);
+
+//////////////////////////////////////////////////
+/// \brief The ZoneMapWriter class
+/// writes the recording in the format of ReplayEngine::save and the
+/// summaries of every block_frames telemetry frames to index_path()
+class ZoneMapWriter{
+public:
+	ZoneMapWriter(size_t block_frames = 4096);
+	~ZoneMapWriter();
+
+	bool open(const std::string& path);
+	bool write(const sc::StructTelemetry& telemetry);
+	bool write(const sc::StructControls& controls, long long tick);
+	/**
+	 * @brief write
+	 * the encoded frame; telemetry frames are decoded for the summary
+	 * @param frame
+	 * @return
+	 */
+	bool write(const replay::RecordedFrame& frame);
+	/**
+	 * @brief close
+	 * write the last block and the index
+	 * @return false on the error of the files
+	 */
+	bool close();
+
+	/**
+	 * @brief build
+	 * make the index for the existing recording
+	 * @param path
+	 * @param block_frames
+	 * @return
+	 */
+	static bool build(const std::string& path, size_t block_frames = 4096);
+
+private:
+	size_t m_block_frames;
+	std::string m_path;
+	std::ofstream m_file;
+	std::vector< char > m_block;
+	std::vector< char > m_data;
+	BlockSummary m_summary;
+	std::vector< BlockSummary > m_blocks;
+	long long m_offset;
+	bool m_error;
+
+	void add_frame(long long tick, int type, const std::vector< char >& data);
+	void add_summary(const sc::StructTelemetry& telemetry);
+	void flush_block();
+};
+
+//////////////////////////////////////////////////
+/// \brief The ZoneMapReader class
+/// queries over the ticks of the recording. the blocks are skipped by their
+/// min/max, the blocks lying inside the range are taken from the summaries
+/// and only the boundary blocks are read and decoded.
+/// the ticks of the telemetry may go back (a restarted clock, merged recordings):
+/// the blocks are selected by their min/max tick, not by their order
+class ZoneMapReader{
+public:
+	ZoneMapReader();
+
+	/**
+	 * @brief open
+	 * @param path - the recording; its index must exist (see ZoneMapWriter::build)
+	 * @return false if the index is damaged or does not match the size of the recording
+	 */
+	bool open(const std::string& path);
+
+	size_t blocks() const;
+	const BlockSummary& block(size_t index) const;
+	/**
+	 * @brief read_block
+	 * decode the telemetry of the block
+	 * @param index
+	 * @param telemetry
+	 * @return false on the error of the file
+	 */
+	bool read_block(size_t index, std::vector< sc::StructTelemetry >& telemetry);
+
+	/**
+	 * @brief aggregate
+	 * min/max/sum of the field over [tick_from; tick_to]
+	 * @param field - aggregation::Field
+	 * @param tick_from
+	 * @param tick_to
+	 * @return
+	 */
+	RangeResult aggregate(int field, long long tick_from, long long tick_to);
+	/**
+	 * @brief first_above
+	 * the first telemetry in the order of the recording where the field is
+	 * greater than threshold and the tick is not less than tick_from
+	 * @param field - aggregation::Field
+	 * @param threshold
+	 * @param tick - result
+	 * @param tick_from
+	 * @return false if not found
+	 */
+	bool first_above(int field, float threshold, long long& tick, long long tick_from = 0);
+
+	/**
+	 * @brief decoded_blocks
+	 * count of the blocks read by the queries
+	 * @return
+	 */
+	long long decoded_blocks() const;
+
+private:
+	std::ifstream m_file;
+	std::vector< BlockSummary > m_blocks;
+	std::vector< char > m_buffer;
+	std::vector< sc::StructTelemetry > m_telemetry;
+	long long m_decoded;
+};
+
+}
+
+#endif // ZONE_MAP_H